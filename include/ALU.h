@@ -0,0 +1,104 @@
+#pragma once
+#include <stdint.h>
+
+// CPU variants the core can be built for, selected with -DCPU_VARIANT=<variant>.
+// The NES 2A03 has the decimal flag but no BCD adder
+enum CPUVariant
+{
+    variant2A03,
+    variantNMOS,
+    variant65C02
+};
+
+#ifndef CPU_VARIANT
+#define CPU_VARIANT variant2A03
+#endif
+
+struct ALUResult
+{
+    uint8_t value;
+    bool carry;
+    bool zero;
+    bool overflow;
+    bool negative;
+};
+
+// ADC/SBC for one variant. The decimal branch is a compile-time constant on
+// the 2A03, so the NES build is left with the binary adder only
+template<CPUVariant V>
+struct ALU
+{
+    static const bool hasBCD = V != variant2A03;
+
+    static inline ALUResult adc(uint8_t a, uint8_t b, bool carry, bool decimal) {
+        if (hasBCD && decimal)
+            return adcBCD(a, b, carry);
+        return binary(a, b, carry);
+    }
+
+    static inline ALUResult sbc(uint8_t a, uint8_t b, bool carry, bool decimal) {
+        if (hasBCD && decimal)
+            return sbcBCD(a, b, carry);
+        return binary(a, b ^ 0xFF, carry);
+    }
+
+private:
+    static inline ALUResult binary(uint8_t a, uint8_t b, bool carry) {
+        unsigned sum = a + b + carry;
+        uint8_t result = sum & 0xFF;
+        ALUResult r;
+        r.value = result;
+        r.carry = sum >> 8;
+        r.zero = result == 0;
+        r.overflow = ((a ^ result) & (b ^ result) & 0x80) != 0;
+        r.negative = (result & 0x80) != 0;
+        return r;
+    }
+
+    // Nibble-wise decimal adjust, the conditions become flag arithmetic
+    // instead of branches. NMOS takes N and V from the intermediate sum
+    // before the high nibble is adjusted, and Z from the binary sum
+    static ALUResult adcBCD(uint8_t a, uint8_t b, bool carry) {
+        unsigned lo = (a & 0x0F) + (b & 0x0F) + carry;
+        unsigned loCarry = lo > 0x09;
+        lo = ((lo + loCarry * 0x06) & 0x0F) | (loCarry << 4);
+        unsigned sum = (a & 0xF0) + (b & 0xF0) + lo;
+
+        ALUResult r;
+        r.overflow = (~(a ^ b) & (a ^ sum) & 0x80) != 0;
+        r.negative = (sum & 0x80) != 0;
+        r.zero = ((a + b + carry) & 0xFF) == 0;
+
+        unsigned hiCarry = sum > 0x9F;
+        sum += hiCarry * 0x60;
+        r.value = sum & 0xFF;
+        r.carry = hiCarry;
+        if (V == variant65C02) {
+            r.negative = (r.value & 0x80) != 0;
+            r.zero = r.value == 0;
+        }
+        return r;
+    }
+
+    // Flags other than the 65C02's N and Z match the binary subtraction
+    static ALUResult sbcBCD(uint8_t a, uint8_t b, bool carry) {
+        ALUResult r = binary(a, b ^ 0xFF, carry);
+        int lo = (a & 0x0F) - (b & 0x0F) + carry - 1;
+        int borrowLo = lo < 0;
+        if (V == variant65C02) {
+            int diff = a - b + carry - 1;
+            diff -= (diff < 0) * 0x60;
+            diff -= borrowLo * 0x06;
+            r.value = diff & 0xFF;
+            r.zero = r.value == 0;
+            r.negative = (r.value & 0x80) != 0;
+        }
+        else {
+            lo = ((lo - borrowLo * 0x06) & 0x0F) - borrowLo * 0x10;
+            int diff = (a & 0xF0) - (b & 0xF0) + lo;
+            diff -= (diff < 0) * 0x60;
+            r.value = diff & 0xFF;
+        }
+        return r;
+    }
+};
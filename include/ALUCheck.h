@@ -0,0 +1,38 @@
+#pragma once
+#include <ALU.h>
+#include <stdint.h>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Exhaustive check of every ALU variant: ADC and SBC over all operand
+// pairs, both carry inputs and both decimal flag settings, compared against
+// a straightforward model of the documented NMOS/65C02 behaviour
+class ALUCheck
+{
+public:
+    bool run();
+    void report(std::ostream &out);
+
+private:
+    struct Mismatch
+    {
+        std::string variant;
+        std::string op;
+        uint8_t a;
+        uint8_t b;
+        bool carry;
+        bool decimal;
+        ALUResult expected;
+        ALUResult actual;
+    };
+
+    long checked = 0;
+    long failures = 0;
+    std::vector<Mismatch> mismatches;
+
+    template<CPUVariant V>
+    void checkVariant(const char *name);
+    void compare(const char *variant, const char *op, uint8_t a, uint8_t b, bool carry, bool decimal,
+                 const ALUResult &expected, const ALUResult &actual);
+};
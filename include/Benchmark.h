@@ -0,0 +1,72 @@
+#pragma once
+#include <MOS6502.h>
+#include <stdint.h>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Microbenchmark suite in the style of Google Benchmark: every case is
+// rerun with a growing iteration count until it takes at least minTime,
+// and the results can be written as JSON to track regressions
+class Benchmark
+{
+public:
+    Benchmark(const std::string &romDir, double minTime = 0.1);
+
+    // Cases whose name doesn't contain filter are skipped
+    void run(const std::string &filter = "");
+    void report(std::ostream &out);
+    void writeJSON(std::ostream &out);
+
+private:
+    struct Result
+    {
+        std::string name;
+        long iterations;
+        double seconds;
+        double itemsPerIteration;
+        // User counters, reported next to the timings
+        std::vector<std::pair<std::string, double>> counters;
+    };
+
+    enum Trace
+    {
+        traceNone,
+        traceLog, // text CPU log
+        traceBus  // per-cycle bus log
+    };
+
+    std::string romDir;
+    double minTime;
+    std::string filter;
+    std::vector<Result> results;
+
+    uint8_t memory[0x10000];
+    uint8_t image[0x10000];
+
+    // body(iterations) runs the case and returns the number of items processed
+    template<typename Body>
+    void measure(const std::string &name, Body body);
+
+    void opcodes();
+    void addressingModes();
+    void wholeROM(const std::string &name, const std::string &file, uint16_t start, Trace trace);
+    void frames(const std::string &name, const std::string &file, bool profile);
+    void saveState(const std::string &file);
+    void stateHash(const std::string &file);
+    void stepMany(const std::string &file);
+    void observation(const std::string &file);
+    void runAhead(const std::string &file);
+    void fusion(const std::string &file);
+    void idleSkip(const std::string &file);
+    void disassemble(const std::string &name, const std::string &file);
+    void disassembleCoverage(const std::string &name, const std::string &file);
+    void movie(const std::string &file);
+    void rendering(const std::string &file);
+    void renderSkip(const std::string &file);
+    void lineReuse(const std::string &file);
+    void spriteEvaluation(const std::string &file);
+
+    long runInstructions(MOS6502 &CPU, const MOS6502::CPUState &start, long instructions);
+    static MOS6502::CPUState startState(uint16_t PC);
+};
@@ -1,20 +1,160 @@
 #pragma once
 #include <MOS6502.h>
 #include <PPUCHIP.h>
+#include <Profiler.h>
+#include <OpcodeStats.h>
+#include <Fusion.h>
+#include <Debugger.h>
+#include <Coverage.h>
+#include <StateHash.h>
+#include <Joypad.h>
+#include <RenderPipeline.h>
 #include <iostream>
 #include <fstream>
+#include <memory>
 
-class Controller
+class Controller : public MOS6502::BusHandler
 {
 public:
     Controller(std::ifstream &ROM);
     void run();
-    
+    // Reset button: CPU reset sequence, PPU registers cleared
+    void reset();
+    // Runs until the PPU starts the next frame
+    void runFrame();
+    // Runs until the next frame or until the debugger stops, true if it stopped
+    bool runFrameOrStop(Debugger &debugger);
+    void attachDebugger(Debugger &debugger);
+    void setBusAccurate(bool enabled);
+    void setLogging(bool enabled);
+    void setProfiler(Profiler *profiler);
+    void setStats(OpcodeStats *stats);
+    void setFusion(const FusionTable *table);
+    uint64_t fusedInstructions() const;
+    void setIdleSkip(bool enabled);
+    uint64_t idleCyclesSkipped() const;
+    // Joypad 0 on $4016, 1 on $4017, Joypad::Buttons bits
+    void setButtons(int port, uint8_t buttons);
+    // Frames run since power on
+    uint64_t frame() const;
+    // The 2KB of CPU RAM
+    const uint8_t *ram() const;
+    // Of RAM, CPU registers and PPU state, for replay checks
+    uint64_t checksum() const;
+    // Of the mapped PRG, identifies the ROM a movie was recorded on
+    uint64_t romChecksum() const;
+
+    // Of RAM, PRG RAM, the PPU memories and the CPU and PPU registers, for
+    // telling game states apart in a search. Timing (cycles, frame, PPU
+    // position) and joypads are left out, so a state reached again on a
+    // later frame hashes the same. O(1) while tracking: every write to the
+    // memories updates it. Debug builds check it against a full rehash
+    void setStateHashing(bool enabled);
+    uint64_t stateHash() const;
+    // Addresses left out of the hash: CPU addresses of RAM and PRG RAM, or
+    // the StateHash ones of the PPU memories
+    void maskStateHash(uint16_t first, uint16_t last, bool masked = true);
+
+    // Pixels are only produced while rendering: serially at the end of each
+    // frame, or on a render thread the CPU runs ahead of
+    enum RenderMode
+    {
+        renderOff,
+        renderSerial,
+        renderThreaded
+    };
+    void setRendering(RenderMode mode);
+    // Draw every Nth frame only, 0 for only the frames asked for with
+    // requestFrame(). Skipped frames cost no pixel work, everything the CPU
+    // sees (vblank, sprite 0 hit) is kept without the renderer
+    void setRenderSkip(int every);
+    void requestFrame();
+    // Redraw only the lines whose inputs changed, optionally checking the
+    // reused ones against a full redraw
+    void setLineReuse(bool enabled, bool verify = false);
+    PPURenderer::Stats renderStats();
+    // Colour indices of the last rendered frame, PPURenderer::WIDTH by
+    // HEIGHT, null while not rendering. Waits for the render thread
+    const uint8_t *framePixels();
+    // Of every frame rendered since rendering started, waits as well
+    uint64_t renderChecksum();
+
+    // Plain data, only meaningful to the same build running the same ROM.
+    // Rendering restarts from the loaded PPU, so states saved between
+    // frames render exactly as the original run did
+    struct SaveState
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t rom;
+        MOS6502::Snapshot CPU;
+        PPUCHIP::State PPU;
+        Joypad joypads[2];
+        uint8_t RAM[0x800];
+        uint8_t PRGRAM[0x2000];
+        // Tracked state hash, and the mask it was taken under, 0 untracked
+        uint64_t stateHash;
+        uint64_t stateHashMask;
+    };
+    void saveState(SaveState &state) const;
+    // False, and nothing loaded, for another version or ROM
+    bool loadState(const SaveState &state);
+
+    // Sized from romInfo(): PRGSize and CHRSize
+    void setCoverage(Coverage *coverage);
+
+    struct ROMInfo
+    {
+        bool iNES = false;
+        int mapper = 0;
+        int PRGSize = 0;
+        int CHRSize = 0;
+        bool verticalMirroring = false;
+    };
+    // Loads an iNES image (NROM layout) or a raw 16KB binary at $0000
+    static ROMInfo loadROM(std::ifstream &ROM, uint8_t (&memory)[0x10000]);
+    const ROMInfo &romInfo() const;
+
+    uint8_t ioRead(uint16_t addr) override;
+    void ioWrite(uint16_t addr, uint8_t value) override;
+    bool idempotentRead(uint16_t addr) override;
+    uint8_t peek(uint16_t addr) override;
+    void poke(uint16_t addr, uint8_t value) override;
+
 private:
-    const int ROMADDR = 0x8000;
+    static const int ROMADDR = 0x8000;
+    static const uint16_t OAMDMA = 0x4014;
+    static const uint16_t JOYPAD1 = 0x4016;
+    static const uint16_t JOYPAD2 = 0x4017;
+    // Upper bits of joypad reads are open bus, the high byte of the address
+    static const uint8_t JOYPADOPENBUS = 0x40;
+    static const int MAXINSTRUCTIONCYCLES = 7;
+    static const uint16_t PRGRAMADDR = 0x6000;
+    static const uint32_t STATEMAGIC = 0x1A53454E; // "NES\x1A"
+    static const uint32_t STATEVERSION = 2;
 
-    uint8_t memory[0xFFFF];
+    uint8_t memory[0x10000] = {};
+    ROMInfo info;
+    uint64_t romHash = 0;
 
     MOS6502 CPU;
     PPUCHIP PPU;
-};
\ No newline at end of file
+    Joypad joypads[2];
+    bool fusion = false;
+    bool idleSkip = false;
+    std::unique_ptr<RenderPipeline> renderer;
+    uint64_t renderFrame = 0;
+    int renderEvery = 1;
+    bool lineReuse = false;
+    bool reuseCheck = false;
+    PPUInputs restartInputs;
+    // PPU register accesses can move the next PPU event
+    bool deadlineStale = true;
+    StateHash tracked;
+    bool stateHashing = false;
+
+    void mapNES();
+    void step();
+    // Memories into hash from scratch
+    void rehash(StateHash &hash) const;
+};
@@ -0,0 +1,99 @@
+#pragma once
+#include <OpcodeInfo.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <iostream>
+#include <vector>
+
+// Code/data log in the FCEUX .cdl layout: one flag byte per PRG ROM byte,
+// then one per CHR ROM byte. The CPU marks instruction bytes at every
+// boundary and data reads on the PRG pages; the PPU marks CHR reads through
+// PPUDATA. chrDrawn isn't taken from the renderer's fetches but estimated
+// at each vblank: every tile both nametables reference and those of every
+// sprite in range, scrolled on screen or not, so it over-approximates the
+// tiles drawn, and misses ones only shown under mid-frame PPUCTRL or
+// nametable changes. Logs of the same ROM merge by OR-ing the flags
+class Coverage
+{
+public:
+    enum PRGFlags
+    {
+        prgCode = 0x01,
+        prgData = 0x02,
+        prgBank = 0x0C, // which 8KB CPU window ($8000/$A000/$C000/$E000) it was accessed through
+        prgIndirectCode = 0x10, // target of JMP (ind)
+        prgIndirectData = 0x20  // read through (zp,X) or (zp),Y
+    };
+
+    enum CHRFlags
+    {
+        chrDrawn = 0x01,
+        chrRead = 0x02 // read by the CPU through PPUDATA
+    };
+
+    // PRG is mapped from $8000 and mirrored when smaller than 32KB, only
+    // the first 32KB of a larger PRG can be reached
+    Coverage(size_t PRGSize, size_t CHRSize);
+    void clear();
+
+    size_t PRGSize() const;
+    size_t CHRSize() const;
+    const uint8_t *PRG() const;
+    const uint8_t *CHR() const;
+    bool covers(uint16_t addr) const;
+
+    // Called by the CPU at every instruction boundary while attached
+    void step(uint16_t PC, const uint8_t (&memory)[0x10000])
+    {
+        uint8_t opcode = memory[PC];
+        AddrMode mode = opcodeInfo[opcode].mode;
+        current = PC;
+        currentLength = instructionLength(mode);
+        currentIndirect = mode == indirectX || mode == indirectY;
+        if (PC >= PRGBASE && !prg.empty()) {
+            uint8_t flags = prgCode | (lastOpcode == OPJMPIND ? prgIndirectCode : 0);
+            for (int i = 0; i < currentLength && PC + i <= 0xFFFF; i++)
+                mark(PC + i, flags);
+        }
+        lastOpcode = opcode;
+    }
+
+    // Called by the CPU for reads of covered pages, the fetches of the
+    // current instruction excluded
+    void read(uint16_t addr)
+    {
+        if (!prg.empty() && (uint16_t)(addr - current) >= currentLength)
+            mark(addr, prgData | (currentIndirect ? prgIndirectData : 0));
+    }
+
+    void markCHR(uint16_t addr, uint8_t flags)
+    {
+        if (addr < chr.size())
+            chr[addr] |= flags;
+    }
+
+    // False if the file doesn't match the PRG and CHR sizes
+    bool load(std::istream &in);
+    void save(std::ostream &out) const;
+    bool merge(const Coverage &other);
+    // Counts of code, data and unused PRG bytes, drawn and read CHR bytes
+    void report(std::ostream &out) const;
+
+private:
+    static const uint16_t PRGBASE = 0x8000;
+    static const uint8_t OPJMPIND = 0x6C;
+
+    std::vector<uint8_t> prg;
+    std::vector<uint8_t> chr;
+    uint16_t prgMask; // mapped PRG, at most 32KB, is a power of two
+
+    uint16_t current = 0;
+    int currentLength = 0;
+    bool currentIndirect = false;
+    uint8_t lastOpcode = 0;
+
+    void mark(uint16_t addr, uint8_t flags)
+    {
+        prg[(addr - PRGBASE) & prgMask] |= flags | (((addr >> 13) & 3) << 2);
+    }
+};
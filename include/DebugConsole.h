@@ -0,0 +1,42 @@
+#pragma once
+#include <Controller.h>
+#include <Debugger.h>
+#include <stdint.h>
+#include <iostream>
+#include <string>
+
+// Front ends for the debugger: a line command REPL, and a subset of the GDB
+// remote serial protocol on a local TCP port. Both drive the same commands,
+// the GDB side reaches the REPL ones through "monitor <command>"
+class DebugConsole
+{
+public:
+    DebugConsole(Controller &console, Debugger &debugger);
+
+    // Reads commands until "q" or the end of input. Ctrl-C pauses a running CPU
+    void repl(std::istream &in, std::ostream &out);
+    // Serves one client on 127.0.0.1:port until it detaches or disconnects.
+    // Register packets ("g"/"G") are A X Y S P PCL PCH, one byte each
+    bool serve(int port, std::ostream &log);
+
+private:
+    Controller &console;
+    Debugger &debugger;
+    int client = -1;
+    std::string input; // received but not yet parsed bytes
+
+    // False once the session should end
+    bool command(const std::string &line, std::ostream &out);
+    void help(std::ostream &out);
+    void runUntilStop();
+    void showStop(std::ostream &out);
+    void showRegisters(std::ostream &out);
+    std::string instruction(uint16_t addr);
+
+    // GDB remote serial protocol
+    bool receive(std::string &packet);
+    void send(const std::string &packet);
+    bool readClient();
+    std::string reply(const std::string &packet, bool &done);
+    std::string stopReply();
+};
@@ -0,0 +1,143 @@
+#pragma once
+#include <MOS6502.h>
+#include <stdint.h>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+// Breakpoints, watchpoints and stepping for one CPU. Breakpoints live in a
+// 64K bitmap tested at every instruction boundary while attached, and
+// watchpoints flag their pages in the CPU page table so unwatched pages
+// keep the direct memory path. A CPU without a debugger checks nothing
+class Debugger
+{
+public:
+    enum StopReason
+    {
+        stopNone,
+        stopBreakpoint,
+        stopWatchpoint,
+        stopStep,
+        stopPause
+    };
+
+    struct Stop
+    {
+        StopReason reason;
+        uint16_t PC;
+        // Watchpoints: the access that hit, the instruction has completed
+        uint16_t addr;
+        uint8_t value;
+        bool write;
+    };
+
+    // Register test for conditional breakpoints, e.g. "X >= $10"
+    struct Condition
+    {
+        enum Compare
+        {
+            equal,
+            notEqual,
+            less,
+            lessEqual,
+            greater,
+            greaterEqual
+        };
+
+        char reg; // A, X, Y, S (stack pointer) or P (status)
+        Compare compare;
+        uint8_t value;
+
+        // "A==$10", "x != 3", "S<F0"; values are hex. False if it doesn't parse
+        static bool parse(const std::string &text, Condition &condition);
+        std::string toString() const;
+    };
+
+    struct Watchpoint
+    {
+        uint16_t first;
+        uint16_t last;
+        bool read;
+        bool write;
+    };
+
+    Debugger();
+    void attach(MOS6502 &CPU, uint8_t (&memory)[0x10000]);
+    void detach();
+
+    // Breaks when every condition holds, none means always
+    void setBreakpoint(uint16_t addr, const std::vector<Condition> &conditions = {});
+    void clearBreakpoint(uint16_t addr);
+    bool hasBreakpoint(uint16_t addr) const;
+    std::vector<uint16_t> breakpointList() const;
+    const std::vector<Condition> *breakpointConditions(uint16_t addr) const;
+
+    void addWatchpoint(uint16_t first, uint16_t last, bool read, bool write);
+    // Removes every watchpoint that starts at first
+    void removeWatchpoint(uint16_t first);
+    const std::vector<Watchpoint> &watchpoints() const;
+
+    // Run until a breakpoint, watchpoint or pause
+    void resume();
+    void stepIn();
+    // A JSR runs to its return, anything else is a single step
+    void stepOver();
+    // Until the current subroutine or interrupt handler returns
+    void stepOut();
+    // Safe from a signal handler or another thread, stops at the next boundary
+    void pause();
+
+    bool stopped() const;
+    const Stop &lastStop() const;
+
+    // Inspection, I/O registers are read without side effects
+    MOS6502::CPUState registers() const;
+    void setRegisters(const MOS6502::CPUState &state);
+    uint8_t peek(uint16_t addr) const;
+    void poke(uint16_t addr, uint8_t value);
+
+    // Called by the CPU at every boundary, true stops before the instruction at PC
+    bool boundary(uint16_t PC)
+    {
+        if (!armed && !pauseRequested.load(std::memory_order_relaxed) && !(breakpoints[PC >> 3] & (1 << (PC & 7))))
+            return false;
+        return check(PC);
+    }
+
+    // Called by the CPU for every access to a watched page
+    void access(uint16_t addr, uint8_t value, bool write);
+
+    // Monitor style numbers: hex, with or without a "$" or "0x" prefix
+    static bool parseHex(const std::string &text, unsigned &value);
+
+private:
+    static const uint8_t OPJSR = 0x20;
+    static const uint8_t OPRTI = 0x40;
+    static const uint8_t OPRTS = 0x60;
+
+    MOS6502 *CPU = nullptr;
+    uint8_t (*memory)[0x10000] = nullptr;
+
+    uint8_t breakpoints[0x10000 / 8];
+    std::unordered_map<uint16_t, std::vector<Condition>> conditions;
+    std::vector<Watchpoint> watches;
+
+    // Anything that needs the slow check at every boundary
+    bool armed = false;
+    std::atomic<bool> pauseRequested{false};
+    bool isStopped = false;
+    bool skipOnce = false; // resuming from a stop must not stop at the same boundary again
+    bool stepping = false;
+    int returnSP = -1;     // stepping over or out: stop after an RTS/RTI pops above this
+    int returnPC = -1;     // and, stepping over a JSR, lands on the next instruction
+    uint8_t lastOpcode = 0;
+    bool watchHit = false;
+    Stop stop;
+
+    bool check(uint16_t PC);
+    bool conditionsHold(uint16_t PC, const MOS6502::CPUState &state) const;
+    void run();
+    void updateArmed();
+    void updatePages();
+};
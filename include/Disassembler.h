@@ -0,0 +1,81 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Disassembler driven by the opcode table. format() decodes one instruction
+// into a caller buffer without allocating, for the debugger and tracers.
+// analyse() traces a ROM image recursively from its vectors to separate code
+// from data, and writeListing() turns the result into ca65 source that
+// assembles back to the same bytes
+class Disassembler
+{
+public:
+    static const int MAXTEXT = 32;
+
+    // CDL flag bits per PRG byte, see Coverage
+    enum CoverageFlags
+    {
+        coveredCode = 0x01,
+        coveredData = 0x02
+    };
+
+    // "LDA $0200,X" into text, returns the instruction length in bytes
+    static int format(uint16_t addr, uint8_t opcode, uint8_t low, uint8_t high, char (&text)[MAXTEXT]);
+    static int format(uint16_t addr, const uint8_t (&memory)[0x10000], char (&text)[MAXTEXT]);
+
+    Disassembler();
+    // Optional coverage of [base, base + size): executed code is traced from
+    // the start of each run of it, nothing else in the range is code
+    void setCoverage(const uint8_t *flags, uint16_t base, size_t size);
+    // Traces code in [start, end] from the reset, NMI and IRQ vectors, when
+    // the range holds them, and from any extra entry points
+    void analyse(const uint8_t (&memory)[0x10000], uint16_t start = 0x8000, uint16_t end = 0xFFFF,
+                 const std::vector<uint16_t> &entries = {});
+    bool isCode(uint16_t addr) const;
+    size_t codeBytes() const;
+    // ca65 source for the analysed range, with generated labels
+    void writeListing(std::ostream &out);
+    // Assembles a listing back as ca65 would under .setcpu "6502" and
+    // compares the bytes with memory. Every symbol has to be defined, and
+    // one defined further down is assembled as absolute, as ca65 does
+    static bool verifyListing(const std::string &listing, const uint8_t (&memory)[0x10000]);
+
+private:
+    enum ByteFlags
+    {
+        byteOpcode = 0x01,
+        byteOperand = 0x02,
+        byteLabel = 0x04,
+        byteExecuted = 0x08, // from coverage
+        byteData = 0x10,     // from coverage, read and never executed
+        byteCovered = 0x40   // within the coverage range
+    };
+
+    static const uint16_t NMIVEC = 0xFFFA;
+    static const uint16_t RESETVEC = 0xFFFC;
+    static const uint16_t IRQVEC = 0xFFFE;
+    static const int BYTESPERLINE = 16;
+
+    const uint8_t *image = nullptr;
+    uint16_t start = 0;
+    uint16_t end = 0;
+    uint8_t flags[0x10000];
+    uint16_t queue[0x10000];
+    int queued = 0;
+
+    bool inRange(uint32_t addr) const;
+    // Traced from addr, entry() labels it as well
+    void entry(uint32_t addr);
+    void enqueue(uint32_t addr);
+    void trace(uint16_t addr);
+    bool decodable(uint16_t addr, int length) const;
+    uint16_t vector(uint16_t addr) const;
+    // Labels are "reset", "nmi" and "irq" at the vector targets, "Lxxxx" elsewhere
+    char *appendLabel(char *p, uint16_t addr) const;
+    // Operands use labels when symbols is set and a label starts at the target
+    static int render(uint16_t addr, uint8_t opcode, uint8_t low, uint8_t high, const Disassembler *symbols,
+                      char (&text)[MAXTEXT]);
+};
@@ -0,0 +1,32 @@
+#pragma once
+#include <OpcodeStats.h>
+#include <stdint.h>
+#include <iostream>
+
+// Opcode pairs the CPU may run as one superinstruction: the second opcode
+// is dispatched straight after the first, without the instruction boundary
+// in between (event poll, logging, the caller's PPU catch-up).
+// Only second opcodes that can't reach memory-mapped I/O are accepted, the
+// CPU checks everything else (events, I/O in the first, deadline) at runtime
+class FusionTable
+{
+public:
+    FusionTable();
+
+    // False if the pair can't be fused
+    bool add(uint8_t first, uint8_t second);
+    // The most frequent fusable pairs of a recorded workload
+    void fromStats(const OpcodeStats &stats, size_t maxPairs);
+    // Same, from the "pairs" section of a --stats JSON file
+    bool load(std::istream &statsJSON, size_t maxPairs);
+    size_t size() const;
+
+    bool fused(uint8_t first, uint8_t second) const
+    {
+        return pairs[first << 8 | second];
+    }
+
+private:
+    bool pairs[0x10000];
+    size_t count = 0;
+};
@@ -0,0 +1,28 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <cstring>
+
+// FNV-1a over 64-bit words, then bytes for the tail. Host byte order, so
+// checksums only compare between runs on the same kind of machine
+static const uint64_t HASHSEED = 0xCBF29CE484222325ULL;
+static const uint64_t HASHPRIME = 0x100000001B3ULL;
+
+inline uint64_t hashBytes(uint64_t hash, const void *data, size_t size)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, bytes + i, 8);
+        hash = (hash ^ word) * HASHPRIME;
+    }
+    for (; i < size; i++)
+        hash = (hash ^ bytes[i]) * HASHPRIME;
+    return hash;
+}
+
+inline uint64_t hashValue(uint64_t hash, uint64_t value)
+{
+    return (hash ^ value) * HASHPRIME;
+}
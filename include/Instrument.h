@@ -0,0 +1,151 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include <iostream>
+#include <vector>
+
+// Host-side instrumentation zones. Built only with -DINSTRUMENT ("make
+// instrumented"); otherwise INSTRUMENT_ZONE expands to nothing.
+// Time is exclusive: entering a zone pauses the enclosing one, so the
+// zones add up to the total time spent inside any zone
+
+enum Zone
+{
+    zoneOther, // outside of every zone
+    zoneFrame,
+    zoneCPU,
+    zonePPU,
+    zoneAPU,
+    zoneBus,
+    zoneTrace,
+    zoneRender,
+    zoneCount
+};
+
+struct ZoneStats
+{
+    const char *name;
+    uint64_t ticks;
+    uint64_t calls;
+};
+
+namespace Instrument
+{
+    bool enabled();
+    // Merged over every thread that has entered a zone, since the last reset
+    std::vector<ZoneStats> stats();
+    // Takes the current totals as the new baseline, no thread's counters
+    // are written but its own
+    void reset();
+    double ticksPerSecond();
+    // One line, "cpu 61.2% ppu 20.3% ...", of the time since the last reset
+    void summary(std::ostream &out);
+
+    // Record zones as Chrome trace events (chrome://tracing, Perfetto).
+    // Zones are per instruction, so each thread stops after maxEvents.
+    // Each thread drops its events of an earlier trace itself. writeTrace
+    // reads the other threads' events, so they should be out of zones
+    void startTrace(size_t maxEvents = 200000);
+    void writeTrace(std::ostream &out);
+}
+
+#ifdef INSTRUMENT
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace Instrument
+{
+    uint64_t clockTicks();
+
+    inline uint64_t ticks()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return clockTicks();
+#endif
+    }
+
+    struct TraceEvent
+    {
+        uint8_t zone;
+        uint64_t start;
+        uint64_t end;
+    };
+
+    // Per-thread, plain counters: only the owning thread writes them, the
+    // trace included
+    struct ThreadCounters
+    {
+        ThreadCounters();
+        ~ThreadCounters();
+
+        uint64_t ticks[zoneCount] = {};
+        uint64_t calls[zoneCount] = {};
+        int current = zoneOther;
+        uint64_t last;
+        int thread;
+        std::vector<TraceEvent> trace;
+        uint32_t traceGeneration = 0; // of the trace the events belong to
+    };
+
+    extern thread_local ThreadCounters counters;
+    extern std::atomic<bool> tracing;
+    // Bumped by startTrace() after traceLimit is set
+    extern std::atomic<uint32_t> traceGeneration;
+    extern size_t traceLimit;
+
+    inline void record(ThreadCounters &c, uint8_t zone, uint64_t start, uint64_t end)
+    {
+        uint32_t generation = traceGeneration.load(std::memory_order_acquire);
+        if (c.traceGeneration != generation) {
+            c.trace.clear();
+            c.traceGeneration = generation;
+        }
+        if (c.trace.size() < traceLimit)
+            c.trace.push_back({zone, start, end});
+    }
+
+    class ZoneTimer
+    {
+    public:
+        ZoneTimer(Zone zone)
+        {
+            uint64_t now = ticks();
+            ThreadCounters &c = counters;
+            c.ticks[c.current] += now - c.last;
+            c.calls[zone]++;
+            parent = c.current;
+            start = now;
+            c.current = zone;
+            c.last = now;
+        }
+
+        ~ZoneTimer()
+        {
+            uint64_t now = ticks();
+            ThreadCounters &c = counters;
+            if (tracing.load(std::memory_order_relaxed))
+                record(c, (uint8_t)c.current, start, now);
+            c.ticks[c.current] += now - c.last;
+            c.current = parent;
+            c.last = now;
+        }
+
+    private:
+        int parent;
+        uint64_t start;
+    };
+}
+
+#define INSTRUMENT_CONCAT(a, b) a##b
+#define INSTRUMENT_NAME(line) INSTRUMENT_CONCAT(zoneTimer, line)
+#define INSTRUMENT_ZONE(zone) Instrument::ZoneTimer INSTRUMENT_NAME(__LINE__)(zone)
+
+#else
+
+#define INSTRUMENT_ZONE(zone)
+
+#endif
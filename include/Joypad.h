@@ -0,0 +1,33 @@
+#pragma once
+#include <stdint.h>
+
+// Standard controller on $4016/$4017: while the strobe bit is high the
+// shift register keeps reloading from the buttons, once it's low every read
+// returns the next button, A first, then 1s after the eighth
+class Joypad
+{
+public:
+    enum Buttons
+    {
+        buttonA = 0x01,
+        buttonB = 0x02,
+        buttonSelect = 0x04,
+        buttonStart = 0x08,
+        buttonUp = 0x10,
+        buttonDown = 0x20,
+        buttonLeft = 0x40,
+        buttonRight = 0x80
+    };
+
+    void setButtons(uint8_t buttons);
+    uint8_t getButtons() const;
+    // Bit 0 of a $4016 write
+    void strobe(uint8_t value);
+    // Serial data in bit 0
+    uint8_t read();
+
+private:
+    uint8_t buttons = 0;
+    uint8_t shift = 0;
+    bool latched = false;
+};
@@ -0,0 +1,52 @@
+#pragma once
+#include <MOS6502.h>
+#include <stdint.h>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Differential harness: runs two CPU engines side by side on identical
+// memory images and stops at the first instruction where the registers,
+// flags, cycle count or bus writes disagree.
+// The NES tool pairs the direct and bus-accurate paths of the same opcode
+// handlers, so it catches disagreements between the access paths (dummy
+// cycles, fetch order) but never a bug inside a handler both share
+class Lockstep
+{
+public:
+    Lockstep(MOS6502 &reference, MOS6502 &candidate);
+
+    // Run both engines from the same image and state, returns true if they agree
+    bool run(const uint8_t (&image)[0x10000], const MOS6502::CPUState &start, long instructions);
+    // Random single-instruction tests over all 256 opcodes
+    bool fuzz(int iterations, uint32_t seed);
+    void report(std::ostream &out);
+
+private:
+    struct Divergence
+    {
+        long instruction; // of a run(), or the iteration for opcode in fuzz()
+        int opcode;       // -1 for run()
+        std::string reason;
+        // Minimised repro: state before the instruction and the non-zero bytes it needs
+        MOS6502::CPUState state;
+        std::vector<MOS6502::memWrite> bytes;
+    };
+
+    MOS6502 &reference;
+    MOS6502 &candidate;
+
+    uint8_t refMemory[0x10000];
+    uint8_t candMemory[0x10000];
+    uint8_t scratch[0x10000];
+    std::vector<MOS6502::memWrite> refWrites;
+    std::vector<MOS6502::memWrite> candWrites;
+
+    long instructionsRun = 0;
+    std::vector<Divergence> divergences;
+
+    void load(const uint8_t (&image)[0x10000], const MOS6502::CPUState &state);
+    bool step(std::string &reason);
+    bool diverges(const MOS6502::CPUState &state, const uint8_t (&image)[0x10000], std::string &reason);
+    Divergence minimise(long instruction, const MOS6502::CPUState &state, uint8_t (&image)[0x10000]);
+};
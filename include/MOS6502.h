@@ -1,22 +1,162 @@
 #pragma once
+#include <ALU.h>
 #include <stdint.h>
 #include <iostream>
 #include <fstream>
 #include <bitset>
 #include <vector>
 
+class Profiler;
+class OpcodeStats;
+class FusionTable;
+class Debugger;
+class Coverage;
+class StateHash;
+
 class MOS6502
 {
 public:
     MOS6502();
     void init(std::ifstream &ROM);
-    void executeOP(uint8_t (&memory)[0xFFFF]);
+    // Runs one instruction, or one interrupt sequence, and returns the cycles it took
+    int executeOP(uint8_t (&memory)[0x10000]);
+
+    // Architectural state, used to snapshot and compare CPU engines
+    struct CPUState
+    {
+        uint16_t PC;
+        uint8_t SP;
+        uint8_t AC;
+        uint8_t X;
+        uint8_t Y;
+        uint8_t SR;
+        int totalClk;
+    };
+
+    CPUState getState() const;
+    void setState(const CPUState &state);
+
+    // Save states also need the interrupts latched or asserted but not
+    // taken yet
+    struct Snapshot
+    {
+        CPUState regs;
+        uint8_t interrupts;
+        bool nmiLine;
+        uint8_t irqLines;
+    };
+
+    Snapshot snapshot() const;
+    void restore(const Snapshot &snapshot);
+
+    // Every data write is appended to the log while one is attached
+    struct memWrite
+    {
+        uint16_t addr;
+        uint8_t value;
+    };
+
+    void setWriteLog(std::vector<memWrite> *log);
+    void setLogging(bool enabled);
+
+    // Memory mapped devices, accesses to pages mapped for I/O go to the handler
+    class BusHandler
+    {
+    public:
+        virtual uint8_t ioRead(uint16_t addr) = 0;
+        virtual void ioWrite(uint16_t addr, uint8_t value) = 0;
+        // True if reading addr again returns the same value and has no
+        // further effect until the device's next scheduled event
+        virtual bool idempotentRead(uint16_t addr) { return false; }
+        // Debugger access, without side effects on the device
+        virtual uint8_t peek(uint16_t addr) { return 0; }
+        virtual void poke(uint16_t addr, uint8_t value) {}
+    };
+
+    enum PageFlags
+    {
+        pageIORead = 0x01,
+        pageIOWrite = 0x02,
+        pageLog = 0x04,
+        pageWatch = 0x08, // a debugger watchpoint covers part of the page
+        pageCover = 0x10, // data reads go to the coverage log
+        pageHash = 0x20   // writes update the state hash
+    };
+
+    void attachIO(BusHandler *handler);
+    void mapPages(int firstPage, int lastPage, uint8_t flags);
+    void watchPage(int page, bool watched);
+    // Side effect free access for debuggers, I/O pages go to peek/poke
+    uint8_t peek(uint16_t addr, uint8_t (&memory)[0x10000]);
+    void poke(uint16_t addr, uint8_t value, uint8_t (&memory)[0x10000]);
+
+    // Every bus access, fetches and dummy cycles included, while one is attached
+    struct busCycle
+    {
+        uint16_t addr;
+        uint8_t value;
+        bool write;
+    };
+
+    void setBusLog(std::vector<busCycle> *log);
+    // Issue the exact per-cycle access sequence (dummy reads, RMW double writes)
+    // instead of only the accesses that produce the result
+    void setBusAccurate(bool enabled);
+    // Cycles spent outside of instructions (DMA)
+    void addCycles(int cycles);
+
+    // Interrupt inputs, sampled at the next instruction boundary.
+    // NMI is edge triggered; IRQ is a wired-OR of level triggered sources
+    enum IRQSource
+    {
+        irqAPUFrame = 0x01,
+        irqDMC = 0x02,
+        irqMapper = 0x04
+    };
+
+    void setNMI(bool level);
+    void setIRQ(uint8_t source, bool asserted);
+    void reset();
+    // Registers cleared, then a reset (leaves SP at $FD)
+    void powerOn();
+
+    // Guest profiler, called at every instruction boundary while attached
+    void setProfiler(Profiler *profiler);
+    // Opcode mix collector, same hook as the profiler
+    void setStats(OpcodeStats *stats);
+    // Code/data log: instruction bytes at every boundary, data reads on the
+    // pages the log covers
+    void setCoverage(Coverage *coverage);
+    // Writes to the pages StateHash tracks update it, null to stop
+    void setStateHash(StateHash *hash);
+
+    // Superinstructions: pairs in the table run in one dispatch, but only
+    // while the second instruction would end before the deadline, the
+    // number of cycles from now in which nothing outside the CPU can change
+    void setFusion(const FusionTable *table);
+    void setDeadline(int cycles);
+    int cyclesToDeadline() const;
+    uint64_t fusedInstructions() const;
+
+    // Idle loops: once a short backward loop that can't change anything is
+    // seen repeating with identical registers, whole iterations are skipped
+    // up to the deadline and their cycles added
+    void setIdleSkip(bool enabled);
+    uint64_t idleCyclesSkipped() const;
+
+    // Asked at every instruction boundary whether to stop; a stopped CPU
+    // returns 0 from executeOP without running anything. Watched pages
+    // report their accesses to it
+    void setDebugger(Debugger *debugger);
 
 private:
+    const int NMIVEC = 0xFFFA;
+    const int RESETVEC = 0xFFFC;
     const int INTERRUPTVEC = 0xFFFE;
     int totalClk;
 
     std::ofstream CPULogFile;
+    bool logEnabled = true;
     std::string logBuf;
     std::string getRegisterLog();
 
@@ -25,7 +165,7 @@ private:
         carry,
         zero,
         interrupt,
-        decimal, // decimal mode not implemented
+        decimal, // BCD only on CPU_VARIANTs that have it, see ALU.h
         brk,
         none,
         overflow,
@@ -36,13 +176,13 @@ private:
 
     // Registers
     uint16_t PC = 0xC000;
-    uint16_t SP = 0xFD;
+    uint8_t SP = 0xFD;
     uint8_t AC = 0;
     uint8_t X = 0;
     uint8_t Y = 0;
     std::bitset<8> SR;
 
-    typedef void (MOS6502::*opcodeFuncPtr)(int &, uint8_t (&memory)[0xFFFF]);
+    typedef void (MOS6502::*opcodeFuncPtr)(int &, uint8_t (&memory)[0x10000]);
 
     struct opcodeDef
     {
@@ -52,29 +192,102 @@ private:
     };
 
     std::vector<opcodeDef *> opcodeLookup;
+    std::vector<memWrite> *writeLog = nullptr;
+    std::vector<busCycle> *busLog = nullptr;
+    BusHandler *io = nullptr;
+    uint8_t pageFlags[256] = {};
+    bool busAccurate = false;
+
+    // Anything that has to interrupt the normal fetch/execute loop sets a bit
+    // here, so the loop tests a single word per instruction
+    enum Events
+    {
+        eventNMI = 0x01,
+        eventIRQ = 0x02,
+        eventReset = 0x04,
+        eventProfile = 0x08,
+        eventStats = 0x10,
+        eventDebug = 0x20,
+        eventCoverage = 0x40,
+        eventInterrupts = eventNMI | eventIRQ | eventReset,
+        // Run at every boundary but never divert execution
+        eventObservers = eventProfile | eventStats | eventCoverage
+    };
+
+    uint32_t pendingEvents = 0;
+    bool nmiLine = false;
+    uint8_t irqLines = 0;
+    Profiler *profiler = nullptr;
+    OpcodeStats *stats = nullptr;
+    Debugger *debugger = nullptr;
+    Coverage *coverage = nullptr;
+    StateHash *stateHash = nullptr;
+
+    static const int MAXFUSEDCYCLES = 7;
+    const FusionTable *fusion = nullptr;
+    bool fusionAllowed = false; // no fusion table, or a log needs every boundary
+    bool ioTouched = false;
+    int deadline = 0;
+    uint64_t fusedCount = 0;
+    void updateFusion();
+
+    static const int MAXIDLEINSTRUCTIONS = 8;
+
+    struct IdleLoop
+    {
+        int head = -1;
+        uint16_t end = 0;
+        bool armed = false;
+        int clk = 0;
+        int deadline = 0; // a new deadline means an event passed, reads may differ
+        uint8_t AC, X, Y, SP, SR;
+    };
+
+    bool idleSkip = false;
+    bool idleAllowed = false;
+    IdleLoop idle;
+    uint64_t idleSkipped = 0;
+    int skipIdleLoop(uint16_t from, int clk, uint8_t (&memory)[0x10000]);
+    bool idleLoopBody(uint16_t head, uint16_t &end, uint8_t (&memory)[0x10000]);
+    bool constantRead(uint8_t opcode, uint16_t operand, uint8_t (&memory)[0x10000]);
 
     void setReg(uint8_t &reg, uint8_t val);
-    uint8_t getByte(uint8_t (&memory)[0xFFFF]);
+    uint8_t getByte(uint8_t (&memory)[0x10000]);
+    uint8_t read(uint16_t addr, uint8_t (&memory)[0x10000]);
+    void write(uint16_t addr, uint8_t value, uint8_t (&memory)[0x10000]);
+    uint8_t modifyMem(uint16_t addr, void (MOS6502::*op)(uint8_t &), uint8_t (&memory)[0x10000]);
+    uint8_t slowRead(uint16_t addr, uint8_t (&memory)[0x10000]);
+    void slowWrite(uint16_t addr, uint8_t value, bool dummy, uint8_t (&memory)[0x10000]);
+    void dummyRead(uint16_t addr, uint8_t (&memory)[0x10000]);
+    void updateLogPages();
+    bool serviceEvents(int &clk, uint8_t (&memory)[0x10000]);
+    bool interruptDue() const;
+    void observeInterrupt(int kind);
+    void interruptSequence(uint16_t vector, uint16_t returnAddr, bool brk, int &clk, uint8_t (&memory)[0x10000]);
 
     uint16_t addPgCross(uint8_t LSB, uint8_t addValue, uint8_t MSB, int &clk, bool addClk);
     void carryTest(uint16_t value);
     void overflowTest(uint8_t value);
     void add(uint8_t value);
     void sub(uint8_t value);
+    void setALUResult(const ALUResult &result);
     void CMPTest(uint8_t reg, uint8_t val);
     void checkBranchPgCross(int8_t jump, int &clk);
+    void takeBranch(int8_t jump, int &clk, uint8_t (&memory)[0x10000]);
 
     uint16_t SPToAddr();
-    void pushToStack(uint8_t value, uint8_t (&memory)[0xFFFF]);
-    uint8_t pullFromStack(uint8_t (&memory)[0xFFFF]);
-
-    uint8_t zpModeAddr(uint8_t (&memory)[0xFFFF]);
-    uint16_t zpindModeAddr(uint8_t addValue, uint8_t (&memory)[0xFFFF]);
-    uint16_t absModeAddr(uint8_t (&memory)[0xFFFF]);
-    uint16_t absindModeAddr(uint8_t addValue, uint8_t (&memory)[0xFFFF], int &clk, bool addClk);
-    uint16_t indxModeAddr(uint8_t (&memory)[0xFFFF]);
-    uint16_t indyModeAddr(uint8_t (&memory)[0xFFFF], int &clk, bool addClk);
-
+    void pushToStack(uint8_t value, uint8_t (&memory)[0x10000]);
+    uint8_t pullFromStack(uint8_t (&memory)[0x10000]);
+
+    uint8_t zpModeAddr(uint8_t (&memory)[0x10000]);
+    uint16_t zpindModeAddr(uint8_t addValue, uint8_t (&memory)[0x10000]);
+    uint16_t absModeAddr(uint8_t (&memory)[0x10000]);
+    uint16_t absindModeAddr(uint8_t addValue, uint8_t (&memory)[0x10000], int &clk, bool addClk);
+    uint16_t indxModeAddr(uint8_t (&memory)[0x10000]);
+    uint16_t indyModeAddr(uint8_t (&memory)[0x10000], int &clk, bool addClk);
+
+    void DECMem(uint8_t &memVal);
+    void INCMem(uint8_t &memVal);
     void ASLMem(uint8_t &memVal);
     void LSRMem(uint8_t &memVal);
     void ROLMem(uint8_t &memVal);
@@ -85,338 +298,337 @@ private:
     // Transfer
 
     // LDA  load accumulator
-    void LDA_IM(int &clk, uint8_t (&memory)[0xFFFF]);
-    void LDA_ZP(int &clk, uint8_t (&memory)[0xFFFF]);
-    void LDA_ZPX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void LDA_ABS(int &clk, uint8_t (&memory)[0xFFFF]);
-    void LDA_ABSX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void LDA_ABSY(int &clk, uint8_t (&memory)[0xFFFF]);
-    void LDA_INDX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void LDA_INDY(int &clk, uint8_t (&memory)[0xFFFF]);
+    void LDA_IM(int &clk, uint8_t (&memory)[0x10000]);
+    void LDA_ZP(int &clk, uint8_t (&memory)[0x10000]);
+    void LDA_ZPX(int &clk, uint8_t (&memory)[0x10000]);
+    void LDA_ABS(int &clk, uint8_t (&memory)[0x10000]);
+    void LDA_ABSX(int &clk, uint8_t (&memory)[0x10000]);
+    void LDA_ABSY(int &clk, uint8_t (&memory)[0x10000]);
+    void LDA_INDX(int &clk, uint8_t (&memory)[0x10000]);
+    void LDA_INDY(int &clk, uint8_t (&memory)[0x10000]);
     // LDX  load X
-    void LDX_IM(int &clk, uint8_t (&memory)[0xFFFF]);
-    void LDX_ZP(int &clk, uint8_t (&memory)[0xFFFF]);
-    void LDX_ZPY(int &clk, uint8_t (&memory)[0xFFFF]);
-    void LDX_ABS(int &clk, uint8_t (&memory)[0xFFFF]);
-    void LDX_ABSY(int &clk, uint8_t (&memory)[0xFFFF]);
+    void LDX_IM(int &clk, uint8_t (&memory)[0x10000]);
+    void LDX_ZP(int &clk, uint8_t (&memory)[0x10000]);
+    void LDX_ZPY(int &clk, uint8_t (&memory)[0x10000]);
+    void LDX_ABS(int &clk, uint8_t (&memory)[0x10000]);
+    void LDX_ABSY(int &clk, uint8_t (&memory)[0x10000]);
     // LDY  load Y
-    void LDY_IM(int &clk, uint8_t (&memory)[0xFFFF]);
-    void LDY_ZP(int &clk, uint8_t (&memory)[0xFFFF]);
-    void LDY_ZPX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void LDY_ABS(int &clk, uint8_t (&memory)[0xFFFF]);
-    void LDY_ABSX(int &clk, uint8_t (&memory)[0xFFFF]);
+    void LDY_IM(int &clk, uint8_t (&memory)[0x10000]);
+    void LDY_ZP(int &clk, uint8_t (&memory)[0x10000]);
+    void LDY_ZPX(int &clk, uint8_t (&memory)[0x10000]);
+    void LDY_ABS(int &clk, uint8_t (&memory)[0x10000]);
+    void LDY_ABSX(int &clk, uint8_t (&memory)[0x10000]);
     // STA  store accumulator
-    void STA_ZP(int &clk, uint8_t (&memory)[0xFFFF]);
-    void STA_ZPX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void STA_ABS(int &clk, uint8_t (&memory)[0xFFFF]);
-    void STA_ABSX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void STA_ABSY(int &clk, uint8_t (&memory)[0xFFFF]);
-    void STA_INDX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void STA_INDY(int &clk, uint8_t (&memory)[0xFFFF]);
+    void STA_ZP(int &clk, uint8_t (&memory)[0x10000]);
+    void STA_ZPX(int &clk, uint8_t (&memory)[0x10000]);
+    void STA_ABS(int &clk, uint8_t (&memory)[0x10000]);
+    void STA_ABSX(int &clk, uint8_t (&memory)[0x10000]);
+    void STA_ABSY(int &clk, uint8_t (&memory)[0x10000]);
+    void STA_INDX(int &clk, uint8_t (&memory)[0x10000]);
+    void STA_INDY(int &clk, uint8_t (&memory)[0x10000]);
     // STX  store X
-    void STX_ZP(int &clk, uint8_t (&memory)[0xFFFF]);
-    void STX_ZPY(int &clk, uint8_t (&memory)[0xFFFF]);
-    void STX_ABS(int &clk, uint8_t (&memory)[0xFFFF]);
+    void STX_ZP(int &clk, uint8_t (&memory)[0x10000]);
+    void STX_ZPY(int &clk, uint8_t (&memory)[0x10000]);
+    void STX_ABS(int &clk, uint8_t (&memory)[0x10000]);
     // STY  store Y
-    void STY_ZP(int &clk, uint8_t (&memory)[0xFFFF]);
-    void STY_ZPX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void STY_ABS(int &clk, uint8_t (&memory)[0xFFFF]);
+    void STY_ZP(int &clk, uint8_t (&memory)[0x10000]);
+    void STY_ZPX(int &clk, uint8_t (&memory)[0x10000]);
+    void STY_ABS(int &clk, uint8_t (&memory)[0x10000]);
     // TAX  transfer accumulator to X
-    void TAX(int &clk, uint8_t (&memory)[0xFFFF]);
+    void TAX(int &clk, uint8_t (&memory)[0x10000]);
     // TAY  transfer accumulator to Y
-    void TAY(int &clk, uint8_t (&memory)[0xFFFF]);
+    void TAY(int &clk, uint8_t (&memory)[0x10000]);
     // TSX  transfer stack pointer to X
-    void TSX(int &clk, uint8_t (&memory)[0xFFFF]);
+    void TSX(int &clk, uint8_t (&memory)[0x10000]);
     // TXA  transfer X to accumulator
-    void TXA(int &clk, uint8_t (&memory)[0xFFFF]);
+    void TXA(int &clk, uint8_t (&memory)[0x10000]);
     // TXS  transfer X to stack pointer
-    void TXS(int &clk, uint8_t (&memory)[0xFFFF]);
+    void TXS(int &clk, uint8_t (&memory)[0x10000]);
     // TYA  transfer Y to accumulator
-    void TYA(int &clk, uint8_t (&memory)[0xFFFF]);
+    void TYA(int &clk, uint8_t (&memory)[0x10000]);
 
     // Stack instructions
 
     // PHA  push accumulator
-    void PHA(int &clk, uint8_t (&memory)[0xFFFF]);
+    void PHA(int &clk, uint8_t (&memory)[0x10000]);
     // PHP  push processor status register (with break flag set)
-    void PHP(int &clk, uint8_t (&memory)[0xFFFF]);
+    void PHP(int &clk, uint8_t (&memory)[0x10000]);
     // PLA  pull accumulator
-    void PLA(int &clk, uint8_t (&memory)[0xFFFF]);
+    void PLA(int &clk, uint8_t (&memory)[0x10000]);
     // PLP  pull processor status register
-    void PLP(int &clk, uint8_t (&memory)[0xFFFF]);
+    void PLP(int &clk, uint8_t (&memory)[0x10000]);
 
     // Decrements and increments
 
     // DEC  decrement (memory)
-    void DEC_ZP(int &clk, uint8_t (&memory)[0xFFFF]);
-    void DEC_ZPX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void DEC_ABS(int &clk, uint8_t (&memory)[0xFFFF]);
-    void DEC_ABSX(int &clk, uint8_t (&memory)[0xFFFF]);
+    void DEC_ZP(int &clk, uint8_t (&memory)[0x10000]);
+    void DEC_ZPX(int &clk, uint8_t (&memory)[0x10000]);
+    void DEC_ABS(int &clk, uint8_t (&memory)[0x10000]);
+    void DEC_ABSX(int &clk, uint8_t (&memory)[0x10000]);
     // DEX  decrement X
-    void DEX(int &clk, uint8_t (&memory)[0xFFFF]);
+    void DEX(int &clk, uint8_t (&memory)[0x10000]);
     // DEY  decrement Y
-    void DEY(int &clk, uint8_t (&memory)[0xFFFF]);
+    void DEY(int &clk, uint8_t (&memory)[0x10000]);
     // INC  increment (memory)
-    void INC_ZP(int &clk, uint8_t (&memory)[0xFFFF]);
-    void INC_ZPX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void INC_ABS(int &clk, uint8_t (&memory)[0xFFFF]);
-    void INC_ABSX(int &clk, uint8_t (&memory)[0xFFFF]);
+    void INC_ZP(int &clk, uint8_t (&memory)[0x10000]);
+    void INC_ZPX(int &clk, uint8_t (&memory)[0x10000]);
+    void INC_ABS(int &clk, uint8_t (&memory)[0x10000]);
+    void INC_ABSX(int &clk, uint8_t (&memory)[0x10000]);
     // INX  increment X
-    void INX(int &clk, uint8_t (&memory)[0xFFFF]);
+    void INX(int &clk, uint8_t (&memory)[0x10000]);
     // INY  increment Y
-    void INY(int &clk, uint8_t (&memory)[0xFFFF]);
+    void INY(int &clk, uint8_t (&memory)[0x10000]);
 
     // Arithmetic operations
 
     // ADC  add with carry (prepare by CLC)
-    void ADC_IM(int &clk, uint8_t (&memory)[0xFFFF]);
-    void ADC_ZP(int &clk, uint8_t (&memory)[0xFFFF]);
-    void ADC_ZPX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void ADC_ABS(int &clk, uint8_t (&memory)[0xFFFF]);
-    void ADC_ABSX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void ADC_ABSY(int &clk, uint8_t (&memory)[0xFFFF]);
-    void ADC_INDX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void ADC_INDY(int &clk, uint8_t (&memory)[0xFFFF]);
+    void ADC_IM(int &clk, uint8_t (&memory)[0x10000]);
+    void ADC_ZP(int &clk, uint8_t (&memory)[0x10000]);
+    void ADC_ZPX(int &clk, uint8_t (&memory)[0x10000]);
+    void ADC_ABS(int &clk, uint8_t (&memory)[0x10000]);
+    void ADC_ABSX(int &clk, uint8_t (&memory)[0x10000]);
+    void ADC_ABSY(int &clk, uint8_t (&memory)[0x10000]);
+    void ADC_INDX(int &clk, uint8_t (&memory)[0x10000]);
+    void ADC_INDY(int &clk, uint8_t (&memory)[0x10000]);
     // SBC  subtract with carry (prepare by SEC)
-    void SBC_IM(int &clk, uint8_t (&memory)[0xFFFF]);
-    void SBC_ZP(int &clk, uint8_t (&memory)[0xFFFF]);
-    void SBC_ZPX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void SBC_ABS(int &clk, uint8_t (&memory)[0xFFFF]);
-    void SBC_ABSX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void SBC_ABSY(int &clk, uint8_t (&memory)[0xFFFF]);
-    void SBC_INDX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void SBC_INDY(int &clk, uint8_t (&memory)[0xFFFF]);
+    void SBC_IM(int &clk, uint8_t (&memory)[0x10000]);
+    void SBC_ZP(int &clk, uint8_t (&memory)[0x10000]);
+    void SBC_ZPX(int &clk, uint8_t (&memory)[0x10000]);
+    void SBC_ABS(int &clk, uint8_t (&memory)[0x10000]);
+    void SBC_ABSX(int &clk, uint8_t (&memory)[0x10000]);
+    void SBC_ABSY(int &clk, uint8_t (&memory)[0x10000]);
+    void SBC_INDX(int &clk, uint8_t (&memory)[0x10000]);
+    void SBC_INDY(int &clk, uint8_t (&memory)[0x10000]);
 
     // Logical operations
 
     // AND  and (with accumulator)
-    void AND_IM(int &clk, uint8_t (&memory)[0xFFFF]);
-    void AND_ZP(int &clk, uint8_t (&memory)[0xFFFF]);
-    void AND_ZPX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void AND_ABS(int &clk, uint8_t (&memory)[0xFFFF]);
-    void AND_ABSX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void AND_ABSY(int &clk, uint8_t (&memory)[0xFFFF]);
-    void AND_INDX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void AND_INDY(int &clk, uint8_t (&memory)[0xFFFF]);
+    void AND_IM(int &clk, uint8_t (&memory)[0x10000]);
+    void AND_ZP(int &clk, uint8_t (&memory)[0x10000]);
+    void AND_ZPX(int &clk, uint8_t (&memory)[0x10000]);
+    void AND_ABS(int &clk, uint8_t (&memory)[0x10000]);
+    void AND_ABSX(int &clk, uint8_t (&memory)[0x10000]);
+    void AND_ABSY(int &clk, uint8_t (&memory)[0x10000]);
+    void AND_INDX(int &clk, uint8_t (&memory)[0x10000]);
+    void AND_INDY(int &clk, uint8_t (&memory)[0x10000]);
     // EOR  exclusive or (with accumulator)
-    void EOR_IM(int &clk, uint8_t (&memory)[0xFFFF]);
-    void EOR_ZP(int &clk, uint8_t (&memory)[0xFFFF]);
-    void EOR_ZPX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void EOR_ABS(int &clk, uint8_t (&memory)[0xFFFF]);
-    void EOR_ABSX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void EOR_ABSY(int &clk, uint8_t (&memory)[0xFFFF]);
-    void EOR_INDX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void EOR_INDY(int &clk, uint8_t (&memory)[0xFFFF]);
+    void EOR_IM(int &clk, uint8_t (&memory)[0x10000]);
+    void EOR_ZP(int &clk, uint8_t (&memory)[0x10000]);
+    void EOR_ZPX(int &clk, uint8_t (&memory)[0x10000]);
+    void EOR_ABS(int &clk, uint8_t (&memory)[0x10000]);
+    void EOR_ABSX(int &clk, uint8_t (&memory)[0x10000]);
+    void EOR_ABSY(int &clk, uint8_t (&memory)[0x10000]);
+    void EOR_INDX(int &clk, uint8_t (&memory)[0x10000]);
+    void EOR_INDY(int &clk, uint8_t (&memory)[0x10000]);
     // ORA  (inclusive) or with accumulator
-    void ORA_IM(int &clk, uint8_t (&memory)[0xFFFF]);
-    void ORA_ZP(int &clk, uint8_t (&memory)[0xFFFF]);
-    void ORA_ZPX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void ORA_ABS(int &clk, uint8_t (&memory)[0xFFFF]);
-    void ORA_ABSX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void ORA_ABSY(int &clk, uint8_t (&memory)[0xFFFF]);
-    void ORA_INDX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void ORA_INDY(int &clk, uint8_t (&memory)[0xFFFF]);
+    void ORA_IM(int &clk, uint8_t (&memory)[0x10000]);
+    void ORA_ZP(int &clk, uint8_t (&memory)[0x10000]);
+    void ORA_ZPX(int &clk, uint8_t (&memory)[0x10000]);
+    void ORA_ABS(int &clk, uint8_t (&memory)[0x10000]);
+    void ORA_ABSX(int &clk, uint8_t (&memory)[0x10000]);
+    void ORA_ABSY(int &clk, uint8_t (&memory)[0x10000]);
+    void ORA_INDX(int &clk, uint8_t (&memory)[0x10000]);
+    void ORA_INDY(int &clk, uint8_t (&memory)[0x10000]);
 
     // Shift and rotate instructions
 
     // ASL  arithmetic shift left (shifts in a zero bit on the right)
-    void ASL_ACC(int &clk, uint8_t (&memory)[0xFFFF]);
-    void ASL_ZP(int &clk, uint8_t (&memory)[0xFFFF]);
-    void ASL_ZPX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void ASL_ABS(int &clk, uint8_t (&memory)[0xFFFF]);
-    void ASL_ABSX(int &clk, uint8_t (&memory)[0xFFFF]);
+    void ASL_ACC(int &clk, uint8_t (&memory)[0x10000]);
+    void ASL_ZP(int &clk, uint8_t (&memory)[0x10000]);
+    void ASL_ZPX(int &clk, uint8_t (&memory)[0x10000]);
+    void ASL_ABS(int &clk, uint8_t (&memory)[0x10000]);
+    void ASL_ABSX(int &clk, uint8_t (&memory)[0x10000]);
     // LSR  logical shift right (shifts in a zero bit on the left)
-    void LSR_ACC(int &clk, uint8_t (&memory)[0xFFFF]);
-    void LSR_ZP(int &clk, uint8_t (&memory)[0xFFFF]);
-    void LSR_ZPX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void LSR_ABS(int &clk, uint8_t (&memory)[0xFFFF]);
-    void LSR_ABSX(int &clk, uint8_t (&memory)[0xFFFF]);
+    void LSR_ACC(int &clk, uint8_t (&memory)[0x10000]);
+    void LSR_ZP(int &clk, uint8_t (&memory)[0x10000]);
+    void LSR_ZPX(int &clk, uint8_t (&memory)[0x10000]);
+    void LSR_ABS(int &clk, uint8_t (&memory)[0x10000]);
+    void LSR_ABSX(int &clk, uint8_t (&memory)[0x10000]);
     // ROL  rotate left (shifts in carry bit on the right)
-    void ROL_ACC(int &clk, uint8_t (&memory)[0xFFFF]);
-    void ROL_ZP(int &clk, uint8_t (&memory)[0xFFFF]);
-    void ROL_ZPX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void ROL_ABS(int &clk, uint8_t (&memory)[0xFFFF]);
-    void ROL_ABSX(int &clk, uint8_t (&memory)[0xFFFF]);
+    void ROL_ACC(int &clk, uint8_t (&memory)[0x10000]);
+    void ROL_ZP(int &clk, uint8_t (&memory)[0x10000]);
+    void ROL_ZPX(int &clk, uint8_t (&memory)[0x10000]);
+    void ROL_ABS(int &clk, uint8_t (&memory)[0x10000]);
+    void ROL_ABSX(int &clk, uint8_t (&memory)[0x10000]);
     // ROR  rotate right (shifts in zero bit on the left)
-    void ROR_ACC(int &clk, uint8_t (&memory)[0xFFFF]);
-    void ROR_ZP(int &clk, uint8_t (&memory)[0xFFFF]);
-    void ROR_ZPX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void ROR_ABS(int &clk, uint8_t (&memory)[0xFFFF]);
-    void ROR_ABSX(int &clk, uint8_t (&memory)[0xFFFF]);
+    void ROR_ACC(int &clk, uint8_t (&memory)[0x10000]);
+    void ROR_ZP(int &clk, uint8_t (&memory)[0x10000]);
+    void ROR_ZPX(int &clk, uint8_t (&memory)[0x10000]);
+    void ROR_ABS(int &clk, uint8_t (&memory)[0x10000]);
+    void ROR_ABSX(int &clk, uint8_t (&memory)[0x10000]);
 
     // Flag instructions
 
     // CLC  clear carry
-    void CLC(int &clk, uint8_t (&memory)[0xFFFF]);
+    void CLC(int &clk, uint8_t (&memory)[0x10000]);
     // CLD  clear decimal (BCD arithmetics disabled)
-    void CLD(int &clk, uint8_t (&memory)[0xFFFF]);
+    void CLD(int &clk, uint8_t (&memory)[0x10000]);
     // CLI  clear interrupt disable
-    void CLI(int &clk, uint8_t (&memory)[0xFFFF]);
+    void CLI(int &clk, uint8_t (&memory)[0x10000]);
     // CLV  clear overflow
-    void CLV(int &clk, uint8_t (&memory)[0xFFFF]);
+    void CLV(int &clk, uint8_t (&memory)[0x10000]);
     // SEC  set carry
-    void SEC(int &clk, uint8_t (&memory)[0xFFFF]);
+    void SEC(int &clk, uint8_t (&memory)[0x10000]);
     // SED  set decimal (BCD arithmetics enabled)
-    void SED(int &clk, uint8_t (&memory)[0xFFFF]);
+    void SED(int &clk, uint8_t (&memory)[0x10000]);
     // SEI  set interrupt disable
-    void SEI(int &clk, uint8_t (&memory)[0xFFFF]);
+    void SEI(int &clk, uint8_t (&memory)[0x10000]);
 
     // Comparisons
 
     // CMP  compare (with accumulator)
-    void CMP_IM(int &clk, uint8_t (&memory)[0xFFFF]);
-    void CMP_ZP(int &clk, uint8_t (&memory)[0xFFFF]);
-    void CMP_ZPX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void CMP_ABS(int &clk, uint8_t (&memory)[0xFFFF]);
-    void CMP_ABSX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void CMP_ABSY(int &clk, uint8_t (&memory)[0xFFFF]);
-    void CMP_INDX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void CMP_INDY(int &clk, uint8_t (&memory)[0xFFFF]);
+    void CMP_IM(int &clk, uint8_t (&memory)[0x10000]);
+    void CMP_ZP(int &clk, uint8_t (&memory)[0x10000]);
+    void CMP_ZPX(int &clk, uint8_t (&memory)[0x10000]);
+    void CMP_ABS(int &clk, uint8_t (&memory)[0x10000]);
+    void CMP_ABSX(int &clk, uint8_t (&memory)[0x10000]);
+    void CMP_ABSY(int &clk, uint8_t (&memory)[0x10000]);
+    void CMP_INDX(int &clk, uint8_t (&memory)[0x10000]);
+    void CMP_INDY(int &clk, uint8_t (&memory)[0x10000]);
     // CPX  compare with X
-    void CPX_IM(int &clk, uint8_t (&memory)[0xFFFF]);
-    void CPX_ZP(int &clk, uint8_t (&memory)[0xFFFF]);
-    void CPX_ABS(int &clk, uint8_t (&memory)[0xFFFF]);
+    void CPX_IM(int &clk, uint8_t (&memory)[0x10000]);
+    void CPX_ZP(int &clk, uint8_t (&memory)[0x10000]);
+    void CPX_ABS(int &clk, uint8_t (&memory)[0x10000]);
     // CPY  compare with Y
-    void CPY_IM(int &clk, uint8_t (&memory)[0xFFFF]);
-    void CPY_ZP(int &clk, uint8_t (&memory)[0xFFFF]);
-    void CPY_ABS(int &clk, uint8_t (&memory)[0xFFFF]);
+    void CPY_IM(int &clk, uint8_t (&memory)[0x10000]);
+    void CPY_ZP(int &clk, uint8_t (&memory)[0x10000]);
+    void CPY_ABS(int &clk, uint8_t (&memory)[0x10000]);
 
     // Conditional branch instructions
 
     // BCC  branch on carry clear
-    void BCC(int &clk, uint8_t (&memory)[0xFFFF]);
+    void BCC(int &clk, uint8_t (&memory)[0x10000]);
     // BCS  branch on carry set
-    void BCS(int &clk, uint8_t (&memory)[0xFFFF]);
+    void BCS(int &clk, uint8_t (&memory)[0x10000]);
     // BEQ  branch on equal (zero set)
-    void BEQ(int &clk, uint8_t (&memory)[0xFFFF]);
+    void BEQ(int &clk, uint8_t (&memory)[0x10000]);
     // BMI  branch on minus (negative set)
-    void BMI(int &clk, uint8_t (&memory)[0xFFFF]);
+    void BMI(int &clk, uint8_t (&memory)[0x10000]);
     // BNE  branch on not equal (zero clear)
-    void BNE(int &clk, uint8_t (&memory)[0xFFFF]);
+    void BNE(int &clk, uint8_t (&memory)[0x10000]);
     // BPL   branch on plus (negative clear)
-    void BPL(int &clk, uint8_t (&memory)[0xFFFF]);
+    void BPL(int &clk, uint8_t (&memory)[0x10000]);
     // BVC  branch on overflow clear
-    void BVC(int &clk, uint8_t (&memory)[0xFFFF]);
+    void BVC(int &clk, uint8_t (&memory)[0x10000]);
     // BVS  branch on overflow set
-    void BVS(int &clk, uint8_t (&memory)[0xFFFF]);
+    void BVS(int &clk, uint8_t (&memory)[0x10000]);
 
     // Jumps and subroutines
 
     // JMP  jump
-    void JMP_ABS(int &clk, uint8_t (&memory)[0xFFFF]);
-    void JMP_IND(int &clk, uint8_t (&memory)[0xFFFF]);
+    void JMP_ABS(int &clk, uint8_t (&memory)[0x10000]);
+    void JMP_IND(int &clk, uint8_t (&memory)[0x10000]);
     // JSR  jump subroutine
-    void JSR_ABS(int &clk, uint8_t (&memory)[0xFFFF]);
+    void JSR_ABS(int &clk, uint8_t (&memory)[0x10000]);
     // RTS  return from subroutine
-    void RTS_IMP(int &clk, uint8_t (&memory)[0xFFFF]);
+    void RTS_IMP(int &clk, uint8_t (&memory)[0x10000]);
 
     // Interrupts
 
     // BRK  break / software interrupt
-    void BRK_IMP(int &clk, uint8_t (&memory)[0xFFFF]);
+    void BRK_IMP(int &clk, uint8_t (&memory)[0x10000]);
     // RTI  return from interrupt
-    void RTI_IMP(int &clk, uint8_t (&memory)[0xFFFF]);
+    void RTI_IMP(int &clk, uint8_t (&memory)[0x10000]);
 
     // Other
 
     // BIT  bit test (accumulator & memory)
-    void BIT_ZP(int &clk, uint8_t (&memory)[0xFFFF]);
-    void BIT_ABS(int &clk, uint8_t (&memory)[0xFFFF]);
+    void BIT_ZP(int &clk, uint8_t (&memory)[0x10000]);
+    void BIT_ABS(int &clk, uint8_t (&memory)[0x10000]);
     // NOP  no operation
-    void NOP_IMP(int &clk, uint8_t (&memory)[0xFFFF]);
+    void NOP_IMP(int &clk, uint8_t (&memory)[0x10000]);
 
     // Illegal opcodes
-    void ALR_IM(int &clk, uint8_t (&memory)[0xFFFF]);
-    void ANC_IM(int &clk, uint8_t (&memory)[0xFFFF]);
-    void ANE_IM(int &clk, uint8_t (&memory)[0xFFFF]);
-    void ARR_IM(int &clk, uint8_t (&memory)[0xFFFF]);
-
-    void DCP_ZP(int &clk, uint8_t (&memory)[0xFFFF]);
-    void DCP_ZPX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void DCP_ABS(int &clk, uint8_t (&memory)[0xFFFF]);
-    void DCP_ABSX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void DCP_ABSY(int &clk, uint8_t (&memory)[0xFFFF]);
-    void DCP_INDX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void DCP_INDY(int &clk, uint8_t (&memory)[0xFFFF]);
-
-    void ISC_ZP(int &clk, uint8_t (&memory)[0xFFFF]);
-    void ISC_ZPX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void ISC_ABS(int &clk, uint8_t (&memory)[0xFFFF]);
-    void ISC_ABSX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void ISC_ABSY(int &clk, uint8_t (&memory)[0xFFFF]);
-    void ISC_INDX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void ISC_INDY(int &clk, uint8_t (&memory)[0xFFFF]);
-
-    void LAS_ABSY(int &clk, uint8_t (&memory)[0xFFFF]);
-
-    void LAX_ZP(int &clk, uint8_t (&memory)[0xFFFF]);
-    void LAX_ZPY(int &clk, uint8_t (&memory)[0xFFFF]);
-    void LAX_ABS(int &clk, uint8_t (&memory)[0xFFFF]);
-    void LAX_ABSY(int &clk, uint8_t (&memory)[0xFFFF]);
-    void LAX_INDX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void LAX_INDY(int &clk, uint8_t (&memory)[0xFFFF]);
-
-    void LXA_IM(int &clk, uint8_t (&memory)[0xFFFF]);
-
-    void RLA_ZP(int &clk, uint8_t (&memory)[0xFFFF]);
-    void RLA_ZPX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void RLA_ABS(int &clk, uint8_t (&memory)[0xFFFF]);
-    void RLA_ABSX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void RLA_ABSY(int &clk, uint8_t (&memory)[0xFFFF]);
-    void RLA_INDX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void RLA_INDY(int &clk, uint8_t (&memory)[0xFFFF]);
-
-    void RRA_ZP(int &clk, uint8_t (&memory)[0xFFFF]);
-    void RRA_ZPX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void RRA_ABS(int &clk, uint8_t (&memory)[0xFFFF]);
-    void RRA_ABSX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void RRA_ABSY(int &clk, uint8_t (&memory)[0xFFFF]);
-    void RRA_INDX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void RRA_INDY(int &clk, uint8_t (&memory)[0xFFFF]);
-
-    void SAX_ZP(int &clk, uint8_t (&memory)[0xFFFF]);
-    void SAX_ZPY(int &clk, uint8_t (&memory)[0xFFFF]);
-    void SAX_ABS(int &clk, uint8_t (&memory)[0xFFFF]);
-    void SAX_INDX(int &clk, uint8_t (&memory)[0xFFFF]);
-
-    void SBX_IM(int &clk, uint8_t (&memory)[0xFFFF]);
-
-    void SHA_ABSY(int &clk, uint8_t (&memory)[0xFFFF]);
-    void SHA_INDY(int &clk, uint8_t (&memory)[0xFFFF]);
-
-    void SHX_ABSY(int &clk, uint8_t (&memory)[0xFFFF]);
-
-    void SHY_ABSX(int &clk, uint8_t (&memory)[0xFFFF]);
-
-    void SLO_ZP(int &clk, uint8_t (&memory)[0xFFFF]);
-    void SLO_ZPX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void SLO_ABS(int &clk, uint8_t (&memory)[0xFFFF]);
-    void SLO_ABSX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void SLO_ABSY(int &clk, uint8_t (&memory)[0xFFFF]);
-    void SLO_INDX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void SLO_INDY(int &clk, uint8_t (&memory)[0xFFFF]);
-
-    void SRE_ZP(int &clk, uint8_t (&memory)[0xFFFF]);
-    void SRE_ZPX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void SRE_ABS(int &clk, uint8_t (&memory)[0xFFFF]);
-    void SRE_ABSX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void SRE_ABSY(int &clk, uint8_t (&memory)[0xFFFF]);
-    void SRE_INDX(int &clk, uint8_t (&memory)[0xFFFF]);
-    void SRE_INDY(int &clk, uint8_t (&memory)[0xFFFF]);
-
-    void TAS_ABSY(int &clk, uint8_t (&memory)[0xFFFF]);
-
-    void USBC_IM(int &clk, uint8_t (&memory)[0xFFFF]);
-
-    void NOP_0B2C(int &clk, uint8_t (&memory)[0xFFFF]);
-    void NOP_1B2C(int &clk, uint8_t (&memory)[0xFFFF]);
-    void NOP_2B2C(int &clk, uint8_t (&memory)[0xFFFF]);
-    void NOP_1B3C(int &clk, uint8_t (&memory)[0xFFFF]);
-    void NOP_1B4C(int &clk, uint8_t (&memory)[0xFFFF]);
-    void NOP_2B4C(int &clk, uint8_t (&memory)[0xFFFF]); 
-    void NOP_2B45C(int &clk, uint8_t (&memory)[0xFFFF]);
-
-    void JAM(int &clk, uint8_t (&memory)[0xFFFF]);
+    void ALR_IM(int &clk, uint8_t (&memory)[0x10000]);
+    void ANC_IM(int &clk, uint8_t (&memory)[0x10000]);
+    void ANE_IM(int &clk, uint8_t (&memory)[0x10000]);
+    void ARR_IM(int &clk, uint8_t (&memory)[0x10000]);
+
+    void DCP_ZP(int &clk, uint8_t (&memory)[0x10000]);
+    void DCP_ZPX(int &clk, uint8_t (&memory)[0x10000]);
+    void DCP_ABS(int &clk, uint8_t (&memory)[0x10000]);
+    void DCP_ABSX(int &clk, uint8_t (&memory)[0x10000]);
+    void DCP_ABSY(int &clk, uint8_t (&memory)[0x10000]);
+    void DCP_INDX(int &clk, uint8_t (&memory)[0x10000]);
+    void DCP_INDY(int &clk, uint8_t (&memory)[0x10000]);
+
+    void ISC_ZP(int &clk, uint8_t (&memory)[0x10000]);
+    void ISC_ZPX(int &clk, uint8_t (&memory)[0x10000]);
+    void ISC_ABS(int &clk, uint8_t (&memory)[0x10000]);
+    void ISC_ABSX(int &clk, uint8_t (&memory)[0x10000]);
+    void ISC_ABSY(int &clk, uint8_t (&memory)[0x10000]);
+    void ISC_INDX(int &clk, uint8_t (&memory)[0x10000]);
+    void ISC_INDY(int &clk, uint8_t (&memory)[0x10000]);
+
+    void LAS_ABSY(int &clk, uint8_t (&memory)[0x10000]);
+
+    void LAX_ZP(int &clk, uint8_t (&memory)[0x10000]);
+    void LAX_ZPY(int &clk, uint8_t (&memory)[0x10000]);
+    void LAX_ABS(int &clk, uint8_t (&memory)[0x10000]);
+    void LAX_ABSY(int &clk, uint8_t (&memory)[0x10000]);
+    void LAX_INDX(int &clk, uint8_t (&memory)[0x10000]);
+    void LAX_INDY(int &clk, uint8_t (&memory)[0x10000]);
+
+    void LXA_IM(int &clk, uint8_t (&memory)[0x10000]);
+
+    void RLA_ZP(int &clk, uint8_t (&memory)[0x10000]);
+    void RLA_ZPX(int &clk, uint8_t (&memory)[0x10000]);
+    void RLA_ABS(int &clk, uint8_t (&memory)[0x10000]);
+    void RLA_ABSX(int &clk, uint8_t (&memory)[0x10000]);
+    void RLA_ABSY(int &clk, uint8_t (&memory)[0x10000]);
+    void RLA_INDX(int &clk, uint8_t (&memory)[0x10000]);
+    void RLA_INDY(int &clk, uint8_t (&memory)[0x10000]);
+
+    void RRA_ZP(int &clk, uint8_t (&memory)[0x10000]);
+    void RRA_ZPX(int &clk, uint8_t (&memory)[0x10000]);
+    void RRA_ABS(int &clk, uint8_t (&memory)[0x10000]);
+    void RRA_ABSX(int &clk, uint8_t (&memory)[0x10000]);
+    void RRA_ABSY(int &clk, uint8_t (&memory)[0x10000]);
+    void RRA_INDX(int &clk, uint8_t (&memory)[0x10000]);
+    void RRA_INDY(int &clk, uint8_t (&memory)[0x10000]);
+
+    void SAX_ZP(int &clk, uint8_t (&memory)[0x10000]);
+    void SAX_ZPY(int &clk, uint8_t (&memory)[0x10000]);
+    void SAX_ABS(int &clk, uint8_t (&memory)[0x10000]);
+    void SAX_INDX(int &clk, uint8_t (&memory)[0x10000]);
+
+    void SBX_IM(int &clk, uint8_t (&memory)[0x10000]);
+
+    void SHA_ABSY(int &clk, uint8_t (&memory)[0x10000]);
+    void SHA_INDY(int &clk, uint8_t (&memory)[0x10000]);
+
+    void SHX_ABSY(int &clk, uint8_t (&memory)[0x10000]);
+
+    void SHY_ABSX(int &clk, uint8_t (&memory)[0x10000]);
+
+    void SLO_ZP(int &clk, uint8_t (&memory)[0x10000]);
+    void SLO_ZPX(int &clk, uint8_t (&memory)[0x10000]);
+    void SLO_ABS(int &clk, uint8_t (&memory)[0x10000]);
+    void SLO_ABSX(int &clk, uint8_t (&memory)[0x10000]);
+    void SLO_ABSY(int &clk, uint8_t (&memory)[0x10000]);
+    void SLO_INDX(int &clk, uint8_t (&memory)[0x10000]);
+    void SLO_INDY(int &clk, uint8_t (&memory)[0x10000]);
+
+    void SRE_ZP(int &clk, uint8_t (&memory)[0x10000]);
+    void SRE_ZPX(int &clk, uint8_t (&memory)[0x10000]);
+    void SRE_ABS(int &clk, uint8_t (&memory)[0x10000]);
+    void SRE_ABSX(int &clk, uint8_t (&memory)[0x10000]);
+    void SRE_ABSY(int &clk, uint8_t (&memory)[0x10000]);
+    void SRE_INDX(int &clk, uint8_t (&memory)[0x10000]);
+    void SRE_INDY(int &clk, uint8_t (&memory)[0x10000]);
+
+    void TAS_ABSY(int &clk, uint8_t (&memory)[0x10000]);
+
+    void USBC_IM(int &clk, uint8_t (&memory)[0x10000]);
+
+    void NOP_0B2C(int &clk, uint8_t (&memory)[0x10000]);
+    void NOP_1B2C(int &clk, uint8_t (&memory)[0x10000]);
+    void NOP_1B3C(int &clk, uint8_t (&memory)[0x10000]);
+    void NOP_1B4C(int &clk, uint8_t (&memory)[0x10000]);
+    void NOP_2B4C(int &clk, uint8_t (&memory)[0x10000]); 
+    void NOP_2B45C(int &clk, uint8_t (&memory)[0x10000]);
+
+    void JAM(int &clk, uint8_t (&memory)[0x10000]);
 
     opcodeDef opcodes[256] = {
         {&MOS6502::LDA_IM, 0xA9, "LDA_IM"},
@@ -642,10 +854,10 @@ private:
         {&MOS6502::NOP_0B2C, 0xDA, "NOP_0B2C"},
         {&MOS6502::NOP_0B2C, 0xFA, "NOP_0B2C"},
         {&MOS6502::NOP_1B2C, 0x80, "NOP_1B2C"},
-        {&MOS6502::NOP_2B2C, 0x82, "NOP_2B2C"},
-        {&MOS6502::NOP_2B2C, 0x89, "NOP_2B2C"},
-        {&MOS6502::NOP_2B2C, 0xC2, "NOP_2B2C"},
-        {&MOS6502::NOP_2B2C, 0xE2, "NOP_2B2C"},
+        {&MOS6502::NOP_1B2C, 0x82, "NOP_1B2C"},
+        {&MOS6502::NOP_1B2C, 0x89, "NOP_1B2C"},
+        {&MOS6502::NOP_1B2C, 0xC2, "NOP_1B2C"},
+        {&MOS6502::NOP_1B2C, 0xE2, "NOP_1B2C"},
         {&MOS6502::NOP_1B3C, 0x04, "NOP_1B3C"},
         {&MOS6502::NOP_1B3C, 0x44, "NOP_1B3C"},
         {&MOS6502::NOP_1B3C, 0x64, "NOP_1B3C"},
@@ -0,0 +1,116 @@
+#pragma once
+#include <stdint.h>
+#include <iostream>
+#include <string>
+
+class Controller;
+
+// One frame of input: console commands and the buttons of both joypads,
+// with the checksum of the state after the frame when the movie has them
+struct MovieFrame
+{
+    // Same values as the FM2 command field
+    enum Commands
+    {
+        commandReset = 0x01,
+        commandPower = 0x02
+    };
+
+    uint8_t commands = 0;
+    uint8_t buttons[2] = {};
+    bool hashed = false;
+    uint64_t hash = 0;
+};
+
+// Movies are read a frame at a time, never loaded whole
+class MovieSource
+{
+public:
+    virtual ~MovieSource() = default;
+    // False at the end of the movie or on a malformed frame
+    virtual bool next(MovieFrame &frame) = 0;
+    virtual bool valid() const = 0;
+};
+
+// Binary movies (.nmv), little endian:
+//   header  "NMV\x1A", version, ports, flags, 0, ROM checksum (8 bytes)
+//   frames  commands, buttons per port[, state checksum (8 bytes)]
+// Records have a fixed size and the frame count is wherever the file ends,
+// so recording only ever appends
+class MovieReader : public MovieSource
+{
+public:
+    explicit MovieReader(std::istream &in);
+    bool next(MovieFrame &frame) override;
+    bool valid() const override;
+    int ports() const;
+    bool hashes() const;
+    uint64_t romChecksum() const;
+
+private:
+    std::istream &in;
+    bool ok = false;
+    int portCount = 0;
+    bool hashed = false;
+    uint64_t rom = 0;
+};
+
+class MovieWriter
+{
+public:
+    static const uint8_t VERSION = 1;
+    enum Flags
+    {
+        flagHashes = 0x01
+    };
+
+    MovieWriter(std::ostream &out, int ports, bool hashes, uint64_t romChecksum);
+    bool write(const MovieFrame &frame);
+
+private:
+    std::ostream &out;
+    int ports;
+    bool hashes;
+};
+
+// FCEUX text movies (.fm2): "key value" header lines, then one
+// "|commands|RLDUTSBA|RLDUTSBA|expansion|" line per frame, any character
+// but '.' or ' ' meaning pressed. Binary FM2 and the Four Score aren't
+// supported
+class FM2Reader : public MovieSource
+{
+public:
+    explicit FM2Reader(std::istream &in);
+    bool next(MovieFrame &frame) override;
+    bool valid() const override;
+
+private:
+    std::istream &in;
+    bool ok = true;
+    bool gamepad[2] = {true, true};
+    std::string pending;
+};
+
+// Plays a movie as fast as the controller runs. Movies with checksums stop
+// at the first frame whose state differs; a recorder gets every frame
+// played, with the checksum of the state after it
+class MoviePlayer
+{
+public:
+    MoviePlayer(Controller &controller, MovieSource &movie, MovieWriter *recorder = nullptr);
+    // Plays one frame, false at the end of the movie or on a desync
+    bool step();
+    uint64_t frames() const;
+    bool desynced() const;
+    uint64_t expected() const;
+    uint64_t actual() const;
+
+private:
+    Controller &controller;
+    MovieSource &movie;
+    MovieWriter *recorder;
+    uint64_t played = 0;
+    bool mismatch = false;
+    uint64_t expectedHash = 0;
+    uint64_t actualHash = 0;
+};
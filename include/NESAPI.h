@@ -0,0 +1,111 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// C interface for driving emulators from other languages, e.g. as
+// reinforcement learning environments. Instances are independent; one
+// instance must only be used from one thread at a time, nes_step_many()
+// steps many of them on a shared thread pool.
+// Observations are zero copy pointers into the emulator, valid until the
+// instance is stepped, loaded or destroyed, or copies into caller buffers
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct nes nes_t;
+
+// Frames are NES colour indices ($00-$3F), one byte per pixel, row major
+#define NES_FRAME_WIDTH 256
+#define NES_FRAME_HEIGHT 240
+#define NES_FRAME_SIZE (NES_FRAME_WIDTH * NES_FRAME_HEIGHT)
+#define NES_RAM_SIZE 0x800
+
+// Actions are the joypad bits, two bytes per instance: ports 0 and 1
+#define NES_BUTTON_A 0x01
+#define NES_BUTTON_B 0x02
+#define NES_BUTTON_SELECT 0x04
+#define NES_BUTTON_START 0x08
+#define NES_BUTTON_UP 0x10
+#define NES_BUTTON_DOWN 0x20
+#define NES_BUTTON_LEFT 0x40
+#define NES_BUTTON_RIGHT 0x80
+
+// Which frames of a step are drawn, the others cost no pixel work
+enum nes_render
+{
+    NES_RENDER_OFF,
+    NES_RENDER_LAST, // the last frame of every step, the default
+    NES_RENDER_ALL
+};
+
+// NULL if the file isn't an iNES image
+nes_t *nes_create(const char *rom_path);
+void nes_destroy(nes_t *nes);
+// Reset button
+void nes_reset(nes_t *nes);
+void nes_set_render(nes_t *nes, enum nes_render mode);
+
+// Holds actions[0] and actions[1] on the joypads for a number of frames
+void nes_step(nes_t *nes, const uint8_t *actions, int frames);
+// Steps count instances, instances[i] with actions[2 * i] and [2 * i + 1].
+// With observations, each instance's observation is written to
+// observations + i * nes_observation_size() by the thread that stepped it;
+// the instances must all be configured alike
+void nes_step_many(nes_t *const *instances, int count, const uint8_t *actions, int frames, uint8_t *observations);
+// Threads nes_step_many() runs on, the caller included, 0 for one per
+// hardware thread (the default). Not while a batch is running
+void nes_set_threads(int threads);
+
+// NES_RAM_SIZE bytes of CPU RAM
+const uint8_t *nes_get_ram(nes_t *nes);
+// The last drawn frame, NULL while rendering is off
+const uint8_t *nes_get_frame(nes_t *nes);
+// Copies of the same into NES_RAM_SIZE / NES_FRAME_SIZE byte buffers,
+// 0 on success
+int nes_copy_ram(nes_t *nes, uint8_t *buffer);
+int nes_copy_frame(nes_t *nes, uint8_t *buffer);
+// Grayscale observations computed from the frames as they're drawn: crop,
+// max of the last two frames, area-average resize, the last few stacked
+typedef struct nes_observation
+{
+    // Pixels removed from each edge
+    int crop_top, crop_bottom, crop_left, crop_right;
+    // 0 keeps the cropped size
+    int width, height;
+    // Maximum of the last two frames of the step, both are then drawn
+    int max_pool;
+    // Images per observation, oldest first, at least 1
+    int stack;
+} nes_observation;
+
+// NULL goes back to raw frames. Turns rendering on if it was off, and
+// -1 for an invalid config. Reset and loading a state clear the stack
+int nes_set_observation(nes_t *nes, const nes_observation *config);
+// stack * height * width bytes, NES_FRAME_SIZE for raw frames
+size_t nes_observation_size(nes_t *nes);
+// 0 on success, -1 while rendering is off
+int nes_get_observation(nes_t *nes, uint8_t *buffer);
+
+// Frames run since power on
+uint64_t nes_frame_count(nes_t *nes);
+// Of RAM, CPU registers and PPU state, to compare runs
+uint64_t nes_checksum(nes_t *nes);
+
+// Of RAM, PRG RAM, the PPU memories and the registers, without timing, to
+// spot game states a search has already reached. A full rehash per call
+// until tracking is enabled, then O(1)
+void nes_set_state_hashing(nes_t *nes, int enabled);
+uint64_t nes_state_hash(nes_t *nes);
+// Leaves [first, last] out of the state hash, e.g. frame counters or RNG
+void nes_mask_state_hash(nes_t *nes, uint16_t first, uint16_t last);
+
+// States are nes_state_size() bytes, only valid for the same build and
+// ROM. Both return 0 on success, -1 for a short buffer or, on load, a
+// state from another build or ROM
+size_t nes_state_size(void);
+int nes_save_state(nes_t *nes, void *buffer, size_t size);
+int nes_load_state(nes_t *nes, const void *buffer, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
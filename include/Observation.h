@@ -0,0 +1,83 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+// Downsampled grayscale observations, computed straight from rendered
+// frames of colour indices: crop, grayscale through a palette table,
+// optionally the maximum of the last two frames (sprites that flicker
+// show in both), area-average resize, and a ring of the last few results.
+// The loops run over whole rows of bytes so the compiler vectorises them
+class Observation
+{
+public:
+    struct Config
+    {
+        // Pixels removed from each edge of the 256x240 frame
+        int cropTop = 0;
+        int cropBottom = 0;
+        int cropLeft = 0;
+        int cropRight = 0;
+        // 0 keeps the cropped size
+        int width = 0;
+        int height = 0;
+        bool maxPool = false;
+        int stack = 1;
+    };
+
+    // False if the crop leaves nothing or a size is negative
+    static bool valid(const Config &config);
+    // Luminance of each colour index with the palette the screenshots use
+    static const uint8_t *grayPalette();
+
+    explicit Observation(const Config &config);
+
+    const Config &config() const;
+    int width() const;
+    int height() const;
+    // Bytes write() produces, stack * height * width
+    size_t size() const;
+
+    // A rendered frame; only the last two are kept, for max pooling
+    void frame(const uint8_t *pixels);
+    // Appends the resized last frame, or maximum of the last two, to the ring
+    void push();
+    // The ring, oldest first, as stack images of height rows of width
+    void write(uint8_t *out) const;
+    // Zeroes the ring and the kept frames
+    void clear();
+
+private:
+    // Source pixel and its share of an output pixel, out of WEIGHTONE
+    struct Tap
+    {
+        uint16_t source;
+        uint16_t weight;
+    };
+
+    static const int WEIGHTBITS = 8;
+    static const int WEIGHTONE = 1 << WEIGHTBITS;
+
+    Config settings;
+    int cropWidth;
+    int cropHeight;
+    int outWidth;
+    int outHeight;
+
+    // Cropped grayscale frames, the latest is gray[latest]
+    std::vector<uint8_t> gray[2];
+    int latest = 0;
+    std::vector<uint8_t> pooled;
+    // Taps of output column/row i are taps[first[i]] .. taps[first[i + 1] - 1]
+    std::vector<Tap> columnTaps;
+    std::vector<int> columnFirst;
+    std::vector<Tap> rowTaps;
+    std::vector<int> rowFirst;
+    std::vector<uint16_t> rowSums;
+
+    std::vector<uint8_t> ring;
+    int head = 0;
+
+    static void areaTaps(int sourceSize, int outSize, std::vector<Tap> &taps, std::vector<int> &first);
+    void resize(const uint8_t *source, uint8_t *out);
+};
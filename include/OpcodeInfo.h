@@ -0,0 +1,46 @@
+#pragma once
+#include <stdint.h>
+
+// Static description of every opcode, shared by the CPU (bus-accurate mode),
+// tools and anything else that needs to decode 6502 code without a CPU instance
+
+enum AddrMode
+{
+    implied,
+    accumulator,
+    immediate,
+    zeroPage,
+    zeroPageX,
+    zeroPageY,
+    absolute,
+    absoluteX,
+    absoluteY,
+    indirect,
+    indirectX,
+    indirectY,
+    relative
+};
+
+// What the instruction does at its effective address
+enum AccessType
+{
+    noAccess,
+    readAccess,
+    writeAccess,
+    rmwAccess
+};
+
+struct OpcodeInfo
+{
+    const char *mnemonic;
+    AddrMode mode;
+    AccessType access;
+    uint8_t cycles; // base cycles, without page cross or branch penalties
+    bool illegal;
+};
+
+extern const OpcodeInfo opcodeInfo[256];
+
+// Instruction length in bytes, opcode included
+int instructionLength(AddrMode mode);
+const char *addrModeName(AddrMode mode);
@@ -0,0 +1,90 @@
+#pragma once
+#include <OpcodeInfo.h>
+#include <stdint.h>
+#include <iostream>
+#include <vector>
+
+// Opcode mix of a workload: executions and cycles per opcode, page cross
+// penalties, branches taken, and the most frequent opcode pairs and
+// triples. Penalties are recovered from the cycles each instruction took
+// against its base count, so the addressing mode helpers stay untouched.
+// One collector per CPU, merge() them once the runs are over
+class OpcodeStats
+{
+public:
+    OpcodeStats();
+    void clear();
+    void merge(const OpcodeStats &other);
+
+    // Called by the CPU at every instruction boundary while attached
+    void step(uint16_t PC, int clk, const uint8_t (&memory)[0x10000])
+    {
+        if (started && !interrupted) {
+            uint8_t opcode = lastOpcode;
+            int extra = clk - lastClk - opcodeInfo[opcode].cycles;
+            counts[opcode].executions++;
+            counts[opcode].cycles += clk - lastClk;
+            if (extra > 0)
+                penalty(opcode, extra);
+            if (executed >= 1)
+                pairs[(previous & 0xFF) << 8 | opcode]++;
+            if (executed >= 2)
+                countTriple(((previous & 0xFFFF) << 8) | opcode);
+            previous = (previous << 8) | opcode;
+            executed++;
+        }
+        started = true;
+        interrupted = false;
+        lastOpcode = memory[PC];
+        lastClk = clk;
+    }
+
+    // An interrupt sequence isn't an instruction, its cycles are dropped
+    void interrupt(int clk)
+    {
+        interrupted = true;
+        lastClk = clk;
+    }
+
+    uint64_t instructions() const;
+    // Most frequent pairs, first opcode in the high byte, by descending count
+    std::vector<std::pair<uint16_t, uint64_t>> topPairs(size_t count) const;
+    // Machine readable summary, top pairs and triples only
+    void writeJSON(std::ostream &out, size_t top = 64);
+
+private:
+    struct Counter
+    {
+        uint64_t executions;
+        uint64_t cycles;
+        uint64_t pageCrosses;
+        uint64_t branchesTaken;
+        uint64_t extraCycles; // cycles added outside the instruction (DMA)
+    };
+
+    // Open addressed, the triples a program actually uses are a small subset
+    static const size_t TRIPLESLOTS = 1 << 16;
+    static const uint32_t EMPTY = 0xFFFFFFFF;
+
+    struct Triple
+    {
+        uint32_t key;
+        uint64_t count;
+    };
+
+    Counter counts[256];
+    std::vector<uint64_t> pairs;
+    std::vector<Triple> triples;
+    size_t triplesUsed = 0;
+    uint64_t triplesDropped = 0;
+
+    bool started = false;
+    bool interrupted = false;
+    uint8_t lastOpcode = 0;
+    int lastClk = 0;
+    uint32_t previous = 0;
+    uint64_t executed = 0;
+
+    void penalty(uint8_t opcode, int extra);
+    void countTriple(uint32_t key, uint64_t count = 1);
+};
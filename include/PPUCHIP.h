@@ -1,9 +1,150 @@
 #pragma once
+#include <PPURenderer.h>
+#include <SpriteLists.h>
+#include <stdint.h>
+#include <iostream>
+#include <fstream>
+#include <vector>
+
+class Coverage;
+class StateHash;
 
 class PPUCHIP
 {
 public:
     PPUCHIP();
     bool NMI_occurred;
+
+    void loadCHR(std::ifstream &ROM, int size, bool verticalMirroring);
+    // Reset line: PPUCTRL, PPUMASK, the write toggle and the read buffer clear
+    void reset();
+
+    // CPU visible registers $2000-$2007
+    uint8_t readRegister(uint16_t addr);
+    void writeRegister(uint16_t addr, uint8_t value);
+    // OAM DMA ($4014) writes through OAMDATA
+    void writeOAM(uint8_t value);
+
+    // Advances the PPU by a number of dots (3 per CPU cycle on NTSC).
+    // NMI_occurred follows the /NMI output: vblank flag and NMI enable
+    void tick(int dots);
+    uint64_t getFrame() const;
+    // Dots until the next vblank, sprite 0 or frame edge, before which the
+    // PPU can't change anything the CPU sees
+    int dotsUntilEvent();
+    // CHR reads through PPUDATA, and the tiles of every rendered frame
+    void setCoverage(Coverage *coverage);
+    // Registers, timing and memories folded into hash, see Hash.h
+    uint64_t hash(uint64_t hash) const;
+    // Writes to nametables, palette, OAM and CHR RAM update the state hash
+    // while one is attached
+    void setStateHash(StateHash *hash);
+    // Adds those memories to a state hash being rebuilt
+    void rehash(StateHash &hash) const;
+    // Registers without the timing, the part of the state hash that isn't
+    // followed write by write
+    uint64_t registerHash(uint64_t hash) const;
+
+    // Changes to the rendering inputs are appended to the log while one is
+    // attached, a renderer starting from inputs() replays them
+    void setRenderLog(std::vector<PPUWrite> *log);
+    void inputs(PPUInputs &inputs) const;
+
+    // Registers, timing and memories for save states. The cartridge's
+    // mirroring and CHR type aren't part of it, CHR is copied either way
+    struct State
+    {
+        bool NMI_occurred;
+        uint8_t ctrl, mask, status, oamAddr;
+        uint16_t v, t;
+        uint8_t fineX;
+        bool w;
+        uint8_t readBuffer;
+        bool oddFrame;
+        int32_t scanline, dot;
+        uint64_t frame;
+        uint16_t frameT;
+        uint8_t frameFineX;
+        uint8_t CHR[0x2000];
+        uint8_t nametables[0x800];
+        uint8_t palette[32];
+        uint8_t OAM[256];
+    };
+
+    void saveState(State &state) const;
+    void loadState(const State &state);
+
 private:
-};
\ No newline at end of file
+    static const int DOTS = 341;
+    static const int SCANLINES = 262;
+    static const int VBLANKSET = 241 * DOTS + 1;
+    static const int VBLANKCLEAR = 261 * DOTS + 1;
+
+    enum Registers
+    {
+        PPUCTRL,
+        PPUMASK,
+        PPUSTATUS,
+        OAMADDR,
+        OAMDATA,
+        PPUSCROLL,
+        PPUADDR,
+        PPUDATA
+    };
+
+    uint8_t ctrl = 0;
+    uint8_t mask = 0;
+    uint8_t status = 0;
+    uint8_t oamAddr = 0;
+
+    // Loopy registers: current/temporary VRAM address, fine X scroll, write toggle
+    uint16_t v = 0;
+    uint16_t t = 0;
+    uint8_t fineX = 0;
+    bool w = false;
+    uint8_t readBuffer = 0;
+
+    int scanline = 0;
+    int dot = 0;
+    bool oddFrame = false;
+    uint64_t frame = 0;
+
+    // Sprite 0 hit and overflow are predicted on the CPU side, hit from
+    // the scroll the frame started with, so reading $2002 never waits for
+    // the renderer. Writes that can move them mark the prediction stale
+    uint16_t frameT = 0;
+    uint8_t frameFineX = 0;
+    int hitDot = -1;
+    int overflowDot = -1;
+    bool predictionStale = true;
+    // OAM or the sprite size changed since the sprite lists were built
+    bool oamDirty = true;
+    SpriteLists spriteLists;
+
+    uint8_t CHR[0x2000] = {};
+    bool CHRRAM = true;
+    bool verticalMirroring = false;
+    uint8_t nametables[0x800] = {};
+    uint8_t palette[32] = {};
+    uint8_t OAM[256] = {};
+    Coverage *coverage = nullptr;
+    StateHash *stateHash = nullptr;
+    std::vector<PPUWrite> *renderLog = nullptr;
+
+    void logWrite(uint8_t kind, uint16_t addr, uint8_t value)
+    {
+        if (renderLog)
+            renderLog->push_back({(uint32_t)(scanline * DOTS + dot), addr, kind, value});
+    }
+
+    void updateNMI();
+    void predict();
+    int sprite0HitDot();
+    int spriteOverflowDot();
+    int predictSprite0Hit() const;
+    bool backgroundOpaque(int x, int line) const;
+    void coverFrame();
+    uint16_t nametableAddr(uint16_t addr) const;
+    uint8_t ppuRead(uint16_t addr);
+    void ppuWrite(uint16_t addr, uint8_t value);
+};
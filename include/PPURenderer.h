@@ -0,0 +1,118 @@
+#pragma once
+#include <SpriteLists.h>
+#include <stdint.h>
+#include <stddef.h>
+
+// A change to something rendering reads, logged by the PPU when the CPU
+// makes it and stamped with the frame position (scanline * 341 + dot)
+struct PPUWrite
+{
+    enum Kind : uint8_t
+    {
+        writeCtrl,
+        writeMask,
+        writeScroll, // addr is t, value fine X
+        writeAddr,   // addr is v, after the second $2006 write
+        writeVRAM,   // addr is the PPU address
+        writeOAM
+    };
+
+    uint32_t dot;
+    uint16_t addr;
+    uint8_t kind;
+    uint8_t value;
+};
+
+// Everything rendering depends on, copied from the PPU when rendering starts
+struct PPUInputs
+{
+    uint8_t ctrl = 0;
+    uint8_t mask = 0;
+    uint16_t t = 0;
+    uint16_t v = 0;
+    uint8_t fineX = 0;
+    bool verticalMirroring = false;
+    bool CHRRAM = true;
+    uint8_t CHR[0x2000] = {};
+    uint8_t nametables[0x800] = {};
+    uint8_t palette[32] = {};
+    uint8_t OAM[256] = {};
+};
+
+// Scanline renderer. Replays a frame's log against its own copy of the
+// inputs and writes NES colour indices ($00-$3F), so the same log renders
+// the same pixels whichever thread runs it. Changes made during a line show
+// from the next one; v follows $2006 and the loopy updates at dots 256, 257
+// and 280-304 of the rendering lines
+class PPURenderer
+{
+public:
+    static const int WIDTH = 256;
+    static const int HEIGHT = 240;
+
+    void load(const PPUInputs &inputs);
+    // Without pixels the frame is skipped: the log and the scroll updates
+    // still apply, so the next frame starts from the same inputs
+    void renderFrame(const PPUWrite *log, size_t count, uint8_t *pixels);
+
+    // Lines whose inputs are the same as when they were last drawn into
+    // the same buffer are left as they are. With verify they're drawn
+    // anyway into a scratch line and compared
+    void setLineReuse(bool enabled, bool verify = false);
+
+    struct Stats
+    {
+        uint64_t linesDrawn = 0;
+        uint64_t linesReused = 0;
+        uint64_t reuseMismatches = 0; // verify only
+    };
+    const Stats &stats() const;
+
+private:
+    static const int DOTS = 341;
+    static const int PRERENDER = 261;
+
+    PPUInputs state;
+    const PPUWrite *next = nullptr;
+    const PPUWrite *last = nullptr;
+
+    // Everything a line's pixels depend on. Memories are stood for by
+    // version counters bumped on every write: per nametable row (attribute
+    // writes bump the four rows they cover), palette and CHR RAM
+    struct LineKey
+    {
+        uint16_t v;
+        uint8_t fineX;
+        uint8_t ctrl;
+        uint8_t mask;
+        uint8_t spriteCount;
+        uint8_t sprites[8 * 4];
+        uint32_t rowVersions[2];
+        uint32_t paletteVersion;
+        uint32_t CHRVersion;
+    };
+
+    // Rebuilt on the first line drawn after OAM or the sprite size changes
+    SpriteLists spriteLists;
+    bool spritesStale = true;
+
+    bool reuse = false;
+    bool verify = false;
+    Stats counters;
+    const uint8_t *lastPixels = nullptr;
+    LineKey keys[HEIGHT];
+    bool keyValid[HEIGHT] = {};
+    uint32_t rowVersions[2][32] = {};
+    uint32_t paletteVersion = 0;
+    uint32_t CHRVersion = 0;
+
+    bool rendering() const;
+    void applyUntil(uint32_t dot);
+    void apply(const PPUWrite &write);
+    uint16_t nametableAddr(uint16_t addr) const;
+    void incrementY();
+    int evaluateSprites(int line, int (&found)[8]);
+    void lineKey(int line, const int (&found)[8], int count, LineKey &key) const;
+    void renderLine(int line, uint8_t *pixels);
+    void drawLine(int line, const int (&found)[8], int count, uint8_t *pixels) const;
+};
@@ -0,0 +1,104 @@
+#pragma once
+#include <stdint.h>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+// Guest profiler: instructions and cycles per PC in flat 64K arrays, and a
+// call tree built from JSR/RTS, BRK/IRQ/NMI/RTI frames so cycles can be
+// attributed to 6502 subroutines. The CPU calls step() at every instruction
+// boundary while a profiler is attached
+class Profiler
+{
+public:
+    enum FrameKind
+    {
+        frameRoot,
+        frameJSR,
+        frameBRK,
+        frameIRQ,
+        frameNMI,
+        frameReset
+    };
+
+    Profiler();
+    void clear();
+
+    // Attributes the cycles since the last boundary to the previous instruction
+    // and follows the call or return it made. Inline, it runs for every instruction
+    void step(uint16_t PC, uint8_t SP, int clk, const uint8_t (&memory)[0x10000])
+    {
+        if (started) {
+            uint64_t cycles = clk - lastClk;
+            counters[lastPC].cycles += cycles;
+            top->cycles += cycles;
+            if (!interrupted) {
+                counters[lastPC].instructions++;
+                top->instructions++;
+                if (isCallOrReturn(lastOpcode))
+                    followCall(PC, SP);
+            }
+        }
+        started = true;
+        interrupted = false;
+        lastPC = PC;
+        lastOpcode = memory[PC];
+        lastClk = clk;
+    }
+    // Hardware interrupt taken, PC is the handler and SP is after the pushes
+    void interrupt(uint16_t PC, uint8_t SP, FrameKind kind);
+
+    // Hottest instructions and subroutines
+    void report(std::ostream &out, size_t top = 20);
+    // One line per call stack, "frame;frame;frame cycles", for flame graph tools
+    void writeCollapsed(std::ostream &out);
+
+private:
+    struct Node
+    {
+        int parent;
+        uint16_t entry;
+        FrameKind kind;
+        uint64_t calls;
+        uint64_t cycles; // self
+        uint64_t instructions;
+    };
+
+    struct Frame
+    {
+        int node;
+        uint8_t returnSP; // SP once the frame has returned
+    };
+
+    static const size_t MAXDEPTH = 256;
+
+    struct Counter
+    {
+        uint64_t instructions;
+        uint64_t cycles;
+    };
+
+    std::vector<Counter> counters;
+    std::vector<Node> nodes;
+    std::unordered_map<uint64_t, int> children;
+    std::vector<Frame> stack;
+    Node *top;
+
+    bool started = false;
+    bool interrupted = false; // the last boundary took an interrupt instead of an instruction
+    uint16_t lastPC = 0;
+    uint8_t lastOpcode = 0;
+    int lastClk = 0;
+
+    // BRK $00, JSR $20, RTI $40, RTS $60
+    static bool isCallOrReturn(uint8_t opcode)
+    {
+        return (opcode & 0x9F) == 0;
+    }
+    void followCall(uint16_t PC, uint8_t SP);
+    void call(uint16_t entry, uint8_t returnSP, FrameKind kind);
+    void ret(uint8_t SP);
+    int child(int parent, uint16_t entry, FrameKind kind);
+    std::string frameName(const Node &node);
+};
@@ -0,0 +1,84 @@
+#pragma once
+#include <PPURenderer.h>
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Renders the frames the PPU logs. Serial pipelines render a frame when
+// its log is submitted. Threaded ones hand the log to a render thread
+// through a single producer, single consumer ring and return at once, so
+// the CPU runs up to LOGS - 1 frames ahead; it only waits when the ring
+// is full. Both replay the same logs through the same renderer, so the
+// pixels are identical.
+// Frames can be skipped: every Nth is drawn, or only those asked for. The
+// renderer still replays a skipped frame's log, but composes no pixels;
+// nothing the CPU can see depends on it
+class RenderPipeline
+{
+public:
+    RenderPipeline(const PPUInputs &start, bool threaded);
+    ~RenderPipeline();
+
+    // The log of the frame the CPU is running
+    std::vector<PPUWrite> *log();
+    // Queues the current log for rendering and starts the next
+    void submit();
+    // Draw every Nth frame, 1 for all of them, 0 only for request()
+    void setSkip(int every);
+    // Draw the frame being run whatever the skip setting
+    void request();
+    // See PPURenderer::setLineReuse, both wait for the render thread
+    void setLineReuse(bool enabled, bool verify);
+    PPURenderer::Stats stats();
+    // Waits until every submitted frame is rendered
+    void flush();
+    // Drops the current log and renders on from new inputs, after the
+    // emulator loaded a state
+    void restart(const PPUInputs &start);
+
+    // The last drawn frame, colour indices. Threaded pipelines need a
+    // flush() first
+    const uint8_t *pixels() const;
+    uint64_t framesRendered() const;
+    uint64_t framesDrawn() const;
+    // Of every frame drawn so far, to compare pipelines
+    uint64_t checksum() const;
+
+private:
+    static const int LOGS = 4;
+    static const size_t LOGRESERVE = 4096;
+    static const int SPINS = 1000;
+
+    PPURenderer renderer;
+    bool threaded;
+    std::vector<PPUWrite> logs[LOGS];
+    // Set with the log, read by the render thread once it's submitted
+    bool draw[LOGS] = {};
+    int every = 1;
+    bool requested = false;
+    std::atomic<uint64_t> drawn{0};
+    uint8_t frame[PPURenderer::WIDTH * PPURenderer::HEIGHT];
+    uint64_t hash;
+
+    // Frame n's log is logs[n % LOGS]: the CPU fills submitted, the render
+    // thread works through rendered .. submitted - 1
+    std::atomic<uint64_t> submitted{0};
+    std::atomic<uint64_t> rendered{0};
+    std::atomic<bool> stopping{false};
+
+    // Only for sleeping once spinning didn't help, neither side takes the
+    // lock unless the other one is asleep
+    std::atomic<int> sleepers{0};
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::thread worker;
+
+    void render(uint64_t n);
+    void renderLoop();
+    template<typename Ready>
+    void waitFor(Ready ready);
+    void notify();
+};
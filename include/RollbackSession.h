@@ -0,0 +1,114 @@
+#pragma once
+#include <Controller.h>
+#include <stdint.h>
+#include <deque>
+#include <random>
+#include <vector>
+#include <netinet/in.h>
+
+// Two player rollback netplay over UDP. Each side sends its inputs every
+// frame, repeating those the peer hasn't acknowledged, so lost packets
+// only delay them. The peer's input is predicted to stay the same; once
+// the real one arrives and differs, the state saved before that frame is
+// loaded and the frames since are run again, undrawn. Sides never run
+// more than maxRollback frames past the peer's last known input.
+// Each packet also carries the checksum of the newest frame whose inputs
+// are all known, compared against the local one to detect desyncs
+class RollbackSession
+{
+public:
+    // Simulated network on sent packets: delay in polls (advance() or
+    // poll() calls, one per frame when paced), loss as a probability
+    struct Conditions
+    {
+        int delay = 0;
+        double loss = 0;
+        uint32_t seed = 1;
+    };
+
+    struct Stats
+    {
+        uint64_t rollbacks = 0;
+        uint64_t resimulated = 0; // frames run again
+        int deepest = 0;          // most frames run again at once
+        uint64_t stalls = 0;      // advance() calls waiting for the peer
+        uint64_t sent = 0;
+        uint64_t dropped = 0;
+        uint64_t received = 0;
+        double slowestAdvance = 0; // seconds, rollback included
+    };
+
+    // Unacknowledged inputs can reach about twice the rollback limit plus
+    // the delay, and have to stay in the input ring
+    static const int MAXROLLBACK = 48;
+
+    // The local player is on joypad port player, the peer on the other,
+    // maxRollback is capped to MAXROLLBACK
+    RollbackSession(Controller &console, int player, int maxRollback);
+    ~RollbackSession();
+    // UDP on 127.0.0.1 (or remoteHost), false if the port can't be bound
+    bool open(int localPort, int remotePort, const char *remoteHost = "127.0.0.1");
+    void setConditions(const Conditions &conditions);
+
+    // Runs the next frame with the local input and draws it. False, and
+    // no frame run, while that would be too far past the peer
+    bool advance(uint8_t buttons);
+    // Exchanges packets and rolls back for late inputs, without a new frame
+    void poll();
+
+    uint64_t frame() const;
+    // Frames whose inputs are all known and simulated as such
+    uint64_t confirmedFrame() const;
+    // Newest frame whose checksum matched the peer's, -1 before any
+    int64_t checkedFrame() const;
+    bool desynced() const;
+    uint64_t desyncFrame() const;
+    const Stats &stats() const;
+
+private:
+    static const int WINDOW = 256;
+    static const int MAXINPUTS = 64;
+    static const uint16_t MAGIC = 0x524E; // "NR"
+    static const uint64_t NONE = ~0ULL;
+
+    struct Packet
+    {
+        uint64_t release;
+        std::vector<uint8_t> bytes;
+    };
+
+    Controller &console;
+    int player;
+    int maxRollback;
+    int socket = -1;
+    sockaddr_in remote = {};
+    Conditions conditions;
+    std::mt19937 rng;
+    std::deque<Packet> outgoing;
+    uint64_t polls = 0;
+
+    uint64_t current = 0;      // frames run
+    uint64_t remoteKnown = 0;  // peer inputs known for frames before this
+    uint64_t peerAck = 0;      // the peer knows ours before this
+    uint64_t firstWrong = NONE;
+    uint8_t localInputs[WINDOW] = {};
+    uint8_t remoteInputs[WINDOW] = {};
+    uint8_t used[WINDOW] = {}; // peer input each frame ran with
+    uint64_t hashes[WINDOW] = {};
+    std::vector<Controller::SaveState> states;
+
+    uint64_t remoteHashFrame = NONE;
+    uint64_t remoteHash = 0;
+    int64_t checked = -1;
+    bool desync = false;
+    uint64_t desyncAt = 0;
+    Stats counters;
+
+    uint8_t predicted() const;
+    void runFrame(uint64_t frame, bool draw);
+    void receive();
+    void rollback();
+    void checkHash();
+    void send();
+    void flush();
+};
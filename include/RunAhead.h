@@ -0,0 +1,46 @@
+#pragma once
+#include <Controller.h>
+#include <stdint.h>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Run-ahead: every frame the console runs the real frame without drawing
+// it, saves its state, runs ahead with the same input and draws only the
+// last of those frames, then loads the state back. What's shown is where
+// the game will be that many frames later if the input doesn't change,
+// which hides as many frames of the game's own input lag.
+// With a second console of the same ROM the frames ahead run on a worker
+// thread from the saved state, the caller only waits for them in
+// framePixels(). Both ways show the same frames
+class RunAhead
+{
+public:
+    // Sets up the consoles' rendering: only the frames shown are drawn
+    RunAhead(Controller &console, int frames, Controller *second = nullptr);
+    ~RunAhead();
+
+    void setButtons(int port, uint8_t buttons);
+    // The real frame, then the frames ahead, or hands them to the worker
+    void runFrame();
+    // The frame to show, colour indices as Controller::framePixels()
+    const uint8_t *framePixels();
+
+private:
+    Controller &console;
+    Controller *second;
+    int frames;
+    std::unique_ptr<Controller::SaveState> state;
+
+    // Second console only: the worker runs ahead from state once started
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool pending = false;
+    bool stopping = false;
+    std::thread worker;
+
+    void runAhead(Controller &from);
+    void waitIdle();
+    void workerLoop();
+};
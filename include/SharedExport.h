@@ -0,0 +1,98 @@
+#pragma once
+#include <PPURenderer.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <string>
+
+class Controller;
+
+// Layout of an export segment: a header and two slots the writer fills in
+// turn. Each slot is a seqlock, its sequence is odd while it's written, so
+// a reader can use the latest slot in place and only has to check the
+// sequence didn't move once it's done; the writer only comes back to the
+// slot after filling the other one, a frame later
+struct SharedFrames
+{
+    static const uint32_t MAGIC = 0x5846454E; // "NEFX"
+    static const uint32_t VERSION = 1;
+    static const int SLOTS = 2;
+    static const int RAMSIZE = 0x800;
+
+    struct Slot
+    {
+        std::atomic<uint32_t> sequence;
+        uint32_t hasFrame; // 0 while the writer isn't rendering
+        uint64_t frame;
+        // Of ram then pixels, 0 when the writer doesn't hash
+        uint64_t hash;
+        uint8_t ram[RAMSIZE];
+        uint8_t pixels[PPURenderer::WIDTH * PPURenderer::HEIGHT];
+    };
+
+    uint32_t magic;
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t writer; // pid
+    std::atomic<uint32_t> latest; // slot of the newest snapshot
+    std::atomic<uint32_t> published; // snapshots so far
+    std::atomic<uint32_t> closed;
+    Slot slots[SLOTS];
+};
+
+// Publishes a console's RAM and last frame to a POSIX shared memory
+// segment, e.g. "/nes0", after every frame. The segment is removed when
+// the export is destroyed
+class SharedExport
+{
+public:
+    ~SharedExport();
+    // False if the segment can't be created and mapped
+    bool open(const std::string &name, bool hashed = false);
+    void publish(Controller &controller);
+    // Tells readers no more snapshots will come
+    void close();
+
+private:
+    std::string name;
+    SharedFrames *shared = nullptr;
+    bool hashed = false;
+    uint32_t next = 0;
+};
+
+// Maps an export read only. No system calls after open(): snapshots are
+// read straight from the mapping
+class SharedReader
+{
+public:
+    ~SharedReader();
+    // False if there's no such segment or it isn't an export
+    bool open(const std::string &name);
+
+    // Calls view(slot) on the newest snapshot in place, true if the writer
+    // didn't touch it meanwhile; view's results are void otherwise. False
+    // as well before the first snapshot
+    template<typename View>
+    bool read(View view) const
+    {
+        if (shared->published.load(std::memory_order_acquire) == 0)
+            return false;
+        const SharedFrames::Slot &slot = shared->slots[shared->latest.load(std::memory_order_acquire)];
+        uint32_t sequence = slot.sequence.load(std::memory_order_acquire);
+        if (sequence & 1)
+            return false;
+        view(slot);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return slot.sequence.load(std::memory_order_relaxed) == sequence;
+    }
+
+    // Snapshots published so far
+    uint32_t published() const;
+    bool closed() const;
+    // Of the slot's ram and pixels, as the writer hashes them
+    static uint64_t hash(const SharedFrames::Slot &slot);
+
+private:
+    const SharedFrames *shared = nullptr;
+};
@@ -0,0 +1,86 @@
+#pragma once
+#include <MOS6502.h>
+#include <stdint.h>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Runner for the per-opcode single-step JSON test vectors ("00.json".."ff.json"),
+// each case holding an initial state, a final state and the per-cycle bus activity.
+// Files are parsed as a stream, one case at a time, so large files never sit in memory
+class SingleStep
+{
+public:
+    SingleStep(MOS6502 &CPU);
+
+    bool runFile(const std::string &path, int opcode);
+    bool runDirectory(const std::string &dir);
+    void report(std::ostream &out);
+    // Run the CPU in bus-accurate mode and compare every bus cycle
+    void setCheckBus(bool enabled);
+
+    struct testState
+    {
+        uint16_t PC;
+        uint8_t SP;
+        uint8_t AC;
+        uint8_t X;
+        uint8_t Y;
+        uint8_t SR;
+        std::vector<MOS6502::memWrite> ram;
+    };
+
+    struct testCase
+    {
+        std::string name;
+        testState initial;
+        testState final;
+        std::vector<MOS6502::busCycle> cycles;
+    };
+
+private:
+    MOS6502 &CPU;
+    uint8_t memory[0x10000];
+    std::vector<MOS6502::memWrite> writes;
+    std::vector<MOS6502::busCycle> bus;
+    bool checkBus = false;
+
+    struct opcodeResult
+    {
+        bool present = false;
+        long passed = 0;
+        long failed = 0;
+        std::string firstFailure;
+    };
+    opcodeResult results[256];
+
+    std::string runCase(const testCase &test);
+
+    // Minimal pull parser over a buffered FILE, specialised for the vector schema
+    class JsonReader
+    {
+    public:
+        JsonReader(FILE *file);
+        bool nextCase(testCase &test);
+        bool failed() const { return error; }
+
+    private:
+        FILE *file;
+        char buffer[1 << 16];
+        size_t pos = 0;
+        size_t len = 0;
+        bool started = false;
+        bool error = false;
+
+        int peek();
+        int get();
+        void skipSpace();
+        bool expect(char c);
+        std::string parseString();
+        long parseNumber();
+        void skipValue();
+        void parseState(testState &state);
+        void parseCycles(std::vector<MOS6502::busCycle> &cycles);
+    };
+};
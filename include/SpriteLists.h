@@ -0,0 +1,29 @@
+#pragma once
+#include <stdint.h>
+
+// The sprites of every visible line, built from OAM in one pass over the 64
+// entries instead of comparing all 64 Y coordinates on each line. Callers
+// rebuild only after OAM or the sprite size changes.
+// Each line keeps the first eight sprites in OAM order. A line that finds
+// eight goes on the way the PPU does to decide overflow: after each miss
+// it moves to the next sprite and to the next byte of the entry, so it
+// reads tile numbers, attributes and X as Y coordinates
+class SpriteLists
+{
+public:
+    static const int LINES = 240;
+    static const int MAXSPRITES = 8;
+
+    void build(const uint8_t (&OAM)[256], bool tall);
+    int count(int line) const { return counts[line]; }
+    const uint8_t *sprites(int line) const { return indices[line]; }
+    bool overflow(int line) const { return overflows[line]; }
+    // First line that overflows, -1 if none
+    int firstOverflow() const { return overflowLine; }
+
+private:
+    uint8_t counts[LINES];
+    uint8_t indices[LINES][MAXSPRITES];
+    bool overflows[LINES];
+    int overflowLine = -1;
+};
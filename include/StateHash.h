@@ -0,0 +1,63 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <bitset>
+
+// Zobrist hash of the console's memories: the XOR of one key per tracked
+// byte, picked by its address and value, so a write only swaps the key of
+// the old value for the key of the new one. Keys come from a 64-bit mixer
+// instead of a 32K x 256 table. CPU RAM and PRG RAM use their CPU addresses,
+// the PPU memories sit in the ranges the CPU side never stores to
+class StateHash
+{
+public:
+    static const uint16_t RAM = 0x0000;
+    static const uint16_t NAMETABLES = 0x0800;
+    static const uint16_t PALETTE = 0x1000;
+    static const uint16_t OAM = 0x1100;
+    static const uint16_t CHR = 0x2000;
+    static const uint16_t PRGRAM = 0x6000;
+    static const uint32_t SIZE = 0x8000;
+
+    StateHash();
+
+    // CPU pages stored to directly that the hash follows: RAM and PRG RAM
+    static bool tracksPage(int page)
+    {
+        return page < 0x08 || (page >= 0x60 && page < 0x80);
+    }
+
+    // Masked addresses never reach the hash, e.g. frame counters or RNG
+    // state, so states differing only there hash the same. Takes a rehash
+    void mask(uint16_t first, uint16_t last, bool masked = true);
+    // Of the mask, states saved under the same one can keep their hash
+    uint64_t maskID() const;
+
+    void write(uint16_t addr, uint8_t old, uint8_t value)
+    {
+        if (old != value && !excluded[addr])
+            hash ^= key(addr, old) ^ key(addr, value);
+    }
+
+    // Rehash: clear, then add every tracked memory
+    void clear();
+    void add(uint16_t addr, const uint8_t *data, size_t size);
+    uint64_t value() const;
+    void set(uint64_t value);
+
+private:
+    uint64_t hash = 0;
+    uint64_t maskHash = 0;
+    std::bitset<SIZE> excluded;
+
+    void hashMask();
+
+    // splitmix64's finaliser
+    static uint64_t key(uint16_t addr, uint8_t value)
+    {
+        uint64_t x = ((uint64_t)addr << 8 | value) + 0x9E3779B97F4A7C15ULL;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+};
@@ -0,0 +1,39 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of workers that run one batch at a time: run() hands out the
+// indices [0, count) to the workers and the calling thread, and returns
+// once every job is done. Jobs are taken one at a time, so uneven ones
+// balance themselves
+class ThreadPool
+{
+public:
+    // Workers besides the calling thread, 0 runs every batch on the caller
+    explicit ThreadPool(int workers);
+    ~ThreadPool();
+
+    // Threads a batch runs on, the caller included
+    int threads() const;
+    void run(int count, const std::function<void(int)> &job);
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(int)> *job = nullptr;
+    int count = 0;
+    std::atomic<int> next{0};
+    // Workers still inside the current batch
+    int active = 0;
+    uint64_t batch = 0;
+    bool stopping = false;
+
+    void runJobs();
+    void workerLoop();
+};
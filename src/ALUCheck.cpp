@@ -0,0 +1,129 @@
+#include <ALUCheck.h>
+#include <ALU.h>
+#include <iostream>
+#include <iomanip>
+
+static const size_t MAXREPORTED = 16;
+
+// Reference model, written as the step by step decimal adjust sequences
+// rather than the branch-free form used by ALU
+static ALUResult referenceADC(CPUVariant variant, uint8_t a, uint8_t b, bool carry, bool decimal) {
+    ALUResult r;
+    int binary = a + b + carry;
+    if (!decimal || variant == variant2A03) {
+        r.value = binary & 0xFF;
+        r.carry = binary > 0xFF;
+        r.zero = r.value == 0;
+        r.negative = r.value & 0x80;
+        r.overflow = (int8_t)a + (int8_t)b + carry < -128 || (int8_t)a + (int8_t)b + carry > 127;
+        return r;
+    }
+
+    int lo = (a & 0x0F) + (b & 0x0F) + carry;
+    if (lo >= 0x0A)
+        lo = ((lo + 0x06) & 0x0F) + 0x10;
+    int sum = (a & 0xF0) + (b & 0xF0) + lo;
+    int signedSum = (int8_t)(a & 0xF0) + (int8_t)(b & 0xF0) + lo;
+    r.negative = signedSum & 0x80;
+    r.overflow = signedSum < -128 || signedSum > 127;
+    r.zero = (binary & 0xFF) == 0;
+    if (sum >= 0xA0)
+        sum += 0x60;
+    r.value = sum & 0xFF;
+    r.carry = sum >= 0x100;
+    if (variant == variant65C02) {
+        r.negative = r.value & 0x80;
+        r.zero = r.value == 0;
+    }
+    return r;
+}
+
+static ALUResult referenceSBC(CPUVariant variant, uint8_t a, uint8_t b, bool carry, bool decimal) {
+    ALUResult r;
+    int binary = a - b - !carry;
+    int signedDiff = (int8_t)a - (int8_t)b - !carry;
+    r.value = binary & 0xFF;
+    r.carry = binary >= 0;
+    r.zero = r.value == 0;
+    r.negative = r.value & 0x80;
+    r.overflow = signedDiff < -128 || signedDiff > 127;
+    if (!decimal || variant == variant2A03)
+        return r;
+
+    int lo = (a & 0x0F) - (b & 0x0F) + carry - 1;
+    int diff;
+    if (variant == variant65C02) {
+        diff = a - b + carry - 1;
+        if (diff < 0)
+            diff -= 0x60;
+        if (lo < 0)
+            diff -= 0x06;
+    }
+    else {
+        if (lo < 0)
+            lo = ((lo - 0x06) & 0x0F) - 0x10;
+        diff = (a & 0xF0) - (b & 0xF0) + lo;
+        if (diff < 0)
+            diff -= 0x60;
+    }
+    r.value = diff & 0xFF;
+    if (variant == variant65C02) {
+        r.zero = r.value == 0;
+        r.negative = r.value & 0x80;
+    }
+    return r;
+}
+
+static bool sameResult(const ALUResult &x, const ALUResult &y) {
+    return x.value == y.value && x.carry == y.carry && x.zero == y.zero
+        && x.overflow == y.overflow && x.negative == y.negative;
+}
+
+void ALUCheck::compare(const char *variant, const char *op, uint8_t a, uint8_t b, bool carry, bool decimal,
+                       const ALUResult &expected, const ALUResult &actual) {
+    checked++;
+    if (sameResult(expected, actual))
+        return;
+    failures++;
+    if (mismatches.size() < MAXREPORTED)
+        mismatches.push_back({variant, op, a, b, carry, decimal, expected, actual});
+}
+
+template<CPUVariant V>
+void ALUCheck::checkVariant(const char *name) {
+    for (int a = 0; a < 256; a++) {
+        for (int b = 0; b < 256; b++) {
+            for (int c = 0; c < 2; c++) {
+                for (int d = 0; d < 2; d++) {
+                    compare(name, "ADC", a, b, c, d, referenceADC(V, a, b, c, d), ALU<V>::adc(a, b, c, d));
+                    compare(name, "SBC", a, b, c, d, referenceSBC(V, a, b, c, d), ALU<V>::sbc(a, b, c, d));
+                }
+            }
+        }
+    }
+}
+
+bool ALUCheck::run() {
+    checkVariant<variant2A03>("2A03");
+    checkVariant<variantNMOS>("NMOS");
+    checkVariant<variant65C02>("65C02");
+    return failures == 0;
+}
+
+static void printResult(std::ostream &out, const ALUResult &r) {
+    out << "$" << std::setw(2) << std::setfill('0') << std::hex << std::uppercase << (int)r.value << std::dec
+        << " C" << r.carry << " Z" << r.zero << " V" << r.overflow << " N" << r.negative;
+}
+
+void ALUCheck::report(std::ostream &out) {
+    for (const Mismatch &m : mismatches) {
+        out << m.variant << " " << m.op << " $" << std::setw(2) << std::setfill('0') << std::hex << std::uppercase
+            << (int)m.a << ",$" << std::setw(2) << (int)m.b << std::dec
+            << " C=" << m.carry << " D=" << m.decimal << ": expected ";
+        printResult(out, m.expected);
+        out << ", got ";
+        printResult(out, m.actual);
+        out << "\n";
+    }
+    out << checked << " cases checked, " << failures << " mismatch(es)\n";
+}
@@ -0,0 +1,880 @@
+#include <Benchmark.h>
+#include <Controller.h>
+#include <MOS6502.h>
+#include <OpcodeInfo.h>
+#include <Profiler.h>
+#include <OpcodeStats.h>
+#include <Fusion.h>
+#include <Disassembler.h>
+#include <Coverage.h>
+#include <Movie.h>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <fstream>
+#include <chrono>
+#include <ctime>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <SpriteLists.h>
+#include <NESAPI.h>
+#include <Observation.h>
+#include <RunAhead.h>
+#include <Hash.h>
+
+// Whole-ROM runs restart from the image this often, nestest finishes its
+// automated run in about 9000 instructions
+static const long RESTART = 8192;
+static const uint16_t CODEADDR = 0x0200;
+static const uint16_t DATAADDR = 0x0310;
+
+Benchmark::Benchmark(const std::string &romDir, double minTime)
+    : romDir(romDir), minTime(minTime) {
+}
+
+template<typename Body>
+void Benchmark::measure(const std::string &name, Body body) {
+    if (name.find(filter) == std::string::npos)
+        return;
+
+    long iterations = 1;
+    while (true) {
+        auto begin = std::chrono::steady_clock::now();
+        double items = body(iterations);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        if (seconds >= minTime || iterations >= (1L << 40)) {
+            results.push_back({name, iterations, seconds, items / iterations, {}});
+            return;
+        }
+        double scale = seconds > 0 ? minTime * 1.4 / seconds : 100;
+        scale = scale < 2 ? 2 : (scale > 100 ? 100 : scale);
+        iterations = (long)(iterations * scale);
+    }
+}
+
+MOS6502::CPUState Benchmark::startState(uint16_t PC) {
+    MOS6502::CPUState state;
+    state.PC = PC;
+    state.SP = 0xFD;
+    state.AC = 0;
+    state.X = 0;
+    state.Y = 0;
+    state.SR = 0x24;
+    state.totalClk = 0;
+    return state;
+}
+
+long Benchmark::runInstructions(MOS6502 &CPU, const MOS6502::CPUState &start, long instructions) {
+    for (long done = 0; done < instructions; done += RESTART) {
+        memcpy(memory, image, sizeof(memory));
+        CPU.setState(start);
+        long count = instructions - done < RESTART ? instructions - done : RESTART;
+        for (long i = 0; i < count; i++) {
+            CPU.executeOP(memory);
+        }
+    }
+    return instructions;
+}
+
+// One instruction at CODEADDR, state restored before every execution.
+// Operands point at DATAADDR directly and through a zero page pointer
+static void opcodeImage(uint8_t (&image)[0x10000], uint8_t opcode) {
+    memset(image, 0, sizeof(image));
+    image[CODEADDR] = opcode;
+    image[CODEADDR + 1] = DATAADDR & 0xFF;
+    image[CODEADDR + 2] = DATAADDR >> 8;
+    image[DATAADDR & 0xFF] = DATAADDR & 0xFF;
+    image[(DATAADDR & 0xFF) + 1] = DATAADDR >> 8;
+}
+
+void Benchmark::opcodes() {
+    MOS6502 CPU;
+    CPU.setLogging(false);
+    MOS6502::CPUState start = startState(CODEADDR);
+
+    for (int opcode = 0; opcode < 256; opcode++) {
+        const OpcodeInfo &info = opcodeInfo[opcode];
+        // JAM never leaves the opcode
+        if (info.cycles == 0)
+            continue;
+
+        std::stringstream name;
+        name << "opcode/" << std::setw(2) << std::setfill('0') << std::hex << std::uppercase << opcode
+             << "_" << info.mnemonic << "_" << addrModeName(info.mode);
+        opcodeImage(image, opcode);
+        memcpy(memory, image, sizeof(memory));
+        measure(name.str(), [&](long iterations) {
+            for (long i = 0; i < iterations; i++) {
+                CPU.setState(start);
+                CPU.executeOP(memory);
+            }
+            return (double)iterations;
+        });
+    }
+}
+
+// The addressing mode helpers are private, they're timed through LDA
+// (LDX/JMP/BNE for the modes LDA doesn't have)
+void Benchmark::addressingModes() {
+    struct Mode
+    {
+        const char *name;
+        uint8_t opcode;
+        uint8_t index;
+    };
+    static const Mode modes[] = {
+        {"implied", 0xAA, 0},
+        {"accumulator", 0x0A, 0},
+        {"immediate", 0xA9, 0},
+        {"zeroPage", 0xA5, 0},
+        {"zeroPageX", 0xB5, 0},
+        {"zeroPageY", 0xB6, 0},
+        {"absolute", 0xAD, 0},
+        {"absoluteX", 0xBD, 0},
+        {"absoluteX_pagecross", 0xBD, 0xF0},
+        {"absoluteY", 0xB9, 0},
+        {"absoluteY_pagecross", 0xB9, 0xF0},
+        {"indirect", 0x6C, 0},
+        {"indirectX", 0xA1, 0},
+        {"indirectY", 0xB1, 0},
+        {"indirectY_pagecross", 0xB1, 0xF0},
+        {"relative", 0xD0, 0},
+    };
+
+    MOS6502 CPU;
+    CPU.setLogging(false);
+    for (const Mode &mode : modes) {
+        MOS6502::CPUState start = startState(CODEADDR);
+        start.X = mode.index;
+        start.Y = mode.index;
+        opcodeImage(image, mode.opcode);
+        memcpy(memory, image, sizeof(memory));
+        measure(std::string("mode/") + mode.name, [&](long iterations) {
+            for (long i = 0; i < iterations; i++) {
+                CPU.setState(start);
+                CPU.executeOP(memory);
+            }
+            return (double)iterations;
+        });
+    }
+}
+
+void Benchmark::wholeROM(const std::string &name, const std::string &file, uint16_t start, Trace trace) {
+    std::ifstream ROM(romDir + "/" + file, std::ios::binary);
+    if (!ROM) {
+        std::cout << name << ": " << file << " not found, skipped\n";
+        return;
+    }
+    memset(image, 0, sizeof(image));
+    Controller::loadROM(ROM, image);
+
+    MOS6502 CPU;
+    CPU.setLogging(trace == traceLog);
+    std::vector<MOS6502::busCycle> bus;
+    std::vector<MOS6502::memWrite> writes;
+    if (trace == traceBus) {
+        CPU.setBusAccurate(true);
+        CPU.setBusLog(&bus);
+        CPU.setWriteLog(&writes);
+    }
+
+    measure(name, [&](long iterations) {
+        long instructions = iterations * RESTART;
+        for (long i = 0; i < iterations; i++) {
+            bus.clear();
+            writes.clear();
+            runInstructions(CPU, startState(start), RESTART);
+        }
+        return (double)instructions;
+    });
+}
+
+void Benchmark::frames(const std::string &name, const std::string &file, bool profile) {
+    std::ifstream ROM(romDir + "/" + file, std::ios::binary);
+    if (!ROM) {
+        std::cout << name << ": " << file << " not found, skipped\n";
+        return;
+    }
+    std::unique_ptr<Controller> console(new Controller(ROM));
+    console->setLogging(false);
+    std::unique_ptr<Profiler> profiler(profile ? new Profiler() : nullptr);
+    console->setProfiler(profiler.get());
+    measure(name, [&](long iterations) {
+        for (long i = 0; i < iterations; i++) {
+            console->runFrame();
+        }
+        return (double)iterations;
+    });
+}
+
+// Fusion pairs come from the opcode mix of a first run, then the same
+// frames are timed with superinstructions on
+void Benchmark::fusion(const std::string &file) {
+    static const long STATSFRAMES = 300;
+    static const size_t PAIRS = 64;
+    if (std::string("fusion/smb_frames").find(filter) == std::string::npos)
+        return;
+    std::ifstream ROM(romDir + "/" + file, std::ios::binary);
+    if (!ROM) {
+        std::cout << "fusion/smb_frames: " << file << " not found, skipped\n";
+        return;
+    }
+
+    OpcodeStats stats;
+    std::unique_ptr<Controller> recorder(new Controller(ROM));
+    recorder->setLogging(false);
+    recorder->setStats(&stats);
+    for (long i = 0; i < STATSFRAMES; i++)
+        recorder->runFrame();
+    FusionTable table;
+    table.fromStats(stats, PAIRS);
+
+    ROM.clear();
+    std::unique_ptr<Controller> console(new Controller(ROM));
+    console->setLogging(false);
+    console->setFusion(&table);
+    long frames = 0;
+    measure("fusion/smb_frames", [&](long iterations) {
+        for (long i = 0; i < iterations; i++)
+            console->runFrame();
+        frames += iterations;
+        return (double)iterations;
+    });
+    double instructionsPerFrame = (double)stats.instructions() / STATSFRAMES;
+    double fusedPerFrame = (double)console->fusedInstructions() / frames;
+    results.back().counters.push_back({"pairs", (double)table.size()});
+    results.back().counters.push_back({"dispatch_reduction", fusedPerFrame / instructionsPerFrame});
+}
+
+// Same frames with idle loops fast-forwarded, the counter is the share of
+// the emulated cycles that were skipped instead of executed
+void Benchmark::idleSkip(const std::string &file) {
+    static const double CYCLESPERFRAME = 29780.5; // NTSC, odd frames a dot short
+    std::ifstream ROM(romDir + "/" + file, std::ios::binary);
+    if (!ROM) {
+        std::cout << "idle/smb_frames: " << file << " not found, skipped\n";
+        return;
+    }
+    std::unique_ptr<Controller> console(new Controller(ROM));
+    console->setLogging(false);
+    console->setIdleSkip(true);
+    long frames = 0;
+    measure("idle/smb_frames", [&](long iterations) {
+        for (long i = 0; i < iterations; i++)
+            console->runFrame();
+        frames += iterations;
+        return (double)iterations;
+    });
+    if (frames == 0)
+        return;
+    results.back().counters.push_back({"skipped_fraction", (double)console->idleCyclesSkipped() / (frames * CYCLESPERFRAME)});
+}
+
+// Recursive analysis and ca65 listing of a whole PRG image. The listing
+// goes to a stream without a buffer, so only the formatting is timed
+void Benchmark::disassemble(const std::string &name, const std::string &file) {
+    std::ifstream ROM(romDir + "/" + file, std::ios::binary);
+    if (!ROM) {
+        std::cout << name << ": " << file << " not found, skipped\n";
+        return;
+    }
+    memset(image, 0, sizeof(image));
+    Controller::loadROM(ROM, image);
+    std::unique_ptr<Disassembler> disassembler(new Disassembler());
+    std::ostream discard(nullptr);
+    measure(name, [&](long iterations) {
+        for (long i = 0; i < iterations; i++) {
+            disassembler->analyse(image);
+            disassembler->writeListing(discard);
+        }
+        return (double)iterations * 0x8000;
+    });
+}
+
+// The same guided by a coverage log of the first 600 frames, as --cdl then
+// --disasm do. Only executed bytes may come out as code, --disasm-verify
+// checks the listing assembles back
+void Benchmark::disassembleCoverage(const std::string &name, const std::string &file) {
+    static const int FRAMES = 600;
+    if (name.find(filter) == std::string::npos)
+        return;
+    std::ifstream ROM(romDir + "/" + file, std::ios::binary);
+    if (!ROM) {
+        std::cout << name << ": " << file << " not found, skipped\n";
+        return;
+    }
+    std::unique_ptr<Controller> console(new Controller(ROM));
+    console->setLogging(false);
+    const Controller::ROMInfo &info = console->romInfo();
+    Coverage coverage(info.PRGSize, info.CHRSize);
+    console->setCoverage(&coverage);
+    for (int i = 0; i < FRAMES; i++)
+        console->runFrame();
+    console->setCoverage(nullptr);
+    size_t executed = 0;
+    for (size_t i = 0; i < coverage.PRGSize(); i++)
+        executed += coverage.PRG()[i] & Coverage::prgCode ? 1 : 0;
+
+    memset(image, 0, sizeof(image));
+    ROM.clear();
+    Controller::loadROM(ROM, image);
+    std::unique_ptr<Disassembler> disassembler(new Disassembler());
+    size_t mapped = info.PRGSize < 0x8000 ? info.PRGSize : 0x8000;
+    for (size_t base = 0; mapped && base < 0x8000; base += mapped)
+        disassembler->setCoverage(coverage.PRG(), 0x8000 + base, mapped);
+    std::ostream discard(nullptr);
+    measure(name, [&](long iterations) {
+        for (long i = 0; i < iterations; i++) {
+            disassembler->analyse(image);
+            disassembler->writeListing(discard);
+        }
+        return (double)iterations * 0x8000;
+    });
+    // A 16KB PRG is executed through both mirrors
+    size_t code = disassembler->codeBytes() / (0x8000 / (mapped ? mapped : 0x8000));
+    results.back().counters.push_back({"code_bytes", (double)code});
+    results.back().counters.push_back({"executed_bytes", (double)executed});
+    results.back().counters.push_back({"within_executed", code <= executed ? 1.0 : 0.0});
+}
+
+// The CPU registers and the whole 64KB address space, as a bound on a
+// naive format, then the console's own save state in the middle of SMB
+void Benchmark::saveState(const std::string &file) {
+    MOS6502 CPU;
+    CPU.setLogging(false);
+    static uint8_t saved[0x10000];
+    measure("savestate/cpu_ram_roundtrip", [&](long iterations) {
+        for (long i = 0; i < iterations; i++) {
+            MOS6502::CPUState state = CPU.getState();
+            memcpy(saved, memory, sizeof(saved));
+            memory[i & 0xFFFF]++;
+            memcpy(memory, saved, sizeof(memory));
+            CPU.setState(state);
+        }
+        return (double)iterations;
+    });
+
+    // Reaching the middle of the game takes longer than the case
+    if (std::string("savestate/smb_roundtrip").find(filter) == std::string::npos)
+        return;
+    std::ifstream ROM(romDir + "/" + file, std::ios::binary);
+    if (!ROM) {
+        std::cout << "savestate/smb_roundtrip: " << file << " not found, skipped\n";
+        return;
+    }
+    std::unique_ptr<Controller> console(new Controller(ROM));
+    console->setLogging(false);
+    for (int i = 0; i < 200; i++)
+        console->runFrame();
+    std::unique_ptr<Controller::SaveState> state(new Controller::SaveState());
+    measure("savestate/smb_roundtrip", [&](long iterations) {
+        for (long i = 0; i < iterations; i++) {
+            console->saveState(*state);
+            console->loadState(*state);
+        }
+        return (double)iterations;
+    });
+    results.back().counters.push_back({"state_bytes", (double)sizeof(Controller::SaveState)});
+}
+
+// State hashes of a running game: a full rehash per call, then tracked
+// incrementally, and what tracking costs the frames it follows. matches
+// compares the tracked hash with a rehash after the tracked frames
+void Benchmark::stateHash(const std::string &file) {
+    static const char *const NAMES[] = {"hash/smb_state_full", "hash/smb_frames_untracked", "hash/smb_state_tracked",
+                                        "hash/smb_frames_tracked"};
+    bool wanted = false;
+    for (const char *name : NAMES)
+        wanted = wanted || std::string(name).find(filter) != std::string::npos;
+    if (!wanted)
+        return;
+    std::ifstream ROM(romDir + "/" + file, std::ios::binary);
+    if (!ROM) {
+        std::cout << "hash/smb: " << file << " not found, skipped\n";
+        return;
+    }
+    std::unique_ptr<Controller> console(new Controller(ROM));
+    console->setLogging(false);
+    for (int i = 0; i < 200; i++)
+        console->runFrame();
+    for (int tracking = 0; tracking < 2; tracking++) {
+        console->setStateHashing(tracking);
+        measure(NAMES[tracking * 2], [&](long iterations) {
+            for (long i = 0; i < iterations; i++)
+                console->stateHash();
+            return (double)iterations;
+        });
+        measure(NAMES[tracking * 2 + 1], [&](long iterations) {
+            for (long i = 0; i < iterations; i++)
+                console->runFrame();
+            return (double)iterations;
+        });
+    }
+    uint64_t tracked = console->stateHash();
+    console->setStateHashing(false);
+    if (!results.empty() && results.back().name == NAMES[3])
+        results.back().counters.push_back({"matches", tracked == console->stateHash() ? 1.0 : 0.0});
+}
+
+// Frames through the C API: a batch of consoles stepped four frames at a
+// time on the thread pool, each writing its observation out, as a
+// vectorised environment with frame skip does. Raw frames, then 84x84
+// grayscale, max pooled and stacked four deep
+void Benchmark::stepMany(const std::string &file) {
+    static const int CONSOLES = 8;
+    static const int FRAMESKIP = 4;
+    static const char *const NAMES[] = {"api/smb_step_many", "api/smb_step_many_84x84"};
+    if (std::string(NAMES[0]).find(filter) == std::string::npos
+        && std::string(NAMES[1]).find(filter) == std::string::npos)
+        return;
+    std::string path = romDir + "/" + file;
+    std::vector<nes_t *> consoles;
+    for (int i = 0; i < CONSOLES; i++) {
+        nes_t *nes = nes_create(path.c_str());
+        if (!nes)
+            break;
+        consoles.push_back(nes);
+    }
+    if (consoles.size() == CONSOLES) {
+        std::vector<uint8_t> actions(2 * CONSOLES, 0);
+        for (const char *name : NAMES) {
+            if (name == NAMES[1]) {
+                nes_observation config = {18, 12, 0, 0, 84, 84, 1, 4};
+                for (nes_t *nes : consoles)
+                    nes_set_observation(nes, &config);
+            }
+            std::vector<uint8_t> observations(CONSOLES * nes_observation_size(consoles[0]));
+            measure(name, [&](long iterations) {
+                for (long i = 0; i < iterations; i++)
+                    nes_step_many(consoles.data(), CONSOLES, actions.data(), FRAMESKIP, observations.data());
+                return (double)iterations * CONSOLES * FRAMESKIP;
+            });
+            if (!results.empty() && results.back().name == name)
+                results.back().counters.push_back({"hardware_threads", (double)std::thread::hardware_concurrency()});
+        }
+    }
+    else {
+        std::cout << "api/smb_step_many: " << file << " not found, skipped\n";
+    }
+    for (nes_t *nes : consoles)
+        nes_destroy(nes);
+}
+
+// The observation kernels alone on an SMB frame, per observation: two
+// frames grayscaled and cropped, max pooled, resized to 84x84, and the
+// stack of four written out
+void Benchmark::observation(const std::string &file) {
+    if (std::string("observe/smb_84x84").find(filter) == std::string::npos)
+        return;
+    std::ifstream ROM(romDir + "/" + file, std::ios::binary);
+    if (!ROM) {
+        std::cout << "observe/smb_84x84: " << file << " not found, skipped\n";
+        return;
+    }
+    std::unique_ptr<Controller> console(new Controller(ROM));
+    console->setLogging(false);
+    console->setRendering(Controller::renderSerial);
+    for (int i = 0; i < 200; i++)
+        console->runFrame();
+    const uint8_t *pixels = console->framePixels();
+
+    Observation::Config config;
+    config.cropTop = 18;
+    config.cropBottom = 12;
+    config.width = 84;
+    config.height = 84;
+    config.maxPool = true;
+    config.stack = 4;
+    Observation kernels(config);
+    std::vector<uint8_t> out(kernels.size());
+    measure("observe/smb_84x84", [&](long iterations) {
+        for (long i = 0; i < iterations; i++) {
+            kernels.frame(pixels);
+            kernels.frame(pixels);
+            kernels.push();
+            kernels.write(out.data());
+        }
+        return (double)iterations;
+    });
+}
+
+// Frames from the Start press on the SMB title screen until the shown
+// frame first differs from a run without it, the input lag the player
+// sees. Start is held from PRESSFRAME on. hash gets the shown frames
+static int displayLag(const std::string &path, int ahead, bool second, uint64_t *hash = nullptr) {
+    static const int PRESSFRAME = 40;
+    static const int MAXLAG = 20;
+    uint64_t shown[2][MAXLAG];
+    for (int pressed = 0; pressed < 2; pressed++) {
+        std::ifstream ROM(path, std::ios::binary);
+        std::unique_ptr<Controller> console(new Controller(ROM));
+        ROM.clear();
+        std::unique_ptr<Controller> other(second ? new Controller(ROM) : nullptr);
+        console->setLogging(false);
+        if (other)
+            other->setLogging(false);
+        RunAhead runAhead(*console, ahead, other.get());
+        for (int frame = 0; frame < PRESSFRAME + MAXLAG; frame++) {
+            if (pressed && frame == PRESSFRAME)
+                runAhead.setButtons(0, Joypad::buttonStart);
+            runAhead.runFrame();
+            if (frame >= PRESSFRAME) {
+                const uint8_t *pixels = runAhead.framePixels();
+                shown[pressed][frame - PRESSFRAME] = hashBytes(HASHSEED, pixels, PPURenderer::WIDTH * PPURenderer::HEIGHT);
+                if (hash && pressed)
+                    *hash = hashValue(*hash, shown[pressed][frame - PRESSFRAME]);
+            }
+        }
+    }
+    for (int lag = 0; lag < MAXLAG; lag++) {
+        if (shown[0][lag] != shown[1][lag])
+            return lag;
+    }
+    return MAXLAG;
+}
+
+// Frames shown through run-ahead: none, one and two frames ahead on one
+// console, two ahead on a second console's thread. The cost is the host
+// time per shown frame, lag_frames the frames from a press to the first
+// frame showing it
+void Benchmark::runAhead(const std::string &file) {
+    struct Case
+    {
+        const char *name;
+        int ahead;
+        bool second;
+    };
+    static const Case CASES[] = {
+        {"runahead/smb_off", 0, false},
+        {"runahead/smb_1", 1, false},
+        {"runahead/smb_2", 2, false},
+        {"runahead/smb_2_second_core", 2, true},
+    };
+    std::string path = romDir + "/" + file;
+    if (!std::ifstream(path)) {
+        std::cout << "runahead/smb: " << file << " not found, skipped\n";
+        return;
+    }
+    uint64_t singleHash = HASHSEED;
+    for (const Case &c : CASES) {
+        if (std::string(c.name).find(filter) == std::string::npos)
+            continue;
+        std::ifstream ROM(path, std::ios::binary);
+        std::unique_ptr<Controller> console(new Controller(ROM));
+        ROM.clear();
+        std::unique_ptr<Controller> other(c.second ? new Controller(ROM) : nullptr);
+        console->setLogging(false);
+        if (other)
+            other->setLogging(false);
+        {
+            RunAhead runAhead(*console, c.ahead, other.get());
+            measure(c.name, [&](long iterations) {
+                for (long i = 0; i < iterations; i++) {
+                    runAhead.runFrame();
+                    runAhead.framePixels();
+                }
+                return (double)iterations;
+            });
+        }
+        uint64_t hash = HASHSEED;
+        results.back().counters.push_back({"lag_frames", (double)displayLag(path, c.ahead, c.second, &hash)});
+        if (c.ahead == 2 && !c.second)
+            singleHash = hash;
+        else if (c.second && singleHash != HASHSEED)
+            results.back().counters.push_back({"identical", hash == singleHash ? 1.0 : 0.0});
+    }
+}
+
+// Replay of a scripted play session (Start, then running and jumping to the
+// right) with every frame's checksum checked, as regression runs do
+void Benchmark::movie(const std::string &file) {
+    static const int MOVIEFRAMES = 3000;
+    // Recording the movie takes as long as a replay, skip it when filtered out
+    if (std::string("movie/smb_replay").find(filter) == std::string::npos)
+        return;
+    std::ifstream ROM(romDir + "/" + file, std::ios::binary);
+    if (!ROM) {
+        std::cout << "movie/smb_replay: " << file << " not found, skipped\n";
+        return;
+    }
+    std::unique_ptr<Controller> console(new Controller(ROM));
+    console->setLogging(false);
+    std::stringstream input, recorded;
+    MovieWriter script(input, 1, false, console->romChecksum());
+    for (int i = 0; i < MOVIEFRAMES; i++) {
+        MovieFrame frame;
+        if (i >= 40 && i < 45)
+            frame.buttons[0] = Joypad::buttonStart;
+        else if (i >= 100)
+            frame.buttons[0] = Joypad::buttonRight | Joypad::buttonB | ((i / 30) % 2 ? 0 : Joypad::buttonA);
+        script.write(frame);
+    }
+    MovieReader scripted(input);
+    MovieWriter recorder(recorded, 1, true, console->romChecksum());
+    MoviePlayer recording(*console, scripted, &recorder);
+    while (recording.step())
+        ;
+
+    std::unique_ptr<MovieReader> movie;
+    std::unique_ptr<MoviePlayer> player;
+    long desyncs = 0;
+    measure("movie/smb_replay", [&](long iterations) {
+        for (long i = 0; i < iterations; i++) {
+            if (!player || !player->step()) {
+                desyncs += player && player->desynced();
+                ROM.clear();
+                console.reset(new Controller(ROM));
+                console->setLogging(false);
+                recorded.clear();
+                recorded.seekg(0);
+                movie.reset(new MovieReader(recorded));
+                player.reset(new MoviePlayer(*console, *movie));
+                player->step();
+            }
+        }
+        return (double)iterations;
+    });
+    results.back().counters.push_back({"desyncs", (double)desyncs});
+}
+
+// Whole frames with pixels, rendered after each frame or on a second thread
+// while the CPU runs ahead. Both consoles render the same frames, so their
+// checksums must match
+void Benchmark::rendering(const std::string &file) {
+    std::ifstream ROM(romDir + "/" + file, std::ios::binary);
+    if (!ROM) {
+        std::cout << "render/smb_frames: " << file << " not found, skipped\n";
+        return;
+    }
+    std::unique_ptr<Controller> serial(new Controller(ROM));
+    ROM.clear();
+    std::unique_ptr<Controller> threaded(new Controller(ROM));
+    serial->setLogging(false);
+    serial->setRendering(Controller::renderSerial);
+    threaded->setLogging(false);
+    threaded->setRendering(Controller::renderThreaded);
+
+    long serialFrames = 0;
+    long threadedFrames = 0;
+    measure("render/smb_serial", [&](long iterations) {
+        for (long i = 0; i < iterations; i++)
+            serial->runFrame();
+        serialFrames += iterations;
+        return (double)iterations;
+    });
+    measure("render/smb_threaded", [&](long iterations) {
+        for (long i = 0; i < iterations; i++)
+            threaded->runFrame();
+        threaded->framePixels();
+        threadedFrames += iterations;
+        return (double)iterations;
+    });
+    if (serialFrames == 0 || threadedFrames == 0)
+        return;
+    while (serialFrames < threadedFrames) {
+        serial->runFrame();
+        serialFrames++;
+    }
+    while (threadedFrames < serialFrames) {
+        threaded->runFrame();
+        threadedFrames++;
+    }
+    results.back().counters.push_back({"identical", serial->renderChecksum() == threaded->renderChecksum() ? 1.0 : 0.0});
+    results.back().counters.push_back({"hardware_threads", (double)std::thread::hardware_concurrency()});
+}
+
+// Frames that are only hashed or read from RAM every so often: every 4th
+// frame drawn, and none at all, against render/smb_serial
+void Benchmark::renderSkip(const std::string &file) {
+    std::ifstream ROM(romDir + "/" + file, std::ios::binary);
+    if (!ROM) {
+        std::cout << "render/smb_skip: " << file << " not found, skipped\n";
+        return;
+    }
+    for (int every : {4, 0}) {
+        ROM.clear();
+        std::unique_ptr<Controller> console(new Controller(ROM));
+        console->setLogging(false);
+        console->setRenderSkip(every);
+        console->setRendering(Controller::renderSerial);
+        measure(every ? "render/smb_every4" : "render/smb_on_demand", [&](long iterations) {
+            for (long i = 0; i < iterations; i++)
+                console->runFrame();
+            return (double)iterations;
+        });
+    }
+}
+
+// Every frame drawn, redrawing only the lines whose inputs changed. A
+// second console checks the reused lines against a full redraw
+void Benchmark::lineReuse(const std::string &file) {
+    std::ifstream ROM(romDir + "/" + file, std::ios::binary);
+    if (!ROM) {
+        std::cout << "render/smb_line_reuse: " << file << " not found, skipped\n";
+        return;
+    }
+    std::unique_ptr<Controller> console(new Controller(ROM));
+    console->setLogging(false);
+    console->setLineReuse(true);
+    console->setRendering(Controller::renderSerial);
+    long frames = 0;
+    measure("render/smb_line_reuse", [&](long iterations) {
+        for (long i = 0; i < iterations; i++)
+            console->runFrame();
+        frames += iterations;
+        return (double)iterations;
+    });
+    if (frames == 0)
+        return;
+    PPURenderer::Stats stats = console->renderStats();
+    results.back().counters.push_back({"reused_fraction", (double)stats.linesReused / (stats.linesReused + stats.linesDrawn)});
+
+    ROM.clear();
+    console.reset(new Controller(ROM));
+    console->setLogging(false);
+    console->setLineReuse(true, true);
+    console->setRendering(Controller::renderSerial);
+    for (long i = 0; i < frames; i++)
+        console->runFrame();
+    results.back().counters.push_back({"mismatched_lines", (double)console->renderStats().reuseMismatches});
+}
+
+// Sprite evaluation for all 240 lines of a busy SMB frame: the OAM DMA page
+// ($0200) of the frame with the most sprites on screen in the attract demo.
+// Scanning compares all 64 Y coordinates on every line, the lists are built
+// in one pass over OAM, which the renderer does only when OAM changes
+void Benchmark::spriteEvaluation(const std::string &file) {
+    static const int DEMOFRAMES = 2000;
+    static const uint16_t OAMPAGE = 0x0200;
+    // Finding the frame takes longer than the cases, skip it when filtered out
+    if (std::string("sprites/smb_scan").find(filter) == std::string::npos
+        && std::string("sprites/smb_lists").find(filter) == std::string::npos)
+        return;
+    std::ifstream ROM(romDir + "/" + file, std::ios::binary);
+    if (!ROM) {
+        std::cout << "sprites/smb: " << file << " not found, skipped\n";
+        return;
+    }
+    std::unique_ptr<Controller> console(new Controller(ROM));
+    console->setLogging(false);
+    uint8_t OAM[256] = {};
+    int busiest = -1;
+    for (int frame = 0; frame < DEMOFRAMES; frame++) {
+        console->runFrame();
+        // Y 0 is cleared RAM rather than a sprite, as between demo runs
+        int onScreen = 0;
+        for (int sprite = 0; sprite < 64; sprite++) {
+            uint8_t y = console->ram()[OAMPAGE + sprite * 4];
+            onScreen += y > 0 && y < 239;
+        }
+        if (onScreen > busiest) {
+            busiest = onScreen;
+            memcpy(OAM, console->ram() + OAMPAGE, sizeof(OAM));
+        }
+    }
+
+    // Read through a volatile pointer so the work isn't hoisted out of the loop
+    const uint8_t(*volatile source)[256] = &OAM;
+    long found = 0;
+    measure("sprites/smb_scan", [&](long iterations) {
+        for (long i = 0; i < iterations; i++) {
+            const uint8_t *entries = *source;
+            for (int line = 0; line < SpriteLists::LINES; line++) {
+                int count = 0;
+                for (int sprite = 0; sprite < 64 && count < 8; sprite++) {
+                    int row = line - 1 - entries[sprite * 4];
+                    if (row >= 0 && row < 8)
+                        count++;
+                }
+                found += count;
+            }
+        }
+        return (double)iterations * SpriteLists::LINES;
+    });
+    std::unique_ptr<SpriteLists> lists(new SpriteLists());
+    measure("sprites/smb_lists", [&](long iterations) {
+        for (long i = 0; i < iterations; i++) {
+            lists->build(*source, false);
+            for (int line = 0; line < SpriteLists::LINES; line++)
+                found += lists->count(line);
+        }
+        return (double)iterations * SpriteLists::LINES;
+    });
+    results.back().counters.push_back({"sprites_on_screen", (double)busiest});
+    if (found == 0)
+        std::cout << "sprites/smb: no sprites found\n";
+}
+
+void Benchmark::run(const std::string &filter) {
+    this->filter = filter;
+    opcodes();
+    addressingModes();
+    wholeROM("rom/nestest_instructions", "nestest.nes", 0xC000, traceNone);
+    wholeROM("rom/snake_instructions", "snake.bin", 0x0000, traceNone);
+    frames("rom/smb_frames", "Super-Mario-Bros.nes", false);
+    frames("profile/smb_frames", "Super-Mario-Bros.nes", true);
+    fusion("Super-Mario-Bros.nes");
+    idleSkip("Super-Mario-Bros.nes");
+    disassemble("disasm/smb_prg", "Super-Mario-Bros.nes");
+    disassembleCoverage("disasm/smb_prg_cdl", "Super-Mario-Bros.nes");
+    movie("Super-Mario-Bros.nes");
+    rendering("Super-Mario-Bros.nes");
+    renderSkip("Super-Mario-Bros.nes");
+    lineReuse("Super-Mario-Bros.nes");
+    spriteEvaluation("Super-Mario-Bros.nes");
+    saveState("Super-Mario-Bros.nes");
+    stateHash("Super-Mario-Bros.nes");
+    observation("Super-Mario-Bros.nes");
+    runAhead("Super-Mario-Bros.nes");
+    stepMany("Super-Mario-Bros.nes");
+    wholeROM("trace/nestest_cpulog", "nestest.nes", 0xC000, traceLog);
+    wholeROM("trace/nestest_buslog", "nestest.nes", 0xC000, traceBus);
+}
+
+void Benchmark::report(std::ostream &out) {
+    for (const Result &result : results) {
+        double ns = result.seconds * 1e9 / result.iterations;
+        double rate = result.itemsPerIteration * result.iterations / result.seconds;
+        out << std::left << std::setw(44) << result.name << std::right
+            << std::setw(14) << std::fixed << std::setprecision(1) << ns << " ns"
+            << std::setw(12) << result.iterations
+            << std::setw(14) << std::setprecision(3) << rate / 1e6 << " M items/s";
+        for (auto &counter : result.counters)
+            out << "  " << counter.first << "=" << std::setprecision(3) << counter.second;
+        out << "\n";
+    }
+    out << std::defaultfloat;
+}
+
+void Benchmark::writeJSON(std::ostream &out) {
+    char date[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+    out << "{\n  \"context\": {\n"
+        << "    \"date\": \"" << date << "\",\n"
+#ifdef __VERSION__
+        << "    \"compiler\": \"" << __VERSION__ << "\",\n"
+#endif
+#ifdef __OPTIMIZE__
+        << "    \"library_build_type\": \"release\",\n"
+#else
+        << "    \"library_build_type\": \"debug\",\n"
+#endif
+        << "    \"cpu_variant\": " << CPU_VARIANT << "\n"
+        << "  },\n  \"benchmarks\": [";
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result &result = results[i];
+        out << (i ? ",\n" : "\n")
+            << "    {\"name\": \"" << result.name << "\""
+            << ", \"iterations\": " << result.iterations
+            << ", \"real_time\": " << std::setprecision(6) << result.seconds * 1e9 / result.iterations
+            << ", \"time_unit\": \"ns\""
+            << ", \"items_per_second\": " << result.itemsPerIteration * result.iterations / result.seconds;
+        for (auto &counter : result.counters)
+            out << ", \"" << counter.first << "\": " << counter.second;
+        out << "}";
+    }
+    out << "\n  ]\n}\n";
+}
@@ -1,21 +1,389 @@
 #include <Controller.h>
 #include <MOS6502.h>
+#include <Instrument.h>
+#include <Hash.h>
 #include <iostream>
 #include <iomanip>
 #include <fstream>
+#include <cstring>
+#include <cstdlib>
 
 Controller::Controller(std::ifstream &ROM) {
-    // Load ROM in memory
-    // ROM.seekg(0x0010, std::ios::beg);
-    // ROM.read((char*)(&memory[ROMADDR]), 3);
-    // ROM.seekg(0x0010, std::ios::beg);
-    // ROM.read((char*)(&memory[0xC000]), 0x4000);
+    info = loadROM(ROM, memory);
+    if (info.iNES) {
+        if (info.mapper != 0)
+            std::cout << "Mapper " << info.mapper << " not supported, running as NROM\n";
+        PPU.loadCHR(ROM, info.CHRSize, info.verticalMirroring);
+        mapNES();
+        CPU.powerOn();
+    }
+    romHash = romChecksum();
+}
+
+Controller::ROMInfo Controller::loadROM(std::ifstream &ROM, uint8_t (&memory)[0x10000]) {
+    ROMInfo info;
+    uint8_t header[16] = {};
+    ROM.seekg(0, std::ios::beg);
+    ROM.read((char*)header, sizeof(header));
+    if (ROM && header[0] == 'N' && header[1] == 'E' && header[2] == 'S' && header[3] == 0x1A) {
+        info.iNES = true;
+        info.PRGSize = header[4] * 0x4000;
+        info.CHRSize = header[5] * 0x2000;
+        info.mapper = (header[6] >> 4) | (header[7] & 0xF0);
+        info.verticalMirroring = header[6] & 0x01;
+
+        // Skip the trainer if present
+        ROM.seekg((header[6] & 0x04) ? 16 + 512 : 16, std::ios::beg);
+        int size = info.PRGSize < 0x8000 ? info.PRGSize : 0x8000;
+        ROM.read((char*)(&memory[ROMADDR]), size);
+        // 16KB PRG is mirrored into $C000
+        if (size == 0x4000)
+            memcpy(&memory[0xC000], &memory[ROMADDR], 0x4000);
+        ROM.seekg(info.PRGSize - size, std::ios::cur);
+        return info;
+    }
+
+    // Raw binary
+    ROM.clear();
     ROM.seekg(0, std::ios::beg);
     ROM.read((char*)(&memory[0]), 0x4000);
+    ROM.clear();
+    return info;
+}
+
+// Pages the CPU can't serve from the flat array go through ioRead/ioWrite
+void Controller::mapNES() {
+    CPU.attachIO(this);
+    CPU.mapPages(0x08, 0x1F, MOS6502::pageIORead | MOS6502::pageIOWrite); // RAM mirrors
+    CPU.mapPages(0x20, 0x3F, MOS6502::pageIORead | MOS6502::pageIOWrite); // PPU registers
+    CPU.mapPages(0x40, 0x40, MOS6502::pageIORead | MOS6502::pageIOWrite); // APU and I/O
+    CPU.mapPages(0x80, 0xFF, MOS6502::pageIOWrite);                       // ROM
+}
+
+uint8_t Controller::ioRead(uint16_t addr) {
+    INSTRUMENT_ZONE(zoneBus);
+    if (addr < 0x2000)
+        return memory[addr & 0x07FF];
+    if (addr < 0x4000) {
+        deadlineStale = true;
+        return PPU.readRegister(addr);
+    }
+    if (addr == JOYPAD1 || addr == JOYPAD2)
+        return JOYPADOPENBUS | joypads[addr - JOYPAD1].read();
+    if (addr < 0x4018)
+        return 0;
+    return memory[addr];
+}
+
+void Controller::ioWrite(uint16_t addr, uint8_t value) {
+    INSTRUMENT_ZONE(zoneBus);
+    if (addr < 0x2000) {
+        if (stateHashing)
+            tracked.write(addr & 0x07FF, memory[addr & 0x07FF], value);
+        memory[addr & 0x07FF] = value;
+    }
+    else if (addr < 0x4000) {
+        deadlineStale = true;
+        PPU.writeRegister(addr, value);
+    }
+    else if (addr == OAMDMA) {
+        // Sprite 0 may move
+        deadlineStale = true;
+        uint16_t page = value << 8;
+        for (int i = 0; i < 256; i++) {
+            uint16_t src = page | i;
+            PPU.writeOAM(src < 0x2000 ? memory[src & 0x07FF] : memory[src]);
+        }
+        // 513 cycles, plus one for alignment on an odd cycle
+        CPU.addCycles(513 + (CPU.getState().totalClk & 1));
+    }
+    else if (addr == JOYPAD1) {
+        joypads[0].strobe(value);
+        joypads[1].strobe(value);
+    }
+    else if (addr < 0x8000) {
+        memory[addr] = value;
+    }
+}
+
+// RAM, and the PPU registers whose reads only change state once: PPUSTATUS
+// clears vblank and the write latch, then reads the same until the next
+// PPU event. OAMDATA reads don't increment the address
+bool Controller::idempotentRead(uint16_t addr) {
+    if (addr < 0x2000)
+        return true;
+    if (addr < 0x4000)
+        return (addr & 7) == 2 || (addr & 7) == 4;
+    return false;
+}
+
+// RAM mirrors only, the PPU registers have no side effect free view yet
+uint8_t Controller::peek(uint16_t addr) {
+    if (addr < 0x2000)
+        return memory[addr & 0x07FF];
+    return 0;
+}
+
+void Controller::poke(uint16_t addr, uint8_t value) {
+    if (addr >= 0x2000)
+        return;
+    if (stateHashing)
+        tracked.write(addr & 0x07FF, memory[addr & 0x07FF], value);
+    memory[addr & 0x07FF] = value;
+}
+
+void Controller::setBusAccurate(bool enabled) {
+    CPU.setBusAccurate(enabled);
+}
+
+void Controller::setLogging(bool enabled) {
+    CPU.setLogging(enabled);
+}
+
+void Controller::setProfiler(Profiler *profiler) {
+    CPU.setProfiler(profiler);
+}
+
+void Controller::setStats(OpcodeStats *stats) {
+    CPU.setStats(stats);
+}
+
+void Controller::setFusion(const FusionTable *table) {
+    fusion = table != nullptr;
+    CPU.setFusion(table);
+}
+
+uint64_t Controller::fusedInstructions() const {
+    return CPU.fusedInstructions();
+}
+
+void Controller::setIdleSkip(bool enabled) {
+    idleSkip = enabled;
+    CPU.setIdleSkip(enabled);
+}
+
+uint64_t Controller::idleCyclesSkipped() const {
+    return CPU.idleCyclesSkipped();
+}
+
+void Controller::step() {
+    int cycles = CPU.executeOP(memory);
+    PPU.tick(cycles * 3);
+    if (renderer && PPU.getFrame() != renderFrame) {
+        renderer->submit();
+        PPU.setRenderLog(renderer->log());
+        renderFrame = PPU.getFrame();
+    }
+    CPU.setNMI(PPU.NMI_occurred);
+    if ((fusion || idleSkip) && (deadlineStale || CPU.cyclesToDeadline() < MAXINSTRUCTIONCYCLES)) {
+        CPU.setDeadline(PPU.dotsUntilEvent() / 3);
+        deadlineStale = false;
+    }
 }
 
 void Controller::run() {
     while(1) {
-        CPU.executeOP(memory);
+        step();
+    }
+}
+
+void Controller::reset() {
+    CPU.reset();
+    PPU.reset();
+    deadlineStale = true;
+}
+
+void Controller::setButtons(int port, uint8_t buttons) {
+    joypads[port & 1].setButtons(buttons);
+}
+
+uint64_t Controller::frame() const {
+    return PPU.getFrame();
+}
+
+const uint8_t *Controller::ram() const {
+    return memory;
+}
+
+uint64_t Controller::checksum() const {
+    MOS6502::CPUState state = CPU.getState();
+    uint64_t hash = hashBytes(HASHSEED, memory, 0x800);
+    hash = hashValue(hash, state.PC | state.SP << 16 | (uint64_t)state.AC << 24 | (uint64_t)state.X << 32
+                               | (uint64_t)state.Y << 40 | (uint64_t)state.SR << 48);
+    hash = hashValue(hash, (uint32_t)state.totalClk);
+    return PPU.hash(hash);
+}
+
+void Controller::setStateHashing(bool enabled) {
+    stateHashing = enabled;
+    CPU.setStateHash(enabled ? &tracked : nullptr);
+    PPU.setStateHash(enabled ? &tracked : nullptr);
+    if (enabled)
+        rehash(tracked);
+}
+
+void Controller::maskStateHash(uint16_t first, uint16_t last, bool masked) {
+    tracked.mask(first, last, masked);
+    if (stateHashing)
+        rehash(tracked);
+}
+
+void Controller::rehash(StateHash &hash) const {
+    hash.clear();
+    hash.add(StateHash::RAM, memory, 0x800);
+    hash.add(StateHash::PRGRAM, memory + PRGRAMADDR, 0x2000);
+    PPU.rehash(hash);
+}
+
+uint64_t Controller::stateHash() const {
+    uint64_t memories;
+    if (stateHashing) {
+        memories = tracked.value();
+#ifdef DEBUG
+        StateHash full = tracked;
+        rehash(full);
+        if (full.value() != memories) {
+            std::cerr << "State hash " << std::hex << memories << " differs from a full rehash " << full.value()
+                      << std::dec << " at frame " << frame() << "\n";
+            abort();
+        }
+#endif
+    }
+    else {
+        StateHash full = tracked;
+        rehash(full);
+        memories = full.value();
+    }
+    MOS6502::CPUState state = CPU.getState();
+    uint64_t hash = hashValue(HASHSEED ^ memories, state.PC | state.SP << 16 | (uint64_t)state.AC << 24
+                                                      | (uint64_t)state.X << 32 | (uint64_t)state.Y << 40
+                                                      | (uint64_t)state.SR << 48);
+    return PPU.registerHash(hash);
+}
+
+uint64_t Controller::romChecksum() const {
+    return hashBytes(HASHSEED, memory + ROMADDR, 0x10000 - ROMADDR);
+}
+
+void Controller::saveState(SaveState &state) const {
+    state.magic = STATEMAGIC;
+    state.version = STATEVERSION;
+    state.rom = romHash;
+    state.CPU = CPU.snapshot();
+    PPU.saveState(state.PPU);
+    state.joypads[0] = joypads[0];
+    state.joypads[1] = joypads[1];
+    memcpy(state.RAM, memory, sizeof(state.RAM));
+    memcpy(state.PRGRAM, memory + PRGRAMADDR, sizeof(state.PRGRAM));
+    state.stateHash = stateHashing ? tracked.value() : 0;
+    state.stateHashMask = stateHashing ? tracked.maskID() : 0;
+}
+
+bool Controller::loadState(const SaveState &state) {
+    if (state.magic != STATEMAGIC || state.version != STATEVERSION || state.rom != romHash)
+        return false;
+    CPU.restore(state.CPU);
+    PPU.loadState(state.PPU);
+    joypads[0] = state.joypads[0];
+    joypads[1] = state.joypads[1];
+    memcpy(memory, state.RAM, sizeof(state.RAM));
+    memcpy(memory + PRGRAMADDR, state.PRGRAM, sizeof(state.PRGRAM));
+    // The saved hash holds when it was tracked under the same mask
+    if (stateHashing) {
+        if (state.stateHashMask == tracked.maskID())
+            tracked.set(state.stateHash);
+        else
+            rehash(tracked);
+    }
+    deadlineStale = true;
+    if (renderer) {
+        PPU.inputs(restartInputs);
+        renderer->restart(restartInputs);
+        renderFrame = PPU.getFrame();
+    }
+    return true;
+}
+
+void Controller::setRendering(RenderMode mode) {
+    PPU.setRenderLog(nullptr);
+    renderer.reset();
+    if (mode == renderOff)
+        return;
+    std::unique_ptr<PPUInputs> start(new PPUInputs());
+    PPU.inputs(*start);
+    renderer.reset(new RenderPipeline(*start, mode == renderThreaded));
+    renderer->setSkip(renderEvery);
+    renderer->setLineReuse(lineReuse, reuseCheck);
+    PPU.setRenderLog(renderer->log());
+    renderFrame = PPU.getFrame();
+}
+
+void Controller::setRenderSkip(int every) {
+    renderEvery = every;
+    if (renderer)
+        renderer->setSkip(every);
+}
+
+void Controller::requestFrame() {
+    if (renderer)
+        renderer->request();
+}
+
+void Controller::setLineReuse(bool enabled, bool verify) {
+    lineReuse = enabled;
+    reuseCheck = verify;
+    if (renderer)
+        renderer->setLineReuse(enabled, verify);
+}
+
+PPURenderer::Stats Controller::renderStats() {
+    if (!renderer)
+        return PPURenderer::Stats();
+    return renderer->stats();
+}
+
+const uint8_t *Controller::framePixels() {
+    if (!renderer)
+        return nullptr;
+    renderer->flush();
+    return renderer->pixels();
+}
+
+uint64_t Controller::renderChecksum() {
+    if (!renderer)
+        return 0;
+    renderer->flush();
+    return renderer->checksum();
+}
+
+const Controller::ROMInfo &Controller::romInfo() const {
+    return info;
+}
+
+void Controller::setCoverage(Coverage *coverage) {
+    CPU.setCoverage(coverage);
+    PPU.setCoverage(coverage);
+}
+
+void Controller::attachDebugger(Debugger &debugger) {
+    debugger.attach(CPU, memory);
+}
+
+bool Controller::runFrameOrStop(Debugger &debugger) {
+    INSTRUMENT_ZONE(zoneFrame);
+    uint64_t frame = PPU.getFrame();
+    while (PPU.getFrame() == frame) {
+        step();
+        if (debugger.stopped())
+            return true;
+    }
+    return false;
+}
+
+void Controller::runFrame() {
+    INSTRUMENT_ZONE(zoneFrame);
+    uint64_t frame = PPU.getFrame();
+    while (PPU.getFrame() == frame) {
+        step();
     }
-}
\ No newline at end of file
+}
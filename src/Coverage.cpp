@@ -0,0 +1,87 @@
+#include <Coverage.h>
+#include <algorithm>
+#include <iomanip>
+
+Coverage::Coverage(size_t PRGSize, size_t CHRSize) : prg(PRGSize), chr(CHRSize) {
+    size_t mapped = std::min(PRGSize, (size_t)0x8000);
+    prgMask = mapped ? mapped - 1 : 0;
+}
+
+void Coverage::clear() {
+    std::fill(prg.begin(), prg.end(), 0);
+    std::fill(chr.begin(), chr.end(), 0);
+    lastOpcode = 0;
+    currentLength = 0;
+}
+
+size_t Coverage::PRGSize() const {
+    return prg.size();
+}
+
+size_t Coverage::CHRSize() const {
+    return chr.size();
+}
+
+const uint8_t *Coverage::PRG() const {
+    return prg.data();
+}
+
+const uint8_t *Coverage::CHR() const {
+    return chr.data();
+}
+
+bool Coverage::covers(uint16_t addr) const {
+    return addr >= PRGBASE && !prg.empty();
+}
+
+bool Coverage::load(std::istream &in) {
+    std::vector<uint8_t> data(prg.size() + chr.size());
+    in.read((char *)data.data(), data.size());
+    if (in.gcount() != (std::streamsize)data.size() || in.peek() != EOF)
+        return false;
+    std::copy(data.begin(), data.begin() + prg.size(), prg.begin());
+    std::copy(data.begin() + prg.size(), data.end(), chr.begin());
+    return true;
+}
+
+void Coverage::save(std::ostream &out) const {
+    out.write((const char *)prg.data(), prg.size());
+    out.write((const char *)chr.data(), chr.size());
+}
+
+bool Coverage::merge(const Coverage &other) {
+    if (other.prg.size() != prg.size() || other.chr.size() != chr.size())
+        return false;
+    for (size_t i = 0; i < prg.size(); i++)
+        prg[i] |= other.prg[i];
+    for (size_t i = 0; i < chr.size(); i++)
+        chr[i] |= other.chr[i];
+    return true;
+}
+
+void Coverage::report(std::ostream &out) const {
+    size_t code = 0, data = 0, both = 0;
+    for (uint8_t flags : prg) {
+        if ((flags & prgCode) && (flags & prgData))
+            both++;
+        else if (flags & prgCode)
+            code++;
+        else if (flags & prgData)
+            data++;
+    }
+    size_t drawn = 0, read = 0;
+    for (uint8_t flags : chr) {
+        if (flags & chrDrawn)
+            drawn++;
+        if (flags & chrRead)
+            read++;
+    }
+    auto percent = [](size_t count, size_t total) { return total ? 100.0 * count / total : 0.0; };
+    out << std::fixed << std::setprecision(1)
+        << "PRG " << prg.size() << " bytes: code " << code << " (" << percent(code, prg.size()) << "%), data " << data
+        << " (" << percent(data, prg.size()) << "%), both " << both << ", unused "
+        << prg.size() - code - data - both << "\n"
+        << "CHR " << chr.size() << " bytes: drawn " << drawn << " (" << percent(drawn, chr.size()) << "%), read "
+        << read << "\n"
+        << std::defaultfloat;
+}
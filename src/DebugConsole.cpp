@@ -0,0 +1,484 @@
+#include <DebugConsole.h>
+#include <Disassembler.h>
+#include <OpcodeInfo.h>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <csignal>
+#include <cstring>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+
+// Ctrl-C in the REPL pauses the CPU instead of ending the process
+static Debugger *interruptTarget = nullptr;
+
+static void onInterrupt(int) {
+    if (interruptTarget)
+        interruptTarget->pause();
+}
+
+static std::string hex(unsigned value, int digits) {
+    std::stringstream text;
+    text << std::setw(digits) << std::setfill('0') << std::hex << std::uppercase << value;
+    return text.str();
+}
+
+// "addr,length" style packet arguments, up to the first ':' or ';'
+static bool hexFields(const std::string &text, std::vector<unsigned> &values) {
+    values.clear();
+    std::string fields = text.substr(0, text.find_first_of(":;"));
+    std::stringstream stream(fields);
+    std::string field;
+    while (std::getline(stream, field, ',')) {
+        unsigned value;
+        if (!Debugger::parseHex(field, value))
+            return false;
+        values.push_back(value);
+    }
+    return !values.empty();
+}
+
+DebugConsole::DebugConsole(Controller &console, Debugger &debugger) : console(console), debugger(debugger) {}
+
+void DebugConsole::repl(std::istream &in, std::ostream &out) {
+    interruptTarget = &debugger;
+    void (*previous)(int) = signal(SIGINT, onInterrupt);
+
+    // Stop before the first instruction
+    debugger.pause();
+    runUntilStop();
+    showStop(out);
+
+    std::string line;
+    out << "> " << std::flush;
+    while (std::getline(in, line) && command(line, out))
+        out << "> " << std::flush;
+
+    signal(SIGINT, previous);
+    interruptTarget = nullptr;
+}
+
+void DebugConsole::help(std::ostream &out) {
+    out << "  b <addr> [cond...]        breakpoint, every condition (A==10, X>=$80, S<F0) must hold\n"
+        << "  d <addr>                  delete breakpoint\n"
+        << "  w <addr>[-<last>] [r|w|rw] watchpoint, writes by default\n"
+        << "  dw <addr>                 delete the watchpoints starting at addr\n"
+        << "  l                         list breakpoints and watchpoints\n"
+        << "  c                         continue, Ctrl-C pauses\n"
+        << "  s / n / f                 step in / over / out\n"
+        << "  r [<reg> <value>]         show registers, or set A X Y S P PC\n"
+        << "  i [addr] [count]          disassemble, from PC by default\n"
+        << "  x <addr> [count]          dump memory\n"
+        << "  e <addr> <byte>...        edit memory\n"
+        << "  q                         quit\n"
+        << "Numbers are hex, with or without $\n";
+}
+
+bool DebugConsole::command(const std::string &line, std::ostream &out) {
+    std::stringstream words(line);
+    std::string name;
+    if (!(words >> name))
+        return true;
+    std::vector<std::string> args;
+    std::string word;
+    while (words >> word)
+        args.push_back(word);
+    unsigned addr = 0;
+    bool hasAddr = !args.empty() && Debugger::parseHex(args[0].substr(0, args[0].find('-')), addr) && addr <= 0xFFFF;
+
+    if (name == "q" || name == "quit") {
+        return false;
+    }
+    else if (name == "h" || name == "help") {
+        help(out);
+    }
+    else if (name == "c" || name == "s" || name == "n" || name == "f") {
+        if (name == "c")
+            debugger.resume();
+        else if (name == "s")
+            debugger.stepIn();
+        else if (name == "n")
+            debugger.stepOver();
+        else
+            debugger.stepOut();
+        runUntilStop();
+        showStop(out);
+    }
+    else if (name == "b" && hasAddr) {
+        std::vector<Debugger::Condition> conditions;
+        for (size_t i = 1; i < args.size(); i++) {
+            Debugger::Condition condition;
+            if (!Debugger::Condition::parse(args[i], condition)) {
+                out << "Bad condition " << args[i] << "\n";
+                return true;
+            }
+            conditions.push_back(condition);
+        }
+        debugger.setBreakpoint(addr, conditions);
+    }
+    else if (name == "d" && hasAddr) {
+        debugger.clearBreakpoint(addr);
+    }
+    else if (name == "w" && hasAddr) {
+        unsigned last = addr;
+        size_t dash = args[0].find('-');
+        if (dash != std::string::npos && (!Debugger::parseHex(args[0].substr(dash + 1), last) || last > 0xFFFF || last < addr)) {
+            out << "Bad range " << args[0] << "\n";
+            return true;
+        }
+        std::string access = args.size() > 1 ? args[1] : "w";
+        debugger.addWatchpoint(addr, last, access.find('r') != std::string::npos, access.find('w') != std::string::npos);
+    }
+    else if (name == "dw" && hasAddr) {
+        debugger.removeWatchpoint(addr);
+    }
+    else if (name == "l") {
+        for (uint16_t bp : debugger.breakpointList()) {
+            out << "  break $" << hex(bp, 4);
+            if (const std::vector<Debugger::Condition> *conditions = debugger.breakpointConditions(bp)) {
+                for (const Debugger::Condition &condition : *conditions)
+                    out << " " << condition.toString();
+            }
+            out << "\n";
+        }
+        for (const Debugger::Watchpoint &w : debugger.watchpoints()) {
+            out << "  watch $" << hex(w.first, 4) << "-$" << hex(w.last, 4) << " " << (w.read ? "r" : "")
+                << (w.write ? "w" : "") << "\n";
+        }
+    }
+    else if (name == "r" && args.empty()) {
+        showRegisters(out);
+    }
+    else if (name == "r" && args.size() == 2) {
+        unsigned value;
+        MOS6502::CPUState state = debugger.registers();
+        std::string reg = args[0];
+        for (char &c : reg)
+            c = toupper(c);
+        if (!Debugger::parseHex(args[1], value) || value > (reg == "PC" ? 0xFFFFu : 0xFFu)) {
+            out << "Bad value " << args[1] << "\n";
+            return true;
+        }
+        if (reg == "A") state.AC = value;
+        else if (reg == "X") state.X = value;
+        else if (reg == "Y") state.Y = value;
+        else if (reg == "S") state.SP = value;
+        else if (reg == "P") state.SR = value;
+        else if (reg == "PC") state.PC = value;
+        else {
+            out << "Unknown register " << args[0] << "\n";
+            return true;
+        }
+        debugger.setRegisters(state);
+        showRegisters(out);
+    }
+    else if (name == "i") {
+        unsigned count = 10;
+        if (args.size() > 1 && !Debugger::parseHex(args[1], count))
+            count = 10;
+        uint16_t at = hasAddr ? addr : debugger.registers().PC;
+        for (unsigned i = 0; i < count; i++) {
+            std::string line = instruction(at);
+            out << line << "\n";
+            at += instructionLength(opcodeInfo[debugger.peek(at)].mode);
+        }
+    }
+    else if (name == "x" && hasAddr) {
+        unsigned count = 16;
+        if (args.size() > 1 && !Debugger::parseHex(args[1], count))
+            count = 16;
+        for (unsigned i = 0; i < count; i++) {
+            uint16_t at = addr + i;
+            if (i % 16 == 0)
+                out << (i ? "\n" : "") << "$" << hex(at, 4) << ":";
+            out << " " << hex(debugger.peek(at), 2);
+        }
+        out << "\n";
+    }
+    else if (name == "e" && hasAddr && args.size() > 1) {
+        for (size_t i = 1; i < args.size(); i++) {
+            unsigned value;
+            if (!Debugger::parseHex(args[i], value) || value > 0xFF) {
+                out << "Bad byte " << args[i] << "\n";
+                return true;
+            }
+            debugger.poke(addr + i - 1, value);
+        }
+    }
+    else {
+        out << "Unknown command, h for help\n";
+    }
+    return true;
+}
+
+// In a GDB session a Ctrl-C from the client pauses, a disconnect too
+void DebugConsole::runUntilStop() {
+    while (!console.runFrameOrStop(debugger)) {
+        if (client < 0)
+            continue;
+        pollfd fd = {client, POLLIN, 0};
+        if (poll(&fd, 1, 0) <= 0)
+            continue;
+        if (!readClient()) {
+            debugger.pause();
+            continue;
+        }
+        size_t interrupt = input.find('\x03');
+        if (interrupt != std::string::npos) {
+            input.erase(interrupt, 1);
+            debugger.pause();
+        }
+    }
+}
+
+void DebugConsole::showStop(std::ostream &out) {
+    const Debugger::Stop &stop = debugger.lastStop();
+    switch (stop.reason) {
+        case Debugger::stopBreakpoint:
+            out << "Breakpoint";
+            break;
+        case Debugger::stopWatchpoint:
+            out << "Watchpoint, " << (stop.write ? "write $" : "read $") << hex(stop.addr, 4) << " = $" << hex(stop.value, 2)
+                << ",";
+            break;
+        case Debugger::stopStep:
+            out << "Step";
+            break;
+        default:
+            out << "Paused";
+            break;
+    }
+    out << " at $" << hex(stop.PC, 4) << "\n";
+    showRegisters(out);
+}
+
+void DebugConsole::showRegisters(std::ostream &out) {
+    MOS6502::CPUState state = debugger.registers();
+    out << "PC:" << hex(state.PC, 4) << " A:" << hex(state.AC, 2) << " X:" << hex(state.X, 2) << " Y:" << hex(state.Y, 2)
+        << " P:" << hex(state.SR, 2) << " S:" << hex(state.SP, 2) << " CYC:" << std::dec << state.totalClk << "\n"
+        << instruction(state.PC) << "\n";
+}
+
+// "8057  4C 57 80  JMP $8057"
+std::string DebugConsole::instruction(uint16_t addr) {
+    char text[Disassembler::MAXTEXT];
+    uint8_t bytes[3] = {debugger.peek(addr), debugger.peek(addr + 1), debugger.peek(addr + 2)};
+    int length = Disassembler::format(addr, bytes[0], bytes[1], bytes[2], text);
+    std::string line = hex(addr, 4) + "  ";
+    for (int i = 0; i < 3; i++)
+        line += i < length ? hex(bytes[i], 2) + " " : "   ";
+    return line + " " + text;
+}
+
+bool DebugConsole::serve(int port, std::ostream &log) {
+    int server = socket(AF_INET, SOCK_STREAM, 0);
+    if (server < 0)
+        return false;
+    int reuse = 1;
+    setsockopt(server, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(server, (sockaddr *)&address, sizeof(address)) < 0 || listen(server, 1) < 0) {
+        log << "Can't listen on port " << port << "\n";
+        close(server);
+        return false;
+    }
+    log << "Waiting for a debugger on 127.0.0.1:" << port << "\n";
+    client = accept(server, nullptr, nullptr);
+    close(server);
+    if (client < 0)
+        return false;
+
+    // Clients expect a stopped target
+    debugger.pause();
+    runUntilStop();
+
+    std::string packet;
+    bool done = false;
+    while (!done && receive(packet))
+        send(reply(packet, done));
+    close(client);
+    client = -1;
+    input.clear();
+    return true;
+}
+
+bool DebugConsole::readClient() {
+    char buffer[4096];
+    ssize_t received = recv(client, buffer, sizeof(buffer), 0);
+    if (received <= 0)
+        return false;
+    input.append(buffer, received);
+    return true;
+}
+
+// "$data#checksum"; acknowledgements and stray bytes in between are dropped
+bool DebugConsole::receive(std::string &packet) {
+    while (true) {
+        size_t start = input.find('$');
+        if (start == std::string::npos) {
+            input.clear();
+        }
+        else {
+            input.erase(0, start);
+            size_t end = input.find('#');
+            if (end != std::string::npos && end + 3 <= input.size()) {
+                packet = input.substr(1, end - 1);
+                unsigned checksum = 0, expected;
+                for (char c : packet)
+                    checksum += (uint8_t)c;
+                bool valid = Debugger::parseHex(input.substr(end + 1, 2), expected) && expected == (checksum & 0xFF);
+                input.erase(0, end + 3);
+                ::send(client, valid ? "+" : "-", 1, MSG_NOSIGNAL);
+                if (valid)
+                    return true;
+                continue;
+            }
+        }
+        if (!readClient())
+            return false;
+    }
+}
+
+void DebugConsole::send(const std::string &packet) {
+    unsigned checksum = 0;
+    for (char c : packet)
+        checksum += (uint8_t)c;
+    std::string framed = "$" + packet + "#" + hex(checksum & 0xFF, 2);
+    ::send(client, framed.data(), framed.size(), MSG_NOSIGNAL);
+}
+
+std::string DebugConsole::stopReply() {
+    const Debugger::Stop &stop = debugger.lastStop();
+    if (stop.reason == Debugger::stopPause)
+        return "S02";
+    if (stop.reason == Debugger::stopWatchpoint)
+        return std::string("T05") + (stop.write ? "watch:" : "rwatch:") + hex(stop.addr, 4) + ";";
+    return "S05";
+}
+
+std::string DebugConsole::reply(const std::string &packet, bool &done) {
+    std::vector<unsigned> fields;
+    char kind = packet.empty() ? 0 : packet[0];
+    std::string args = packet.size() > 1 ? packet.substr(1) : "";
+
+    switch (kind) {
+        case '?':
+            return stopReply();
+        case 'g': {
+            MOS6502::CPUState state = debugger.registers();
+            return hex(state.AC, 2) + hex(state.X, 2) + hex(state.Y, 2) + hex(state.SP, 2) + hex(state.SR, 2)
+                   + hex(state.PC & 0xFF, 2) + hex(state.PC >> 8, 2);
+        }
+        case 'G': {
+            uint8_t bytes[7];
+            for (int i = 0; i < 7; i++) {
+                unsigned value;
+                if (args.size() < 14 || !Debugger::parseHex(args.substr(i * 2, 2), value))
+                    return "E01";
+                bytes[i] = value;
+            }
+            MOS6502::CPUState state = debugger.registers();
+            state.AC = bytes[0];
+            state.X = bytes[1];
+            state.Y = bytes[2];
+            state.SP = bytes[3];
+            state.SR = bytes[4];
+            state.PC = bytes[5] | (bytes[6] << 8);
+            debugger.setRegisters(state);
+            return "OK";
+        }
+        case 'm': {
+            if (!hexFields(args, fields) || fields.size() != 2 || fields[1] > 0x1000)
+                return "E01";
+            std::string data;
+            for (unsigned i = 0; i < fields[1]; i++)
+                data += hex(debugger.peek(fields[0] + i), 2);
+            return data;
+        }
+        case 'M': {
+            size_t colon = args.find(':');
+            if (!hexFields(args, fields) || fields.size() != 2 || colon == std::string::npos
+                || args.size() - colon - 1 < fields[1] * 2)
+                return "E01";
+            for (unsigned i = 0; i < fields[1]; i++) {
+                unsigned value;
+                if (!Debugger::parseHex(args.substr(colon + 1 + i * 2, 2), value))
+                    return "E01";
+                debugger.poke(fields[0] + i, value);
+            }
+            return "OK";
+        }
+        case 'c':
+        case 's':
+            if (kind == 'c')
+                debugger.resume();
+            else
+                debugger.stepIn();
+            runUntilStop();
+            return stopReply();
+        // Z0/Z1 breakpoint, Z2 write, Z3 read and Z4 access watchpoints
+        case 'Z':
+        case 'z': {
+            if (!hexFields(args, fields) || fields.size() != 3 || fields[1] > 0xFFFF)
+                return "E01";
+            uint16_t addr = fields[1];
+            unsigned type = fields[0];
+            if (type <= 1) {
+                if (kind == 'Z')
+                    debugger.setBreakpoint(addr);
+                else
+                    debugger.clearBreakpoint(addr);
+            }
+            else if (type <= 4) {
+                if (kind == 'Z')
+                    debugger.addWatchpoint(addr, addr + (fields[2] ? fields[2] - 1 : 0), type != 2, type != 3);
+                else
+                    debugger.removeWatchpoint(addr);
+            }
+            else {
+                return "";
+            }
+            return "OK";
+        }
+        case 'q':
+            if (packet.compare(0, 10, "qSupported") == 0)
+                return "PacketSize=4000";
+            if (packet == "qAttached")
+                return "1";
+            // monitor <REPL command>, hex encoded both ways
+            if (packet.compare(0, 6, "qRcmd,") == 0) {
+                std::string line;
+                for (size_t i = 6; i + 1 < packet.size(); i += 2) {
+                    unsigned value;
+                    if (!Debugger::parseHex(packet.substr(i, 2), value))
+                        return "E01";
+                    line += (char)value;
+                }
+                std::stringstream out;
+                if (!command(line, out))
+                    done = true;
+                std::string text = out.str();
+                if (text.empty())
+                    return "OK";
+                std::string encoded;
+                for (char c : text)
+                    encoded += hex((uint8_t)c, 2);
+                return encoded;
+            }
+            return "";
+        case 'H':
+            return "OK";
+        case 'D':
+        case 'k':
+            done = true;
+            return "OK";
+        default:
+            return "";
+    }
+}
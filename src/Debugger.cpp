@@ -0,0 +1,298 @@
+#include <Debugger.h>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+Debugger::Debugger() {
+    memset(breakpoints, 0, sizeof(breakpoints));
+    stop = {stopNone, 0, 0, 0, false};
+}
+
+void Debugger::attach(MOS6502 &CPU, uint8_t (&memory)[0x10000]) {
+    this->CPU = &CPU;
+    this->memory = &memory;
+    CPU.setDebugger(this);
+    updatePages();
+}
+
+void Debugger::detach() {
+    if (CPU)
+        CPU->setDebugger(nullptr);
+    CPU = nullptr;
+    memory = nullptr;
+    isStopped = false;
+    stepping = false;
+    skipOnce = false;
+    returnSP = returnPC = -1;
+    watchHit = false;
+    updateArmed();
+}
+
+void Debugger::setBreakpoint(uint16_t addr, const std::vector<Condition> &conditions) {
+    breakpoints[addr >> 3] |= 1 << (addr & 7);
+    if (conditions.empty())
+        this->conditions.erase(addr);
+    else
+        this->conditions[addr] = conditions;
+}
+
+void Debugger::clearBreakpoint(uint16_t addr) {
+    breakpoints[addr >> 3] &= ~(1 << (addr & 7));
+    conditions.erase(addr);
+}
+
+bool Debugger::hasBreakpoint(uint16_t addr) const {
+    return breakpoints[addr >> 3] & (1 << (addr & 7));
+}
+
+std::vector<uint16_t> Debugger::breakpointList() const {
+    std::vector<uint16_t> list;
+    for (int addr = 0; addr < 0x10000; addr++) {
+        if (hasBreakpoint(addr))
+            list.push_back(addr);
+    }
+    return list;
+}
+
+const std::vector<Debugger::Condition> *Debugger::breakpointConditions(uint16_t addr) const {
+    auto found = conditions.find(addr);
+    return found == conditions.end() ? nullptr : &found->second;
+}
+
+void Debugger::addWatchpoint(uint16_t first, uint16_t last, bool read, bool write) {
+    watches.push_back({first, std::max(first, last), read, write});
+    updatePages();
+}
+
+void Debugger::removeWatchpoint(uint16_t first) {
+    watches.erase(std::remove_if(watches.begin(), watches.end(), [&](const Watchpoint &w) { return w.first == first; }),
+                  watches.end());
+    updatePages();
+}
+
+const std::vector<Debugger::Watchpoint> &Debugger::watchpoints() const {
+    return watches;
+}
+
+// Only pages under a watchpoint leave the CPU's direct memory path
+void Debugger::updatePages() {
+    if (!CPU)
+        return;
+    bool watched[256] = {};
+    for (const Watchpoint &w : watches) {
+        for (int page = w.first >> 8; page <= w.last >> 8; page++)
+            watched[page] = true;
+    }
+    for (int page = 0; page < 256; page++)
+        CPU->watchPage(page, watched[page]);
+}
+
+void Debugger::resume() {
+    run();
+}
+
+void Debugger::stepIn() {
+    stepping = true;
+    run();
+}
+
+void Debugger::stepOver() {
+    MOS6502::CPUState state = registers();
+    if (peek(state.PC) != OPJSR) {
+        stepIn();
+        return;
+    }
+    // JSR pushes two bytes, its RTS brings SP back above SP - 1
+    returnSP = (uint8_t)(state.SP - 1);
+    returnPC = (uint16_t)(state.PC + 3);
+    run();
+}
+
+void Debugger::stepOut() {
+    returnSP = registers().SP;
+    returnPC = -1;
+    run();
+}
+
+void Debugger::run() {
+    isStopped = false;
+    skipOnce = true;
+    lastOpcode = peek(registers().PC);
+    updateArmed();
+}
+
+void Debugger::pause() {
+    pauseRequested.store(true, std::memory_order_relaxed);
+}
+
+bool Debugger::stopped() const {
+    return isStopped;
+}
+
+const Debugger::Stop &Debugger::lastStop() const {
+    return stop;
+}
+
+void Debugger::updateArmed() {
+    armed = isStopped || skipOnce || stepping || returnSP >= 0 || watchHit;
+}
+
+bool Debugger::check(uint16_t PC) {
+    if (isStopped)
+        return true;
+    MOS6502::CPUState state = registers();
+    uint8_t previous = lastOpcode;
+    lastOpcode = peek(PC);
+
+    StopReason reason = stopNone;
+    if (pauseRequested.exchange(false)) {
+        reason = stopPause;
+    }
+    else if (watchHit) {
+        reason = stopWatchpoint;
+    }
+    else if (skipOnce) {
+        skipOnce = false;
+        updateArmed();
+        return false;
+    }
+    else if (stepping) {
+        reason = stopStep;
+    }
+    else if (returnSP >= 0 && (previous == OPRTS || previous == OPRTI) && state.SP > returnSP
+             && (returnPC < 0 || PC == returnPC)) {
+        reason = stopStep;
+    }
+    if (reason == stopNone && hasBreakpoint(PC) && conditionsHold(PC, state))
+        reason = stopBreakpoint;
+    if (reason == stopNone)
+        return false;
+
+    stop.reason = reason;
+    stop.PC = PC;
+    isStopped = true;
+    skipOnce = false;
+    stepping = false;
+    returnSP = returnPC = -1;
+    watchHit = false;
+    updateArmed();
+    return true;
+}
+
+// The first hit is kept until the CPU reaches the next boundary
+void Debugger::access(uint16_t addr, uint8_t value, bool write) {
+    if (watchHit)
+        return;
+    for (const Watchpoint &w : watches) {
+        if (addr >= w.first && addr <= w.last && (write ? w.write : w.read)) {
+            watchHit = true;
+            stop.addr = addr;
+            stop.value = value;
+            stop.write = write;
+            updateArmed();
+            return;
+        }
+    }
+}
+
+bool Debugger::conditionsHold(uint16_t PC, const MOS6502::CPUState &state) const {
+    const std::vector<Condition> *tests = breakpointConditions(PC);
+    if (!tests)
+        return true;
+    for (const Condition &test : *tests) {
+        uint8_t value;
+        switch (test.reg) {
+            case 'A': value = state.AC; break;
+            case 'X': value = state.X; break;
+            case 'Y': value = state.Y; break;
+            case 'S': value = state.SP; break;
+            default:  value = state.SR; break;
+        }
+        bool holds;
+        switch (test.compare) {
+            case Condition::equal:        holds = value == test.value; break;
+            case Condition::notEqual:     holds = value != test.value; break;
+            case Condition::less:         holds = value < test.value; break;
+            case Condition::lessEqual:    holds = value <= test.value; break;
+            case Condition::greater:      holds = value > test.value; break;
+            default:                      holds = value >= test.value; break;
+        }
+        if (!holds)
+            return false;
+    }
+    return true;
+}
+
+MOS6502::CPUState Debugger::registers() const {
+    return CPU->getState();
+}
+
+void Debugger::setRegisters(const MOS6502::CPUState &state) {
+    CPU->setState(state);
+}
+
+uint8_t Debugger::peek(uint16_t addr) const {
+    return CPU->peek(addr, *memory);
+}
+
+void Debugger::poke(uint16_t addr, uint8_t value) {
+    CPU->poke(addr, value, *memory);
+}
+
+bool Debugger::parseHex(const std::string &text, unsigned &value) {
+    size_t start = 0;
+    if (text.compare(0, 1, "$") == 0)
+        start = 1;
+    else if (text.compare(0, 2, "0x") == 0 || text.compare(0, 2, "0X") == 0)
+        start = 2;
+    if (start >= text.size() || text.size() - start > 8)
+        return false;
+    value = 0;
+    for (size_t i = start; i < text.size(); i++) {
+        if (!isxdigit((unsigned char)text[i]))
+            return false;
+        value = value * 16 + (isdigit((unsigned char)text[i]) ? text[i] - '0' : toupper(text[i]) - 'A' + 10);
+    }
+    return true;
+}
+
+bool Debugger::Condition::parse(const std::string &text, Condition &condition) {
+    std::string compact;
+    for (char c : text) {
+        if (!isspace((unsigned char)c))
+            compact += c;
+    }
+    if (compact.size() < 3)
+        return false;
+    condition.reg = toupper(compact[0]);
+    if (!strchr("AXYSP", condition.reg))
+        return false;
+
+    static const struct
+    {
+        const char *text;
+        Compare compare;
+    } operators[] = {{"==", equal}, {"!=", notEqual}, {"<=", lessEqual}, {">=", greaterEqual},
+                     {"<", less},   {">", greater},   {"=", equal}};
+    for (const auto &op : operators) {
+        size_t length = strlen(op.text);
+        if (compact.compare(1, length, op.text) == 0) {
+            unsigned value;
+            if (!parseHex(compact.substr(1 + length), value) || value > 0xFF)
+                return false;
+            condition.compare = op.compare;
+            condition.value = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string Debugger::Condition::toString() const {
+    static const char *names[] = {"==", "!=", "<", "<=", ">", ">="};
+    std::stringstream text;
+    text << reg << names[compare] << "$" << std::setw(2) << std::setfill('0') << std::hex << std::uppercase << (int)value;
+    return text.str();
+}
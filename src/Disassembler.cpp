@@ -0,0 +1,476 @@
+#include <Disassembler.h>
+#include <OpcodeInfo.h>
+#include <cstring>
+#include <map>
+#include <set>
+#include <sstream>
+
+static const uint8_t OPBRK = 0x00;
+static const uint8_t OPJSR = 0x20;
+static const uint8_t OPRTI = 0x40;
+static const uint8_t OPJMP = 0x4C;
+static const uint8_t OPRTS = 0x60;
+static const uint8_t OPJMPIND = 0x6C;
+
+// Queued for tracing, so a target reached from many places is queued once
+static const uint8_t byteQueued = 0x20;
+
+static const char HEXDIGITS[] = "0123456789ABCDEF";
+
+static char *appendHex(char *p, unsigned value, int digits) {
+    for (int shift = (digits - 1) * 4; shift >= 0; shift -= 4)
+        *p++ = HEXDIGITS[(value >> shift) & 0xF];
+    return p;
+}
+
+static char *appendText(char *p, const char *text) {
+    while (*text)
+        *p++ = *text++;
+    return p;
+}
+
+Disassembler::Disassembler() {
+    memset(flags, 0, sizeof(flags));
+}
+
+int Disassembler::format(uint16_t addr, uint8_t opcode, uint8_t low, uint8_t high, char (&text)[MAXTEXT]) {
+    return render(addr, opcode, low, high, nullptr, text);
+}
+
+int Disassembler::format(uint16_t addr, const uint8_t (&memory)[0x10000], char (&text)[MAXTEXT]) {
+    return render(addr, memory[addr], memory[(uint16_t)(addr + 1)], memory[(uint16_t)(addr + 2)], nullptr, text);
+}
+
+int Disassembler::render(uint16_t addr, uint8_t opcode, uint8_t low, uint8_t high, const Disassembler *symbols,
+                         char (&text)[MAXTEXT]) {
+    const OpcodeInfo &info = opcodeInfo[opcode];
+    uint16_t word = low | (high << 8);
+    char *p = appendText(text, info.mnemonic);
+
+    // Absolute operands below $100 need "a:" or ca65 picks zero page
+    auto operand = [&](uint16_t target, int digits, bool forceAbsolute) {
+        if (forceAbsolute && target < 0x100)
+            p = appendText(p, "a:");
+        if (symbols && symbols->inRange(target) && (symbols->flags[target] & byteLabel))
+            p = symbols->appendLabel(p, target);
+        else
+            p = appendHex(appendText(p, "$"), target, digits);
+    };
+
+    switch (info.mode) {
+        case implied:
+            break;
+        case accumulator:
+            p = appendText(p, " A");
+            break;
+        case immediate:
+            p = appendHex(appendText(p, " #$"), low, 2);
+            break;
+        case zeroPage:
+        case zeroPageX:
+        case zeroPageY:
+            *p++ = ' ';
+            operand(low, 2, false);
+            p = appendText(p, info.mode == zeroPageX ? ",X" : info.mode == zeroPageY ? ",Y" : "");
+            break;
+        case absolute:
+        case absoluteX:
+        case absoluteY:
+            *p++ = ' ';
+            operand(word, 4, opcode != OPJSR && opcode != OPJMP);
+            p = appendText(p, info.mode == absoluteX ? ",X" : info.mode == absoluteY ? ",Y" : "");
+            break;
+        case indirect:
+            p = appendText(p, " (");
+            operand(word, 4, false);
+            *p++ = ')';
+            break;
+        case indirectX:
+            p = appendText(p, " (");
+            operand(low, 2, false);
+            p = appendText(p, ",X)");
+            break;
+        case indirectY:
+            p = appendText(p, " (");
+            operand(low, 2, false);
+            p = appendText(p, "),Y");
+            break;
+        case relative:
+            *p++ = ' ';
+            operand((uint16_t)(addr + 2 + (int8_t)low), 4, false);
+            break;
+    }
+    *p = 0;
+    return instructionLength(info.mode);
+}
+
+void Disassembler::setCoverage(const uint8_t *coverage, uint16_t base, size_t size) {
+    for (size_t i = 0; i < size && base + i < 0x10000; i++) {
+        uint8_t &byte = flags[base + i];
+        byte = (byte & ~(byteExecuted | byteData)) | byteCovered;
+        if (coverage[i] & coveredCode)
+            byte |= byteExecuted;
+        else if (coverage[i] & coveredData)
+            byte |= byteData;
+    }
+}
+
+bool Disassembler::inRange(uint32_t addr) const {
+    return addr >= start && addr <= end;
+}
+
+uint16_t Disassembler::vector(uint16_t addr) const {
+    return image[addr] | (image[addr + 1] << 8);
+}
+
+void Disassembler::entry(uint32_t addr) {
+    if (!inRange(addr))
+        return;
+    flags[addr] |= byteLabel;
+    enqueue(addr);
+}
+
+void Disassembler::enqueue(uint32_t addr) {
+    if (!(flags[addr] & (byteOpcode | byteQueued))) {
+        flags[addr] |= byteQueued;
+        queue[queued++] = addr;
+    }
+}
+
+void Disassembler::analyse(const uint8_t (&memory)[0x10000], uint16_t start, uint16_t end,
+                           const std::vector<uint16_t> &entries) {
+    image = memory;
+    this->start = start;
+    this->end = end;
+    for (int addr = 0; addr < 0x10000; addr++)
+        flags[addr] &= byteExecuted | byteData | byteCovered;
+    queued = 0;
+
+    if (inRange(NMIVEC) && inRange(IRQVEC + 1)) {
+        entry(vector(RESETVEC));
+        entry(vector(NMIVEC));
+        entry(vector(IRQVEC));
+    }
+    for (uint16_t addr : entries)
+        entry(addr);
+    // A CDL run flags every byte of the instructions executed in it, operands
+    // included, so only its first byte is known to start one. The rest of the
+    // run is decoded in order from there. Queued last, these trace first
+    for (uint32_t addr = start; addr <= end; addr++) {
+        if (!(flags[addr] & byteExecuted) || (addr > start && (flags[addr - 1] & byteExecuted)))
+            continue;
+        for (uint32_t at = addr; inRange(at) && (flags[at] & byteExecuted);
+             at += instructionLength(opcodeInfo[image[at]].mode))
+            enqueue(at);
+    }
+    while (queued > 0)
+        trace(queue[--queued]);
+}
+
+// Illegal opcodes end a path unless coverage shows them executed: reached by
+// static tracing they're far more likely to be data. Where a coverage log
+// applies only executed bytes are code, paths it never took stay data
+bool Disassembler::decodable(uint16_t addr, int length) const {
+    const OpcodeInfo &info = opcodeInfo[image[addr]];
+    if (info.illegal && !(flags[addr] & byteExecuted))
+        return false;
+    for (int i = 0; i < length; i++) {
+        uint32_t at = addr + i;
+        if (!inRange(at) || (flags[at] & (byteOpcode | byteOperand)) || ((flags[at] & byteCovered) && !(flags[at] & byteExecuted)))
+            return false;
+    }
+    return true;
+}
+
+void Disassembler::trace(uint16_t addr) {
+    while (true) {
+        uint8_t opcode = image[addr];
+        const OpcodeInfo &info = opcodeInfo[opcode];
+        int length = instructionLength(info.mode);
+        if (!decodable(addr, length))
+            return;
+        flags[addr] |= byteOpcode;
+        for (int i = 1; i < length; i++)
+            flags[addr + i] |= byteOperand;
+
+        uint16_t word = image[(uint16_t)(addr + 1)] | (image[(uint16_t)(addr + 2)] << 8);
+        switch (info.mode) {
+            case relative:
+                entry((uint16_t)(addr + 2 + (int8_t)word));
+                break;
+            case absolute:
+            case absoluteX:
+            case absoluteY:
+            case indirect:
+                if (opcode == OPJSR || opcode == OPJMP)
+                    entry(word);
+                else if (inRange(word))
+                    flags[word] |= byteLabel;
+                break;
+            default:
+                break;
+        }
+        if (opcode == OPJMP || opcode == OPJMPIND || opcode == OPRTS || opcode == OPRTI || opcode == OPBRK || info.cycles == 0)
+            return;
+        if (!inRange((uint32_t)addr + length))
+            return;
+        addr += length;
+    }
+}
+
+bool Disassembler::isCode(uint16_t addr) const {
+    return flags[addr] & (byteOpcode | byteOperand);
+}
+
+size_t Disassembler::codeBytes() const {
+    size_t count = 0;
+    for (uint32_t addr = start; addr <= end; addr++) {
+        if (isCode(addr))
+            count++;
+    }
+    return count;
+}
+
+char *Disassembler::appendLabel(char *p, uint16_t addr) const {
+    if (inRange(NMIVEC) && inRange(IRQVEC + 1)) {
+        if (addr == vector(RESETVEC))
+            return appendText(p, "reset");
+        if (addr == vector(NMIVEC))
+            return appendText(p, "nmi");
+        if (addr == vector(IRQVEC))
+            return appendText(p, "irq");
+    }
+    return appendHex(appendText(p, "L"), addr, 4);
+}
+
+// Labels in the middle of an instruction can't be emitted, operands that
+// point there stay numeric. Data runs break at labels so those stay usable.
+// Executed undocumented opcodes go out as bytes, named in the comment
+void Disassembler::writeListing(std::ostream &out) {
+    for (uint32_t addr = start; addr <= end; addr++) {
+        if ((flags[addr] & byteLabel) && (flags[addr] & byteOperand))
+            flags[addr] &= ~byteLabel;
+    }
+
+    char line[128];
+    char text[MAXTEXT];
+    appendHex(line, start, 4)[0] = 0;
+    out << "; " << codeBytes() << " of " << (end - start + 1) << " bytes traced as code\n"
+        << "        .setcpu \"6502\"\n"
+        << "        .org    $" << line << "\n\n";
+
+    // The vectors become a .word table when nothing else claims those bytes
+    bool vectorTable = inRange(NMIVEC) && inRange(IRQVEC + 1);
+    for (uint32_t addr = NMIVEC; vectorTable && addr <= IRQVEC + 1; addr++) {
+        if (isCode(addr) || (addr != NMIVEC && (flags[addr] & byteLabel)))
+            vectorTable = false;
+    }
+
+    uint32_t addr = start;
+    while (addr <= end) {
+        if (flags[addr] & byteLabel) {
+            char *p = appendLabel(line, addr);
+            *p++ = ':';
+            *p++ = '\n';
+            *p = 0;
+            out << line;
+        }
+
+        char *p = appendText(line, "        ");
+        int length;
+        bool illegal = false;
+        if (flags[addr] & byteOpcode) {
+            length = render(addr, image[addr], image[(uint16_t)(addr + 1)], image[(uint16_t)(addr + 2)], this, text);
+            // ca65 only takes the documented set under .setcpu "6502"
+            illegal = opcodeInfo[image[addr]].illegal;
+            if (illegal) {
+                p = appendText(p, ".byte   ");
+                for (int i = 0; i < length; i++)
+                    p = appendHex(appendText(p, i ? ",$" : "$"), image[addr + i], 2);
+            }
+            else {
+                p = appendText(p, text);
+            }
+        }
+        else if (addr == NMIVEC && vectorTable) {
+            length = 6;
+            p = appendText(p, ".word   ");
+            for (int v = NMIVEC; v <= IRQVEC; v += 2) {
+                uint16_t target = vector(v);
+                if (inRange(target) && (flags[target] & byteLabel))
+                    p = appendLabel(p, target);
+                else
+                    p = appendHex(appendText(p, "$"), target, 4);
+                if (v != IRQVEC)
+                    p = appendText(p, ", ");
+            }
+        }
+        else {
+            p = appendText(p, ".byte   ");
+            length = 0;
+            do {
+                if (length)
+                    *p++ = ',';
+                p = appendHex(appendText(p, "$"), image[addr + length], 2);
+                length++;
+            } while (length < BYTESPERLINE && addr + length <= end && !(flags[addr + length] & (byteLabel | byteOpcode))
+                     && !(vectorTable && addr + length == NMIVEC));
+        }
+
+        // Address and bytes as a comment, padded to a fixed column
+        do
+            *p++ = ' ';
+        while (p < line + 40);
+        p = appendHex(appendText(p, "; $"), addr, 4);
+        if (flags[addr] & byteOpcode) {
+            for (int i = 0; i < length; i++)
+                p = appendHex(appendText(p, " "), image[addr + i], 2);
+            if (illegal)
+                p = appendText(appendText(p, " "), text);
+        }
+        *p++ = '\n';
+        *p = 0;
+        out << line;
+        addr += length;
+    }
+}
+
+bool Disassembler::verifyListing(const std::string &listing, const uint8_t (&memory)[0x10000]) {
+    std::map<std::string, uint32_t> labels;
+    for (int pass = 0; pass < 2; pass++) {
+        // Labels defined above the current line in this pass
+        std::set<std::string> defined;
+        std::istringstream in(listing);
+        std::string line;
+        uint32_t pc = 0;
+        // forward is set for a symbol defined further down, which ca65
+        // assembles as absolute
+        auto value = [&](std::string operand, uint32_t &out, bool &forward) {
+            if (operand.compare(0, 2, "a:") == 0)
+                operand = operand.substr(2);
+            forward = false;
+            if (operand[0] == '$') {
+                out = std::stoul(operand.substr(1), nullptr, 16);
+                return true;
+            }
+            forward = defined.count(operand) == 0;
+            auto label = labels.find(operand);
+            out = label != labels.end() ? label->second : 0;
+            return label != labels.end() || pass == 0;
+        };
+        while (std::getline(in, line)) {
+            line = line.substr(0, line.find(';'));
+            line.erase(line.find_last_not_of(' ') + 1);
+            line.erase(0, line.find_first_not_of(' '));
+            if (line.empty() || line.compare(0, 7, ".setcpu") == 0)
+                continue;
+            if (line.back() == ':') {
+                std::string label = line.substr(0, line.size() - 1);
+                if (pass == 0 && labels.count(label))
+                    return false;
+                labels[label] = pc;
+                defined.insert(label);
+                continue;
+            }
+            std::string op = line.substr(0, line.find(' '));
+            std::string operand = line.size() > op.size() ? line.substr(line.find_first_not_of(' ', op.size())) : "";
+            std::vector<uint8_t> bytes;
+            bool forward;
+            if (op == ".org") {
+                uint32_t org;
+                if (!value(operand, org, forward))
+                    return false;
+                pc = org;
+                continue;
+            }
+            if (op == ".byte" || op == ".word") {
+                std::istringstream items(operand);
+                std::string item;
+                while (std::getline(items, item, ',')) {
+                    uint32_t v;
+                    if (!value(item.substr(item.find_first_not_of(' ')), v, forward))
+                        return false;
+                    bytes.push_back(v & 0xFF);
+                    if (op == ".word")
+                        bytes.push_back(v >> 8);
+                }
+            }
+            else {
+                // The addressing mode from the operand's syntax
+                AddrMode mode = implied;
+                uint32_t target = 0;
+                std::string inner = operand;
+                auto strip = [&](const char *prefix, const char *suffix) {
+                    size_t p = strlen(prefix), q = strlen(suffix);
+                    if (inner.size() < p + q || inner.compare(0, p, prefix) || inner.compare(inner.size() - q, q, suffix))
+                        return false;
+                    inner = inner.substr(p, inner.size() - p - q);
+                    return true;
+                };
+                if (operand.empty())
+                    mode = implied;
+                else if (operand == "A")
+                    mode = accumulator;
+                else if (strip("#", ""))
+                    mode = immediate;
+                else if (strip("(", ",X)"))
+                    mode = indirectX;
+                else if (strip("(", "),Y"))
+                    mode = indirectY;
+                else if (strip("(", ")"))
+                    mode = indirect;
+                else if (strip("", ",X"))
+                    mode = absoluteX;
+                else if (strip("", ",Y"))
+                    mode = absoluteY;
+                else
+                    mode = absolute;
+                forward = false;
+                if (!inner.empty() && mode != accumulator && !value(inner, target, forward))
+                    return false;
+                // ca65 picks zero page whenever the operand is known to fit
+                // and the instruction has the mode, "a:" forces absolute
+                bool zero = inner.compare(0, 2, "a:") != 0 && !forward && target < 0x100;
+                std::vector<AddrMode> modes;
+                if (mode == absolute) {
+                    if (zero)
+                        modes.push_back(zeroPage);
+                    modes.push_back(relative);
+                }
+                else if (mode == absoluteX && zero) {
+                    modes.push_back(zeroPageX);
+                }
+                else if (mode == absoluteY && zero) {
+                    modes.push_back(zeroPageY);
+                }
+                modes.push_back(mode);
+                int found = -1;
+                for (size_t m = 0; m < modes.size() && found < 0; m++) {
+                    for (int opcode = 0; opcode < 256 && found < 0; opcode++) {
+                        const OpcodeInfo &info = opcodeInfo[opcode];
+                        if (!info.illegal && info.mode == modes[m] && op == info.mnemonic)
+                            found = opcode;
+                    }
+                }
+                if (found < 0)
+                    return false;
+                bytes.push_back(found);
+                int length = instructionLength(opcodeInfo[found].mode);
+                if (opcodeInfo[found].mode == relative) {
+                    int offset = (int)target - (int)(pc + 2);
+                    if (pass == 1 && (offset < -128 || offset > 127))
+                        return false;
+                    target = offset & 0xFF;
+                }
+                for (int i = 1; i < length; i++)
+                    bytes.push_back((target >> (8 * (i - 1))) & 0xFF);
+            }
+            for (uint8_t byte : bytes) {
+                if (pass == 1 && (pc > 0xFFFF || memory[pc] != byte))
+                    return false;
+                pc++;
+            }
+        }
+    }
+    return true;
+}
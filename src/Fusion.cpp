@@ -0,0 +1,71 @@
+#include <Fusion.h>
+#include <OpcodeInfo.h>
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+
+FusionTable::FusionTable() {
+    memset(pairs, 0, sizeof(pairs));
+}
+
+// Zero page and stack accesses never leave RAM, anything with a full
+// 16-bit effective address might be a device register unless the
+// instruction doesn't access it (JMP/JSR absolute)
+static bool fusableSecond(const OpcodeInfo &info) {
+    if (info.mode == absolute && info.access == noAccess)
+        return true;
+    switch (info.mode) {
+        case implied:
+        case accumulator:
+        case immediate:
+        case relative:
+        case zeroPage:
+        case zeroPageX:
+        case zeroPageY:
+            return info.cycles != 0;
+        default:
+            return false;
+    }
+}
+
+bool FusionTable::add(uint8_t first, uint8_t second) {
+    if (opcodeInfo[first].cycles == 0 || !fusableSecond(opcodeInfo[second]))
+        return false;
+    if (!pairs[first << 8 | second]) {
+        pairs[first << 8 | second] = true;
+        count++;
+    }
+    return true;
+}
+
+void FusionTable::fromStats(const OpcodeStats &stats, size_t maxPairs) {
+    for (auto &pair : stats.topPairs(0x10000)) {
+        if (count >= maxPairs)
+            break;
+        add(pair.first >> 8, pair.first & 0xFF);
+    }
+}
+
+// The pairs are already sorted by count, only the opcodes are needed
+bool FusionTable::load(std::istream &statsJSON, size_t maxPairs) {
+    std::string text((std::istreambuf_iterator<char>(statsJSON)), std::istreambuf_iterator<char>());
+    size_t pos = text.find("\"pairs\"");
+    size_t end = text.find("\"triples\"");
+    if (pos == std::string::npos)
+        return false;
+    while (count < maxPairs) {
+        pos = text.find("\"ops\"", pos);
+        if (pos == std::string::npos || pos > end)
+            break;
+        size_t first = text.find('"', text.find('[', pos)) + 1;
+        size_t second = text.find('"', text.find(',', first)) + 1;
+        add(strtol(text.substr(first, 2).c_str(), NULL, 16), strtol(text.substr(second, 2).c_str(), NULL, 16));
+        pos = second;
+    }
+    return true;
+}
+
+size_t FusionTable::size() const {
+    return count;
+}
@@ -0,0 +1,175 @@
+#include <Instrument.h>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <algorithm>
+
+#ifdef INSTRUMENT
+
+static const char *zoneNames[zoneCount] = {"other", "frame", "cpu", "ppu", "apu", "bus", "trace", "render"};
+
+namespace Instrument
+{
+    thread_local ThreadCounters counters;
+    std::atomic<bool> tracing(false);
+    std::atomic<uint32_t> traceGeneration(0);
+    size_t traceLimit = 0;
+}
+
+// Counters of live threads are read without synchronisation, stats taken
+// while other threads run are approximate. Only their owners write them,
+// a reset moves the baseline instead
+static std::mutex registryLock;
+static std::vector<Instrument::ThreadCounters *> live;
+static uint64_t retiredTicks[zoneCount];
+static uint64_t retiredCalls[zoneCount];
+static uint64_t baseTicks[zoneCount];
+static uint64_t baseCalls[zoneCount];
+static std::vector<std::pair<int, Instrument::TraceEvent>> retiredTrace;
+static int nextThread = 1;
+
+Instrument::ThreadCounters::ThreadCounters() {
+    last = Instrument::ticks();
+    std::lock_guard<std::mutex> guard(registryLock);
+    thread = nextThread++;
+    live.push_back(this);
+}
+
+Instrument::ThreadCounters::~ThreadCounters() {
+    std::lock_guard<std::mutex> guard(registryLock);
+    for (int zone = 0; zone < zoneCount; zone++) {
+        retiredTicks[zone] += ticks[zone];
+        retiredCalls[zone] += calls[zone];
+    }
+    if (traceGeneration == Instrument::traceGeneration) {
+        for (const TraceEvent &event : trace)
+            retiredTrace.push_back({thread, event});
+    }
+    live.erase(std::find(live.begin(), live.end(), this));
+}
+
+uint64_t Instrument::clockTicks() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool Instrument::enabled() {
+    return true;
+}
+
+// Since power on, with registryLock held
+static void totals(uint64_t (&ticks)[zoneCount], uint64_t (&calls)[zoneCount]) {
+    for (int zone = 0; zone < zoneCount; zone++) {
+        ticks[zone] = retiredTicks[zone];
+        calls[zone] = retiredCalls[zone];
+        for (Instrument::ThreadCounters *thread : live) {
+            ticks[zone] += thread->ticks[zone];
+            calls[zone] += thread->calls[zone];
+        }
+    }
+}
+
+std::vector<ZoneStats> Instrument::stats() {
+    // Touch this thread's counters so it is registered
+    (void)counters.thread;
+    std::lock_guard<std::mutex> guard(registryLock);
+    uint64_t ticks[zoneCount], calls[zoneCount];
+    totals(ticks, calls);
+    std::vector<ZoneStats> result;
+    for (int zone = 0; zone < zoneCount; zone++)
+        result.push_back({zoneNames[zone], ticks[zone] - baseTicks[zone], calls[zone] - baseCalls[zone]});
+    return result;
+}
+
+void Instrument::reset() {
+    (void)counters.thread;
+    std::lock_guard<std::mutex> guard(registryLock);
+    totals(baseTicks, baseCalls);
+}
+
+double Instrument::ticksPerSecond() {
+    static double rate = 0;
+    if (rate == 0) {
+        auto begin = std::chrono::steady_clock::now();
+        uint64_t start = ticks();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        uint64_t end = ticks();
+        rate = (end - start) / std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    }
+    return rate;
+}
+
+void Instrument::startTrace(size_t maxEvents) {
+    std::lock_guard<std::mutex> guard(registryLock);
+    traceLimit = maxEvents;
+    retiredTrace.clear();
+    traceGeneration++;
+    tracing = true;
+}
+
+void Instrument::writeTrace(std::ostream &out) {
+    std::lock_guard<std::mutex> guard(registryLock);
+    std::vector<std::pair<int, TraceEvent>> events = retiredTrace;
+    for (ThreadCounters *thread : live) {
+        if (thread->traceGeneration != traceGeneration)
+            continue;
+        for (const TraceEvent &event : thread->trace)
+            events.push_back({thread->thread, event});
+    }
+    uint64_t origin = UINT64_MAX;
+    for (auto &event : events)
+        origin = std::min(origin, event.second.start);
+    double usPerTick = 1e6 / ticksPerSecond();
+
+    out << "{\"traceEvents\": [";
+    for (size_t i = 0; i < events.size(); i++) {
+        const TraceEvent &event = events[i].second;
+        out << (i ? ",\n" : "\n")
+            << "{\"name\": \"" << zoneNames[event.zone] << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << events[i].first
+            << std::fixed << std::setprecision(3)
+            << ", \"ts\": " << (event.start - origin) * usPerTick
+            << ", \"dur\": " << (event.end - event.start) * usPerTick << "}";
+    }
+    out << "\n]}\n" << std::defaultfloat;
+}
+
+#else
+
+bool Instrument::enabled() {
+    return false;
+}
+
+std::vector<ZoneStats> Instrument::stats() {
+    return std::vector<ZoneStats>();
+}
+
+void Instrument::reset() {
+}
+
+double Instrument::ticksPerSecond() {
+    return 1;
+}
+
+void Instrument::startTrace(size_t maxEvents) {
+}
+
+void Instrument::writeTrace(std::ostream &out) {
+    out << "{\"traceEvents\": []}\n";
+}
+
+#endif
+
+void Instrument::summary(std::ostream &out) {
+    std::vector<ZoneStats> zones = stats();
+    uint64_t total = 0;
+    for (const ZoneStats &zone : zones)
+        total += zone.ticks;
+    if (total == 0)
+        return;
+    for (const ZoneStats &zone : zones) {
+        out << zone.name << " " << std::fixed << std::setprecision(1) << 100.0 * zone.ticks / total << "% ";
+    }
+    out << std::defaultfloat;
+}
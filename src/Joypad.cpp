@@ -0,0 +1,25 @@
+#include <Joypad.h>
+
+void Joypad::setButtons(uint8_t buttons) {
+    this->buttons = buttons;
+    if (latched)
+        shift = buttons;
+}
+
+uint8_t Joypad::getButtons() const {
+    return buttons;
+}
+
+void Joypad::strobe(uint8_t value) {
+    latched = value & 1;
+    if (latched)
+        shift = buttons;
+}
+
+uint8_t Joypad::read() {
+    if (latched)
+        return buttons & 1;
+    uint8_t bit = shift & 1;
+    shift = (shift >> 1) | 0x80;
+    return bit;
+}
@@ -0,0 +1,218 @@
+#include <Lockstep.h>
+#include <MOS6502.h>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <random>
+#include <cstring>
+
+Lockstep::Lockstep(MOS6502 &reference, MOS6502 &candidate)
+    : reference(reference), candidate(candidate) {
+    reference.setLogging(false);
+    candidate.setLogging(false);
+}
+
+void Lockstep::load(const uint8_t (&image)[0x10000], const MOS6502::CPUState &state) {
+    memcpy(refMemory, image, sizeof(refMemory));
+    memcpy(candMemory, image, sizeof(candMemory));
+    reference.setState(state);
+    candidate.setState(state);
+}
+
+static std::string hexValue(int value, int width) {
+    std::stringstream stream;
+    stream << "$" << std::setw(width) << std::setfill('0') << std::hex << std::uppercase << value;
+    return stream.str();
+}
+
+// Execute one instruction on both engines and compare everything observable
+bool Lockstep::step(std::string &reason) {
+    refWrites.clear();
+    candWrites.clear();
+    reference.setWriteLog(&refWrites);
+    candidate.setWriteLog(&candWrites);
+    reference.executeOP(refMemory);
+    candidate.executeOP(candMemory);
+    reference.setWriteLog(nullptr);
+    candidate.setWriteLog(nullptr);
+
+    MOS6502::CPUState ref = reference.getState();
+    MOS6502::CPUState cand = candidate.getState();
+    std::stringstream stream;
+    if (ref.PC != cand.PC)
+        stream << "PC " << hexValue(ref.PC, 4) << " != " << hexValue(cand.PC, 4) << " ";
+    if (ref.SP != cand.SP)
+        stream << "SP " << hexValue(ref.SP, 2) << " != " << hexValue(cand.SP, 2) << " ";
+    if (ref.AC != cand.AC)
+        stream << "A " << hexValue(ref.AC, 2) << " != " << hexValue(cand.AC, 2) << " ";
+    if (ref.X != cand.X)
+        stream << "X " << hexValue(ref.X, 2) << " != " << hexValue(cand.X, 2) << " ";
+    if (ref.Y != cand.Y)
+        stream << "Y " << hexValue(ref.Y, 2) << " != " << hexValue(cand.Y, 2) << " ";
+    if (ref.SR != cand.SR)
+        stream << "SR " << hexValue(ref.SR, 2) << " != " << hexValue(cand.SR, 2) << " ";
+    if (ref.totalClk != cand.totalClk)
+        stream << "CYC " << ref.totalClk << " != " << cand.totalClk << " ";
+
+    if (refWrites.size() != candWrites.size()) {
+        stream << "writes " << refWrites.size() << " != " << candWrites.size() << " ";
+    }
+    else {
+        for (size_t i = 0; i < refWrites.size(); i++) {
+            if (refWrites[i].addr != candWrites[i].addr || refWrites[i].value != candWrites[i].value) {
+                stream << "write #" << i << " " << hexValue(refWrites[i].addr, 4) << "=" << hexValue(refWrites[i].value, 2)
+                << " != " << hexValue(candWrites[i].addr, 4) << "=" << hexValue(candWrites[i].value, 2) << " ";
+                break;
+            }
+        }
+    }
+    reason = stream.str();
+    return reason.empty();
+}
+
+bool Lockstep::diverges(const MOS6502::CPUState &state, const uint8_t (&image)[0x10000], std::string &reason) {
+    load(image, state);
+    return !step(reason);
+}
+
+// Shrink the memory image to the few bytes the diverging instruction depends on
+// by clearing ever smaller chunks as long as the divergence persists
+Lockstep::Divergence Lockstep::minimise(long instruction, const MOS6502::CPUState &state, uint8_t (&image)[0x10000]) {
+    Divergence result;
+    result.instruction = instruction;
+    result.opcode = -1;
+    result.state = state;
+    diverges(state, image, result.reason);
+
+    uint8_t saved[0x8000];
+    for (int chunk = 0x8000; chunk >= 1; chunk /= 2) {
+        for (int start = 0; start < 0x10000; start += chunk) {
+            bool nonZero = false;
+            for (int i = start; i < start + chunk && !nonZero; i++) {
+                nonZero = image[i] != 0;
+            }
+            if (!nonZero)
+                continue;
+
+            memcpy(saved, &image[start], chunk);
+            memset(&image[start], 0, chunk);
+            std::string reason;
+            if (!diverges(state, image, reason)) {
+                memcpy(&image[start], saved, chunk);
+            }
+        }
+    }
+
+    for (int i = 0; i < 0x10000; i++) {
+        if (image[i] != 0) {
+            result.bytes.push_back({(uint16_t)i, image[i]});
+        }
+    }
+    return result;
+}
+
+bool Lockstep::run(const uint8_t (&image)[0x10000], const MOS6502::CPUState &start, long instructions) {
+    load(image, start);
+    for (long i = 0; i < instructions; i++) {
+        std::string reason;
+        if (!step(reason)) {
+            instructionsRun += i + 1;
+
+            // Replay the reference up to the diverging instruction to recover its input
+            memcpy(scratch, image, sizeof(scratch));
+            reference.setState(start);
+            for (long j = 0; j < i; j++) {
+                reference.executeOP(scratch);
+            }
+            divergences.push_back(minimise(i, reference.getState(), scratch));
+            return false;
+        }
+    }
+    instructionsRun += instructions;
+
+    if (memcmp(refMemory, candMemory, sizeof(refMemory)) != 0) {
+        divergences.push_back({instructions, -1, "memory images differ", start, {}});
+        return false;
+    }
+    return true;
+}
+
+// Each iteration randomises the registers and the bytes an instruction can reach
+// cheaply (operands, zero page, stack), the rest of the image is refreshed periodically
+bool Lockstep::fuzz(int iterations, uint32_t seed) {
+    std::mt19937_64 rng(seed);
+    bool passed = true;
+
+    for (int opcode = 0; opcode < 256; opcode++) {
+        for (int i = 0; i < iterations; i++) {
+            MOS6502::CPUState state;
+            state.PC = rng();
+            state.SP = rng();
+            state.AC = rng();
+            state.X = rng();
+            state.Y = rng();
+            state.SR = rng();
+            state.totalClk = 0;
+
+            if (i % 256 == 0) {
+                uint64_t *words = (uint64_t *)scratch;
+                for (size_t w = 0; w < sizeof(scratch) / sizeof(uint64_t); w++) {
+                    words[w] = rng();
+                }
+                scratch[state.PC] = opcode;
+                load(scratch, state);
+            }
+            else {
+                uint64_t *words = (uint64_t *)scratch;
+                for (size_t w = 0; w < 0x200 / sizeof(uint64_t); w++) {
+                    words[w] = rng();
+                }
+                uint64_t operands = rng();
+                scratch[state.PC] = opcode;
+                scratch[(uint16_t)(state.PC + 1)] = operands;
+                scratch[(uint16_t)(state.PC + 2)] = operands >> 8;
+                memcpy(refMemory, scratch, 0x200);
+                memcpy(candMemory, scratch, 0x200);
+                for (int b = 0; b < 3; b++) {
+                    uint16_t addr = state.PC + b;
+                    refMemory[addr] = candMemory[addr] = scratch[addr];
+                }
+                reference.setState(state);
+                candidate.setState(state);
+            }
+
+            std::string reason;
+            instructionsRun++;
+            if (!step(reason)) {
+                divergences.push_back(minimise(i, state, scratch));
+                divergences.back().opcode = opcode;
+                passed = false;
+                break;
+            }
+            // Undo the writes so both images match the scratch copy again
+            for (MOS6502::memWrite &w : refWrites) {
+                refMemory[w.addr] = candMemory[w.addr] = scratch[w.addr];
+            }
+        }
+    }
+    return passed;
+}
+
+void Lockstep::report(std::ostream &out) {
+    out << "Lockstep: " << instructionsRun << " instructions, " << divergences.size() << " divergence(s)\n";
+    for (Divergence &d : divergences) {
+        const MOS6502::CPUState &s = d.state;
+        if (d.opcode >= 0)
+            out << "  opcode " << hexValue(d.opcode, 2) << " at iteration " << std::dec << d.instruction;
+        else
+            out << "  at instruction " << d.instruction;
+        out << ": " << d.reason << "\n"
+        << "    repro PC:" << hexValue(s.PC, 4) << " A:" << hexValue(s.AC, 2) << " X:" << hexValue(s.X, 2)
+        << " Y:" << hexValue(s.Y, 2) << " SR:" << hexValue(s.SR, 2) << " SP:" << hexValue(s.SP, 2)
+        << " CYC:" << std::dec << s.totalClk << "\n    memory:";
+        for (MOS6502::memWrite &b : d.bytes) {
+            out << " " << hexValue(b.addr, 4) << "=" << hexValue(b.value, 2);
+        }
+        out << "\n";
+    }
+}
@@ -1,12 +1,18 @@
 #include <MOS6502.h>
+#include <OpcodeInfo.h>
+#include <Profiler.h>
+#include <OpcodeStats.h>
+#include <Fusion.h>
+#include <Debugger.h>
+#include <Coverage.h>
+#include <StateHash.h>
+#include <Instrument.h>
 #include <vector>
 #include <iostream>
 #include <iomanip>
 #include <fstream>
 
 MOS6502::MOS6502() {
-    CPULogFile.open("ROMS/CPULogFile.txt", std::ofstream::out | std::ofstream::trunc);
-
     // Fill opcode lookup table
     for (int i = 0; i < 256; i++) {
         opcodeLookup.push_back(NULL);
@@ -22,32 +28,480 @@ MOS6502::MOS6502() {
     totalClk = 7;
 }
 
-void MOS6502::executeOP(uint8_t (&memory)[0xFFFF]) {
+int MOS6502::executeOP(uint8_t (&memory)[0x10000]) {
+    INSTRUMENT_ZONE(zoneCPU);
     int clk = 0;
+    int startClk = totalClk;
+    std::string regLogBuf;
 
-    logBuf = "";
-    std:: string regLogBuf = getRegisterLog();
-    std::stringstream stream;
-    stream << std::setw(4) << std::setfill('0') << std::hex << std::uppercase << (int)PC;
-    logBuf += stream.str(); 
-    logBuf += "  ";
+    if (pendingEvents) {
+        // The debugger sees the boundaries where the instruction at PC runs next
+        if ((pendingEvents & eventDebug) && !interruptDue() && debugger->boundary(PC)) {
+            return 0;
+        }
+        if (pendingEvents & eventProfile) {
+            profiler->step(PC, SP, totalClk, memory);
+        }
+        if (pendingEvents & eventStats) {
+            stats->step(PC, totalClk, memory);
+        }
+        if (pendingEvents & eventCoverage) {
+            coverage->step(PC, memory);
+        }
+        if ((pendingEvents & eventInterrupts) && serviceEvents(clk, memory)) {
+            totalClk += clk;
+            return totalClk - startClk;
+        }
+    }
+
+    uint16_t startPC = PC;
+    if (logEnabled) {
+        logBuf = "";
+        regLogBuf = getRegisterLog();
+        std::stringstream stream;
+        stream << std::setw(4) << std::setfill('0') << std::hex << std::uppercase << (int)PC;
+        logBuf += stream.str(); 
+        logBuf += "  ";
+    }
 
     int opcode = getByte(memory);
-    auto test = opcodeLookup[opcode];
+    // Single byte instructions read the next byte and throw it away
+    if (busAccurate && instructionLength(opcodeInfo[opcode].mode) == 1) {
+        dummyRead(PC, memory);
+    }
     opcodeFuncPtr op = opcodeLookup[opcode]->funcPtr;
     (this->*op)(clk, memory);
 
-    logBuf.resize((size_t)15, ' ');
-    logBuf += opcodeLookup[opcode]->funcName;
-    logBuf.resize((size_t)26, ' ');
+    // Superinstruction: the boundary after the first instruction is only
+    // skipped when nothing could have observed it
+    if (fusionAllowed) {
+        if (!ioTouched && !pendingEvents && totalClk + clk + MAXFUSEDCYCLES <= deadline
+            && !(pageFlags[PC >> 8] & pageIORead) && fusion->fused(opcode, memory[PC])) {
+            int next = getByte(memory);
+            (this->*opcodeLookup[next]->funcPtr)(clk, memory);
+            fusedCount++;
+        }
+        ioTouched = false;
+    }
+
+    // Skipped iterations would be missing from the observers' counts
+    if (idleAllowed && PC <= startPC && !(pendingEvents & eventObservers)) {
+        clk += skipIdleLoop(startPC, clk, memory);
+    }
+
+    if (logEnabled) {
+        INSTRUMENT_ZONE(zoneTrace);
+        logBuf.resize((size_t)15, ' ');
+        logBuf += opcodeLookup[opcode]->funcName;
+        logBuf.resize((size_t)26, ' ');
 
-    logBuf += regLogBuf;
-    CPULogFile.write(&logBuf[0], logBuf.size());
-    CPULogFile.flush();
+        logBuf += regLogBuf;
+        // Opened by the first logged instruction, so cores that never log
+        // (the C API's, the benchmark's) never touch the file
+        if (!CPULogFile.is_open())
+            CPULogFile.open("ROMS/CPULogFile.txt", std::ofstream::out | std::ofstream::trunc);
+        CPULogFile.write(&logBuf[0], logBuf.size());
+        CPULogFile.flush();
+    }
 
     totalClk += clk;
+    return totalClk - startClk;
+}
+
+void MOS6502::setLogging(bool enabled) {
+    logEnabled = enabled;
+    updateFusion();
+}
+
+void MOS6502::setFusion(const FusionTable *table) {
+    fusion = table;
+    updateFusion();
+}
+
+void MOS6502::updateFusion() {
+    bool observed = logEnabled || writeLog || busLog || busAccurate || debugger;
+    fusionAllowed = fusion && !observed;
+    idleAllowed = idleSkip && !observed;
+}
+
+void MOS6502::setIdleSkip(bool enabled) {
+    idleSkip = enabled;
+    idle.head = -1;
+    updateFusion();
+}
+
+uint64_t MOS6502::idleCyclesSkipped() const {
+    return idleSkipped;
+}
+
+// Called after a backward jump from the dispatch at "from" to PC. The first
+// arrival at a new head checks the loop body, the next ones compare the
+// registers with the previous iteration: equal registers, a body that can't
+// change memory or devices and no device event since the previous iteration
+// mean every further iteration is the same until the deadline
+int MOS6502::skipIdleLoop(uint16_t from, int clk, uint8_t (&memory)[0x10000]) {
+    int now = totalClk + clk;
+    uint8_t status = SR.to_ulong();
+    if (PC != idle.head || from < idle.head || from > idle.end) {
+        idle.head = PC;
+        idle.armed = idleLoopBody(PC, idle.end, memory);
+        if (!idle.armed) {
+            idle.end = from;
+        }
+    }
+    else if (idle.armed && idle.deadline == deadline && idle.AC == AC && idle.X == X && idle.Y == Y && idle.SP == SP && idle.SR == status) {
+        int iteration = now - idle.clk;
+        int iterations = deadline > now ? (deadline - now) / iteration : 0;
+        idle.clk = now + iterations * iteration;
+        idleSkipped += iterations * iteration;
+        return iterations * iteration;
+    }
+    idle.AC = AC;
+    idle.X = X;
+    idle.Y = Y;
+    idle.SP = SP;
+    idle.SR = status;
+    idle.clk = now;
+    idle.deadline = deadline;
+    return 0;
+}
+
+// Straight-line code from head to a branch or JMP back to head, without
+// writes, stack accesses or reads that could return something else next time
+bool MOS6502::idleLoopBody(uint16_t head, uint16_t &end, uint8_t (&memory)[0x10000]) {
+    uint16_t addr = head;
+    for (int i = 0; i < MAXIDLEINSTRUCTIONS; i++) {
+        if (pageFlags[addr >> 8] & pageIORead) {
+            return false;
+        }
+        uint8_t opcode = memory[addr];
+        const OpcodeInfo &info = opcodeInfo[opcode];
+        uint16_t operand = memory[(uint16_t)(addr + 1)] | (memory[(uint16_t)(addr + 2)] << 8);
+
+        if (info.mode == relative || opcode == 0x4C) {
+            uint16_t target = opcode == 0x4C ? operand : (uint16_t)(addr + 2 + (int8_t)operand);
+            end = addr;
+            return target == head;
+        }
+        switch (opcode) {
+            case 0x00: case 0x08: case 0x20: case 0x28: case 0x40: // BRK PHP JSR PLP RTI
+            case 0x48: case 0x60: case 0x68: case 0x6C:            // PHA RTS PLA JMP (ind)
+                return false;
+        }
+        if (info.cycles == 0 || info.access == writeAccess || info.access == rmwAccess) {
+            return false;
+        }
+        if (info.access == readAccess && !constantRead(opcode, operand, memory)) {
+            return false;
+        }
+        addr += instructionLength(info.mode);
+    }
+    return false;
+}
+
+// Registers may change inside the body, so indexed reads must be safe for
+// any index. RAM and ROM only change through writes, which the body has none of
+bool MOS6502::constantRead(uint8_t opcode, uint16_t operand, uint8_t (&memory)[0x10000]) {
+    uint16_t base;
+    switch (opcodeInfo[opcode].mode) {
+        case immediate:
+            return true;
+        case zeroPage:
+        case zeroPageX:
+        case zeroPageY:
+            return !(pageFlags[0] & pageIORead);
+        case absolute:
+            return !(pageFlags[operand >> 8] & pageIORead) || (io && io->idempotentRead(operand));
+        case absoluteX:
+        case absoluteY:
+            base = operand;
+            break;
+        case indirectY:
+            base = memory[operand & 0xFF] | (memory[(operand + 1) & 0xFF] << 8);
+            break;
+        default:
+            return false;
+    }
+    return !(pageFlags[base >> 8] & pageIORead) && !(pageFlags[(uint16_t)(base + 0xFF) >> 8] & pageIORead);
+}
+
+void MOS6502::setDeadline(int cycles) {
+    deadline = totalClk + cycles;
+}
+
+int MOS6502::cyclesToDeadline() const {
+    return deadline - totalClk;
+}
+
+uint64_t MOS6502::fusedInstructions() const {
+    return fusedCount;
+}
+
+void MOS6502::setWriteLog(std::vector<memWrite> *log) {
+    writeLog = log;
+    updateLogPages();
+    updateFusion();
+}
+
+void MOS6502::setBusLog(std::vector<busCycle> *log) {
+    busLog = log;
+    updateLogPages();
+    updateFusion();
+}
+
+void MOS6502::setBusAccurate(bool enabled) {
+    busAccurate = enabled;
+    updateFusion();
+}
+
+void MOS6502::addCycles(int cycles) {
+    totalClk += cycles;
+}
+
+void MOS6502::setNMI(bool level) {
+    if (level && !nmiLine) {
+        pendingEvents |= eventNMI;
+    }
+    nmiLine = level;
+}
+
+void MOS6502::setIRQ(uint8_t source, bool asserted) {
+    if (asserted) {
+        irqLines |= source;
+    }
+    else {
+        irqLines &= ~source;
+    }
+    if (irqLines) {
+        pendingEvents |= eventIRQ;
+    }
+    else {
+        pendingEvents &= ~eventIRQ;
+    }
 }
 
+void MOS6502::reset() {
+    pendingEvents |= eventReset;
+}
+
+void MOS6502::powerOn() {
+    AC = 0;
+    X = 0;
+    Y = 0;
+    SP = 0;
+    SR = 0b00100100;
+    reset();
+}
+
+void MOS6502::setProfiler(Profiler *profiler) {
+    this->profiler = profiler;
+    if (profiler) {
+        pendingEvents |= eventProfile;
+    }
+    else {
+        pendingEvents &= ~eventProfile;
+    }
+}
+
+void MOS6502::setStats(OpcodeStats *stats) {
+    this->stats = stats;
+    if (stats) {
+        pendingEvents |= eventStats;
+    }
+    else {
+        pendingEvents &= ~eventStats;
+    }
+}
+
+void MOS6502::setCoverage(Coverage *coverage) {
+    this->coverage = coverage;
+    for (int page = 0; page < 256; page++) {
+        if (coverage && coverage->covers(page << 8))
+            pageFlags[page] |= pageCover;
+        else
+            pageFlags[page] &= ~pageCover;
+    }
+    if (coverage) {
+        pendingEvents |= eventCoverage;
+    }
+    else {
+        pendingEvents &= ~eventCoverage;
+    }
+}
+
+void MOS6502::setStateHash(StateHash *hash) {
+    stateHash = hash;
+    for (int page = 0; page < 256; page++) {
+        if (hash && StateHash::tracksPage(page))
+            pageFlags[page] |= pageHash;
+        else
+            pageFlags[page] &= ~pageHash;
+    }
+}
+
+void MOS6502::setDebugger(Debugger *debugger) {
+    this->debugger = debugger;
+    if (debugger) {
+        pendingEvents |= eventDebug;
+    }
+    else {
+        pendingEvents &= ~eventDebug;
+        for (int page = 0; page < 256; page++) {
+            pageFlags[page] &= ~pageWatch;
+        }
+    }
+    updateFusion();
+}
+
+// Called with PC at the handler, once the interrupt sequence is done
+void MOS6502::observeInterrupt(int kind) {
+    idle.head = -1;
+    if (profiler) {
+        profiler->interrupt(PC, SP, (Profiler::FrameKind)kind);
+    }
+    if (stats) {
+        stats->interrupt(totalClk);
+    }
+}
+
+bool MOS6502::interruptDue() const {
+    return (pendingEvents & (eventReset | eventNMI)) || ((pendingEvents & eventIRQ) && !SR.test(interrupt));
+}
+
+// Slow path, only reached when pendingEvents is non-zero.
+// The IRQ bit stays set while a source holds the line, masked or not
+bool MOS6502::serviceEvents(int &clk, uint8_t (&memory)[0x10000]) {
+    if (pendingEvents & eventReset) {
+        pendingEvents &= ~(eventReset | eventNMI);
+        dummyRead(PC, memory);
+        dummyRead(PC, memory);
+        // The pushes happen with writes suppressed
+        for (int i = 0; i < 3; i++) {
+            dummyRead(SPToAddr(), memory);
+            SP--;
+        }
+        SR.set(interrupt);
+        uint8_t LSB = read(RESETVEC, memory);
+        uint8_t MSB = read(RESETVEC + 1, memory);
+        PC = (MSB << 8) + LSB;
+        clk += 7;
+        observeInterrupt(Profiler::frameReset);
+        return true;
+    }
+    if (pendingEvents & eventNMI) {
+        pendingEvents &= ~eventNMI;
+        dummyRead(PC, memory);
+        dummyRead(PC, memory);
+        interruptSequence(NMIVEC, PC, false, clk, memory);
+        observeInterrupt(Profiler::frameNMI);
+        return true;
+    }
+    if ((pendingEvents & eventIRQ) && !SR.test(interrupt)) {
+        dummyRead(PC, memory);
+        dummyRead(PC, memory);
+        interruptSequence(INTERRUPTVEC, PC, false, clk, memory);
+        observeInterrupt(Profiler::frameIRQ);
+        return true;
+    }
+    return false;
+}
+
+// Shared by BRK, IRQ and NMI. Only BRK pushes the status with B set
+void MOS6502::interruptSequence(uint16_t vector, uint16_t returnAddr, bool brk, int &clk, uint8_t (&memory)[0x10000]) {
+    pushToStack(returnAddr >> 8, memory);
+    pushToStack(returnAddr & 0x00FF, memory);
+    pushToStack(SR.to_ulong() | (brk ? 0b00110000 : 0b00100000), memory);
+    SR.set(interrupt);
+    uint8_t LSB = read(vector, memory);
+    uint8_t MSB = read(vector + 1, memory);
+    PC = (MSB << 8) + LSB;
+    clk += 7;
+}
+
+void MOS6502::attachIO(BusHandler *handler) {
+    io = handler;
+}
+
+void MOS6502::mapPages(int firstPage, int lastPage, uint8_t flags) {
+    for (int page = firstPage; page <= lastPage; page++) {
+        pageFlags[page] = (pageFlags[page] & (pageLog | pageWatch | pageCover | pageHash)) | flags;
+    }
+}
+
+void MOS6502::watchPage(int page, bool watched) {
+    if (watched)
+        pageFlags[page] |= pageWatch;
+    else
+        pageFlags[page] &= ~pageWatch;
+}
+
+uint8_t MOS6502::peek(uint16_t addr, uint8_t (&memory)[0x10000]) {
+    if ((pageFlags[addr >> 8] & pageIORead) && io)
+        return io->peek(addr);
+    return memory[addr];
+}
+
+// Writes straight to the array on every other page, ROM included
+void MOS6502::poke(uint16_t addr, uint8_t value, uint8_t (&memory)[0x10000]) {
+    if ((pageFlags[addr >> 8] & pageIORead) && io) {
+        io->poke(addr, value);
+        return;
+    }
+    if (pageFlags[addr >> 8] & pageHash)
+        stateHash->write(addr, memory[addr], value);
+    memory[addr] = value;
+}
+
+// While anything observes the bus every page takes the slow path
+void MOS6502::updateLogPages() {
+    bool observed = writeLog || busLog;
+    for (int page = 0; page < 256; page++) {
+        if (observed)
+            pageFlags[page] |= pageLog;
+        else
+            pageFlags[page] &= ~pageLog;
+    }
+}
+
+MOS6502::CPUState MOS6502::getState() const {
+    CPUState state;
+    state.PC = PC;
+    state.SP = SP;
+    state.AC = AC;
+    state.X = X;
+    state.Y = Y;
+    state.SR = SR.to_ulong();
+    state.totalClk = totalClk;
+    return state;
+}
+
+void MOS6502::setState(const CPUState &state) {
+    PC = state.PC;
+    SP = state.SP;
+    AC = state.AC;
+    X = state.X;
+    Y = state.Y;
+    SR = state.SR;
+    totalClk = state.totalClk;
+}
+
+MOS6502::Snapshot MOS6502::snapshot() const {
+    Snapshot snapshot;
+    snapshot.regs = getState();
+    snapshot.interrupts = pendingEvents & eventInterrupts;
+    snapshot.nmiLine = nmiLine;
+    snapshot.irqLines = irqLines;
+    return snapshot;
+}
+
+// A loop being watched for idling was seen in another timeline
+void MOS6502::restore(const Snapshot &snapshot) {
+    setState(snapshot.regs);
+    pendingEvents = (pendingEvents & ~eventInterrupts) | (snapshot.interrupts & eventInterrupts);
+    nmiLine = snapshot.nmiLine;
+    irqLines = snapshot.irqLines;
+    idle.head = -1;
+}
 
 std::string MOS6502::getRegisterLog() {
     std::stringstream stream;
@@ -67,12 +521,89 @@ void MOS6502::setReg(uint8_t &reg, uint8_t val) {
     reg = val;
 }
 
-uint8_t MOS6502::getByte(uint8_t (&memory)[0xFFFF]) {
-    std::stringstream stream;
-    stream << std::setw(2) << std::setfill('0') << std::hex << std::uppercase << (int)memory[PC];
-    logBuf += stream.str(); 
-    logBuf += " ";
-    return memory[PC++];
+uint8_t MOS6502::getByte(uint8_t (&memory)[0x10000]) {
+    if (logEnabled) {
+        std::stringstream stream;
+        stream << std::setw(2) << std::setfill('0') << std::hex << std::uppercase << (int)memory[PC];
+        logBuf += stream.str(); 
+        logBuf += " ";
+    }
+    return read(PC++, memory);
+}
+
+// All accesses go through read/write. Plain RAM/ROM pages are a direct array
+// access, pages flagged in pageFlags (I/O, observed bus, watched) take the slow path.
+// Hashed pages are plain memory with a hash update, which doesn't stop fusion
+uint8_t MOS6502::read(uint16_t addr, uint8_t (&memory)[0x10000]) {
+    if (pageFlags[addr >> 8] & (pageIORead | pageLog | pageWatch | pageCover)) {
+        return slowRead(addr, memory);
+    }
+    return memory[addr];
+}
+
+void MOS6502::write(uint16_t addr, uint8_t value, uint8_t (&memory)[0x10000]) {
+    if (pageFlags[addr >> 8] & (pageIOWrite | pageLog | pageWatch)) {
+        slowWrite(addr, value, false, memory);
+        return;
+    }
+    if (pageFlags[addr >> 8] & pageHash)
+        stateHash->write(addr, memory[addr], value);
+    memory[addr] = value;
+}
+
+uint8_t MOS6502::slowRead(uint16_t addr, uint8_t (&memory)[0x10000]) {
+    ioTouched = true;
+    uint8_t value = (pageFlags[addr >> 8] & pageIORead) ? io->ioRead(addr) : memory[addr];
+    if (busLog) {
+        busLog->push_back({addr, value, false});
+    }
+    if (pageFlags[addr >> 8] & pageWatch) {
+        debugger->access(addr, value, false);
+    }
+    if (pageFlags[addr >> 8] & pageCover) {
+        coverage->read(addr);
+    }
+    return value;
+}
+
+// Dummy writes reach devices and the bus log but are not part of the write log
+void MOS6502::slowWrite(uint16_t addr, uint8_t value, bool dummy, uint8_t (&memory)[0x10000]) {
+    ioTouched = true;
+    if (writeLog && !dummy) {
+        writeLog->push_back({addr, value});
+    }
+    if (busLog) {
+        busLog->push_back({addr, value, true});
+    }
+    if (pageFlags[addr >> 8] & pageWatch) {
+        debugger->access(addr, value, true);
+    }
+    if (pageFlags[addr >> 8] & pageIOWrite) {
+        io->ioWrite(addr, value);
+        return;
+    }
+    if (pageFlags[addr >> 8] & pageHash)
+        stateHash->write(addr, memory[addr], value);
+    memory[addr] = value;
+}
+
+void MOS6502::dummyRead(uint16_t addr, uint8_t (&memory)[0x10000]) {
+    if (busAccurate) {
+        read(addr, memory);
+    }
+}
+
+// Read-modify-write: returns the value written back.
+// The 6502 writes the unmodified value back before the result, on every
+// page: I/O sees both writes, watchpoints and the bus log the dummy one
+uint8_t MOS6502::modifyMem(uint16_t addr, void (MOS6502::*op)(uint8_t &), uint8_t (&memory)[0x10000]) {
+    uint8_t value = read(addr, memory);
+    if (busAccurate) {
+        slowWrite(addr, value, true, memory);
+    }
+    (this->*op)(value);
+    write(addr, value, memory);
+    return value;
 }
 
 uint16_t MOS6502::addPgCross(uint8_t LSB, uint8_t addValue, uint8_t MSB, int &clk, bool addClk) {
@@ -84,198 +615,212 @@ uint16_t MOS6502::addPgCross(uint8_t LSB, uint8_t addValue, uint8_t MSB, int &cl
     return (MSBAdd << 8) + LSBAdd;
 }
 
-uint8_t MOS6502::zpModeAddr(uint8_t (&memory)[0xFFFF]) {
+uint8_t MOS6502::zpModeAddr(uint8_t (&memory)[0x10000]) {
     return getByte(memory);
 }
 
-uint16_t MOS6502::zpindModeAddr(uint8_t addValue, uint8_t (&memory)[0xFFFF]) {
-    return (getByte(memory) + addValue) & 0xFF;
+uint16_t MOS6502::zpindModeAddr(uint8_t addValue, uint8_t (&memory)[0x10000]) {
+    uint8_t base = getByte(memory);
+    dummyRead(base, memory);
+    return (base + addValue) & 0xFF;
 }
 
-uint16_t MOS6502::absModeAddr(uint8_t (&memory)[0xFFFF]) {
+uint16_t MOS6502::absModeAddr(uint8_t (&memory)[0x10000]) {
     uint8_t LSB = getByte(memory);
     uint8_t MSB = getByte(memory);
     return (MSB << 8) + LSB;
 }
 
-uint16_t MOS6502::absindModeAddr(uint8_t addValue, uint8_t (&memory)[0xFFFF], int &clk, bool addClk) {
+// Indexed modes read the address before the high byte is fixed:
+// only on a page cross for reads, always for writes (addClk false)
+uint16_t MOS6502::absindModeAddr(uint8_t addValue, uint8_t (&memory)[0x10000], int &clk, bool addClk) {
     uint8_t LSB = getByte(memory);
     uint8_t MSB = getByte(memory);
-    return addPgCross(LSB, addValue, MSB, clk, addClk);
+    uint16_t addr = addPgCross(LSB, addValue, MSB, clk, addClk);
+    if (busAccurate && (!addClk || (addr >> 8) != MSB)) {
+        dummyRead((MSB << 8) | (addr & 0xFF), memory);
+    }
+    return addr;
 }
 
-uint16_t MOS6502::indxModeAddr(uint8_t (&memory)[0xFFFF]) {
-    uint16_t memAddr = getByte(memory) + X;
-    uint8_t LSB = memory[memAddr & 0xFF];
-    uint8_t MSB = memory[((memAddr + 1) & 0xFF)];
+uint16_t MOS6502::indxModeAddr(uint8_t (&memory)[0x10000]) {
+    uint8_t pointer = getByte(memory);
+    dummyRead(pointer, memory);
+    uint16_t memAddr = pointer + X;
+    uint8_t LSB = read(memAddr & 0xFF, memory);
+    uint8_t MSB = read(((memAddr + 1) & 0xFF), memory);
     return (MSB << 8) + LSB;
 }
 
-uint16_t MOS6502::indyModeAddr(uint8_t (&memory)[0xFFFF], int &clk, bool addClk) {
+uint16_t MOS6502::indyModeAddr(uint8_t (&memory)[0x10000], int &clk, bool addClk) {
     uint8_t memAddr = getByte(memory);
-    uint8_t LSB = memory[memAddr];
-    uint8_t MSB = memory[(memAddr + 1) & 0xFF];
-    return addPgCross(LSB, Y, MSB, clk, addClk);
+    uint8_t LSB = read(memAddr, memory);
+    uint8_t MSB = read((memAddr + 1) & 0xFF, memory);
+    uint16_t addr = addPgCross(LSB, Y, MSB, clk, addClk);
+    if (busAccurate && (!addClk || (addr >> 8) != MSB)) {
+        dummyRead((MSB << 8) | (addr & 0xFF), memory);
+    }
+    return addr;
 }
 
 // LDA  load accumulator 
-void MOS6502::LDA_IM(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::LDA_IM(int &clk, uint8_t (&memory)[0x10000]){
     setReg(AC, getByte(memory));
     clk += 2;
 }
-void MOS6502::LDA_ZP(int &clk, uint8_t (&memory)[0xFFFF]){
-    setReg(AC, memory[zpModeAddr(memory)]);
+void MOS6502::LDA_ZP(int &clk, uint8_t (&memory)[0x10000]){
+    setReg(AC, read(zpModeAddr(memory), memory));
     clk += 3;
 }
-void MOS6502::LDA_ZPX(int &clk, uint8_t (&memory)[0xFFFF]){
-    setReg(AC, memory[zpindModeAddr(X, memory)]);
+void MOS6502::LDA_ZPX(int &clk, uint8_t (&memory)[0x10000]){
+    setReg(AC, read(zpindModeAddr(X, memory), memory));
     clk += 4;
 }
-void MOS6502::LDA_ABS(int &clk, uint8_t (&memory)[0xFFFF]){
-    setReg(AC, memory[absModeAddr(memory)]);
+void MOS6502::LDA_ABS(int &clk, uint8_t (&memory)[0x10000]){
+    setReg(AC, read(absModeAddr(memory), memory));
     clk += 4;
 }
-void MOS6502::LDA_ABSX(int &clk, uint8_t (&memory)[0xFFFF]){
-    setReg(AC, memory[absindModeAddr(X, memory, clk, true)]);
+void MOS6502::LDA_ABSX(int &clk, uint8_t (&memory)[0x10000]){
+    setReg(AC, read(absindModeAddr(X, memory, clk, true), memory));
     clk += 4;
 }
-void MOS6502::LDA_ABSY(int &clk, uint8_t (&memory)[0xFFFF]){
-    setReg(AC, memory[absindModeAddr(Y, memory, clk, true)]);
+void MOS6502::LDA_ABSY(int &clk, uint8_t (&memory)[0x10000]){
+    setReg(AC, read(absindModeAddr(Y, memory, clk, true), memory));
     clk += 4;
 }
-void MOS6502::LDA_INDX(int &clk, uint8_t (&memory)[0xFFFF]){
-    setReg(AC, memory[indxModeAddr(memory)]);
+void MOS6502::LDA_INDX(int &clk, uint8_t (&memory)[0x10000]){
+    setReg(AC, read(indxModeAddr(memory), memory));
     clk += 6;
 }
-void MOS6502::LDA_INDY(int &clk, uint8_t (&memory)[0xFFFF]){
-    setReg(AC, memory[indyModeAddr(memory, clk, true)]);
+void MOS6502::LDA_INDY(int &clk, uint8_t (&memory)[0x10000]){
+    setReg(AC, read(indyModeAddr(memory, clk, true), memory));
     clk += 5;
 }
 
 // LDX  load X
-void MOS6502::LDX_IM(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::LDX_IM(int &clk, uint8_t (&memory)[0x10000]){
     setReg(X, getByte(memory));
     clk += 2;
 }
-void MOS6502::LDX_ZP(int &clk, uint8_t (&memory)[0xFFFF]){
-    setReg(X, memory[zpModeAddr(memory)]);
+void MOS6502::LDX_ZP(int &clk, uint8_t (&memory)[0x10000]){
+    setReg(X, read(zpModeAddr(memory), memory));
     clk += 3;
 }
-void MOS6502::LDX_ZPY(int &clk, uint8_t (&memory)[0xFFFF]){
-    setReg(X, memory[zpindModeAddr(Y, memory)]);
+void MOS6502::LDX_ZPY(int &clk, uint8_t (&memory)[0x10000]){
+    setReg(X, read(zpindModeAddr(Y, memory), memory));
     clk += 4;
 }
-void MOS6502::LDX_ABS(int &clk, uint8_t (&memory)[0xFFFF]){
-    setReg(X, memory[absModeAddr(memory)]);
+void MOS6502::LDX_ABS(int &clk, uint8_t (&memory)[0x10000]){
+    setReg(X, read(absModeAddr(memory), memory));
     clk += 4;
 }
-void MOS6502::LDX_ABSY(int &clk, uint8_t (&memory)[0xFFFF]){
-    setReg(X, memory[absindModeAddr(Y, memory, clk, true)]);
+void MOS6502::LDX_ABSY(int &clk, uint8_t (&memory)[0x10000]){
+    setReg(X, read(absindModeAddr(Y, memory, clk, true), memory));
     clk += 4;
 }
 // LDY  load Y 
-void MOS6502::LDY_IM(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::LDY_IM(int &clk, uint8_t (&memory)[0x10000]){
     setReg(Y, getByte(memory));
     clk += 2;
 }
-void MOS6502::LDY_ZP(int &clk, uint8_t (&memory)[0xFFFF]){
-    setReg(Y, memory[zpModeAddr(memory)]);
+void MOS6502::LDY_ZP(int &clk, uint8_t (&memory)[0x10000]){
+    setReg(Y, read(zpModeAddr(memory), memory));
     clk += 3;
 }
-void MOS6502::LDY_ZPX(int &clk, uint8_t (&memory)[0xFFFF]){
-    setReg(Y, memory[zpindModeAddr(X, memory)]);
+void MOS6502::LDY_ZPX(int &clk, uint8_t (&memory)[0x10000]){
+    setReg(Y, read(zpindModeAddr(X, memory), memory));
     clk += 4;
 }
-void MOS6502::LDY_ABS(int &clk, uint8_t (&memory)[0xFFFF]){
-    setReg(Y, memory[absModeAddr(memory)]);
+void MOS6502::LDY_ABS(int &clk, uint8_t (&memory)[0x10000]){
+    setReg(Y, read(absModeAddr(memory), memory));
     clk += 4;
 }
-void MOS6502::LDY_ABSX(int &clk, uint8_t (&memory)[0xFFFF]){
-    setReg(Y, memory[absindModeAddr(X, memory, clk, true)]);
+void MOS6502::LDY_ABSX(int &clk, uint8_t (&memory)[0x10000]){
+    setReg(Y, read(absindModeAddr(X, memory, clk, true), memory));
     clk += 4;
 }
 // STA  store accumulator 
-void MOS6502::STA_ZP(int &clk, uint8_t (&memory)[0xFFFF]){
-    memory[zpModeAddr(memory)] = AC;
+void MOS6502::STA_ZP(int &clk, uint8_t (&memory)[0x10000]){
+    write(zpModeAddr(memory), AC, memory);
     clk += 3;
 }
-void MOS6502::STA_ZPX(int &clk, uint8_t (&memory)[0xFFFF]){
-    memory[zpindModeAddr(X, memory)] = AC;
+void MOS6502::STA_ZPX(int &clk, uint8_t (&memory)[0x10000]){
+    write(zpindModeAddr(X, memory), AC, memory);
     clk += 4;
 }
-void MOS6502::STA_ABS(int &clk, uint8_t (&memory)[0xFFFF]){
-    memory[absModeAddr(memory)] = AC;
+void MOS6502::STA_ABS(int &clk, uint8_t (&memory)[0x10000]){
+    write(absModeAddr(memory), AC, memory);
     clk += 4;
 }
-void MOS6502::STA_ABSX(int &clk, uint8_t (&memory)[0xFFFF]){
-    memory[absindModeAddr(X, memory, clk, false)] = AC;
+void MOS6502::STA_ABSX(int &clk, uint8_t (&memory)[0x10000]){
+    write(absindModeAddr(X, memory, clk, false), AC, memory);
     clk += 5;
 }
-void MOS6502::STA_ABSY(int &clk, uint8_t (&memory)[0xFFFF]){
-    memory[absindModeAddr(Y, memory, clk, false)] = AC;
+void MOS6502::STA_ABSY(int &clk, uint8_t (&memory)[0x10000]){
+    write(absindModeAddr(Y, memory, clk, false), AC, memory);
     clk += 5;
 }
-void MOS6502::STA_INDX(int &clk, uint8_t (&memory)[0xFFFF]){
-    memory[indxModeAddr(memory)] = AC;
+void MOS6502::STA_INDX(int &clk, uint8_t (&memory)[0x10000]){
+    write(indxModeAddr(memory), AC, memory);
     clk += 6;
 }
-void MOS6502::STA_INDY(int &clk, uint8_t (&memory)[0xFFFF]){
-    memory[indyModeAddr(memory, clk, false)] = AC;
+void MOS6502::STA_INDY(int &clk, uint8_t (&memory)[0x10000]){
+    write(indyModeAddr(memory, clk, false), AC, memory);
     clk += 6;
 }
 // STX  store X 
-void MOS6502::STX_ZP(int &clk, uint8_t (&memory)[0xFFFF]){
-    memory[zpModeAddr(memory)] = X;
+void MOS6502::STX_ZP(int &clk, uint8_t (&memory)[0x10000]){
+    write(zpModeAddr(memory), X, memory);
     clk += 3;
 }
-void MOS6502::STX_ZPY(int &clk, uint8_t (&memory)[0xFFFF]){
-    memory[zpindModeAddr(Y, memory)] = X;
+void MOS6502::STX_ZPY(int &clk, uint8_t (&memory)[0x10000]){
+    write(zpindModeAddr(Y, memory), X, memory);
     clk += 4;
 }
-void MOS6502::STX_ABS(int &clk, uint8_t (&memory)[0xFFFF]){
-    memory[absModeAddr(memory)] = X;
+void MOS6502::STX_ABS(int &clk, uint8_t (&memory)[0x10000]){
+    write(absModeAddr(memory), X, memory);
     clk += 4;
 }
 // STY  store Y 
-void MOS6502::STY_ZP(int &clk, uint8_t (&memory)[0xFFFF]){
-    memory[zpModeAddr(memory)] = Y;
+void MOS6502::STY_ZP(int &clk, uint8_t (&memory)[0x10000]){
+    write(zpModeAddr(memory), Y, memory);
     clk += 3;
 }
-void MOS6502::STY_ZPX(int &clk, uint8_t (&memory)[0xFFFF]){
-    memory[zpindModeAddr(X, memory)] = Y;
+void MOS6502::STY_ZPX(int &clk, uint8_t (&memory)[0x10000]){
+    write(zpindModeAddr(X, memory), Y, memory);
     clk += 4;
 }
-void MOS6502::STY_ABS(int &clk, uint8_t (&memory)[0xFFFF]){
-    memory[absModeAddr(memory)] = Y;
+void MOS6502::STY_ABS(int &clk, uint8_t (&memory)[0x10000]){
+    write(absModeAddr(memory), Y, memory);
     clk += 4;
 }
 // TAX  transfer accumulator to X 
-void MOS6502::TAX(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::TAX(int &clk, uint8_t (&memory)[0x10000]){
     setReg(X, AC);
     clk += 2;
 }
 // TAY  transfer accumulator to Y 
-void MOS6502::TAY(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::TAY(int &clk, uint8_t (&memory)[0x10000]){
     setReg(Y, AC);
     clk += 2;
 }
 // TSX  transfer stack pointer to X 
-void MOS6502::TSX(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::TSX(int &clk, uint8_t (&memory)[0x10000]){
     setReg(X, SP);
     clk += 2;
 }
 // TXA  transfer X to accumulator 
-void MOS6502::TXA(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::TXA(int &clk, uint8_t (&memory)[0x10000]){
     setReg(AC, X);
     clk += 2;
 }
 // TXS  transfer X to stack pointer 
-void MOS6502::TXS(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::TXS(int &clk, uint8_t (&memory)[0x10000]){
     SP = X;
     clk += 2;
 }
 // TYA  transfer Y to accumulator 
-void MOS6502::TYA(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::TYA(int &clk, uint8_t (&memory)[0x10000]){
     setReg(AC, Y);
     clk += 2;
 }
@@ -285,99 +830,109 @@ uint16_t MOS6502::SPToAddr(){
     return 0x0100 | SP;
 }
 
-void MOS6502::pushToStack(uint8_t value, uint8_t (&memory)[0xFFFF]) {
-    memory[SPToAddr()] = value;
+void MOS6502::pushToStack(uint8_t value, uint8_t (&memory)[0x10000]) {
+    write(SPToAddr(), value, memory);
     SP--;
 }
 
-uint8_t MOS6502::pullFromStack(uint8_t (&memory)[0xFFFF]) {
+uint8_t MOS6502::pullFromStack(uint8_t (&memory)[0x10000]) {
     SP++;
-    uint8_t value = memory[SPToAddr()];
+    uint8_t value = read(SPToAddr(), memory);
     return value;
 }
 
 // PHA  push accumulator 
-void MOS6502::PHA(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::PHA(int &clk, uint8_t (&memory)[0x10000]){
     pushToStack(AC, memory);
     clk += 3;
 }
 // PHP  push processor status registers
-void MOS6502::PHP(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::PHP(int &clk, uint8_t (&memory)[0x10000]){
     pushToStack(SR.to_ulong() | 0b00010000, memory);
     clk += 3;
 }
 // PLA  pull accumulator 
-void MOS6502::PLA(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::PLA(int &clk, uint8_t (&memory)[0x10000]){
+    dummyRead(SPToAddr(), memory);
     setReg(AC, pullFromStack(memory));
     clk += 4;
 }
 // PLP  pull processor status register 
-void MOS6502::PLP(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::PLP(int &clk, uint8_t (&memory)[0x10000]){
+    dummyRead(SPToAddr(), memory);
     SR = (pullFromStack(memory) & 0b11101111) | 0b00100000;
     clk += 4; 
 }
 
 // Decrements and increments
 
+void MOS6502::DECMem(uint8_t &memVal) {
+    setReg(memVal, memVal - 1);
+}
+
+void MOS6502::INCMem(uint8_t &memVal) {
+    setReg(memVal, memVal + 1);
+}
+
 // DEC  decrement (memory) 
-void MOS6502::DEC_ZP(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::DEC_ZP(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = zpModeAddr(memory);
-    setReg(memory[addr], memory[addr] - 1);
+    modifyMem(addr, &MOS6502::DECMem, memory);
     clk += 5;
 }
-void MOS6502::DEC_ZPX(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::DEC_ZPX(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = zpindModeAddr(X, memory);
-    setReg(memory[addr], memory[addr] - 1);
+    modifyMem(addr, &MOS6502::DECMem, memory);
     clk += 6;
 }
-void MOS6502::DEC_ABS(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::DEC_ABS(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = absModeAddr(memory);
-    setReg(memory[addr], memory[addr] - 1);
+    modifyMem(addr, &MOS6502::DECMem, memory);
     clk += 6;
 }
-void MOS6502::DEC_ABSX(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::DEC_ABSX(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = absindModeAddr(X, memory, clk, false);
-    setReg(memory[addr], memory[addr] - 1);
+    modifyMem(addr, &MOS6502::DECMem, memory);
     clk += 7;
 }
 // DEX  decrement X 
-void MOS6502::DEX(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::DEX(int &clk, uint8_t (&memory)[0x10000]){
     setReg(X, X - 1);
     clk += 2;
 }
 // DEY  decrement Y 
-void MOS6502::DEY(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::DEY(int &clk, uint8_t (&memory)[0x10000]){
     setReg(Y, Y - 1);
     clk += 2;
 }
 // INC  increment (memory) 
-void MOS6502::INC_ZP(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::INC_ZP(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = zpModeAddr(memory);
-    setReg(memory[addr], memory[addr] + 1);
+    modifyMem(addr, &MOS6502::INCMem, memory);
     clk += 5;
 }
-void MOS6502::INC_ZPX(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::INC_ZPX(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = zpindModeAddr(X, memory);
-    setReg(memory[addr], memory[addr] + 1);
+    modifyMem(addr, &MOS6502::INCMem, memory);
     clk += 6;
 }
-void MOS6502::INC_ABS(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::INC_ABS(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = absModeAddr(memory);
-    setReg(memory[addr], memory[addr] + 1);
+    modifyMem(addr, &MOS6502::INCMem, memory);
     clk += 6;
 }
-void MOS6502::INC_ABSX(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::INC_ABSX(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = absindModeAddr(X, memory, clk, false);
-    setReg(memory[addr], memory[addr] + 1);
+    modifyMem(addr, &MOS6502::INCMem, memory);
     clk += 7;
 }
 // INX  increment X 
-void MOS6502::INX(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::INX(int &clk, uint8_t (&memory)[0x10000]){
     setReg(X, X + 1);
     clk += 2;
 }
 // INY  increment Y 
-void MOS6502::INY(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::INY(int &clk, uint8_t (&memory)[0x10000]){
     setReg(Y, Y + 1);
     clk += 2;
 }
@@ -404,183 +959,188 @@ void MOS6502::overflowTest(uint8_t value) {
 }
 
 void MOS6502::add(uint8_t value) {
-    uint16_t sum = AC + value + SR.test(carry);
-    uint8_t result = sum & 0xFFU;
-    SR.set(carry, sum >> 8);  
-    SR.set(overflow, !!((AC ^ result) & (value ^ result) & 0x80U));  
-    setReg(AC, result);
+    setALUResult(ALU<CPU_VARIANT>::adc(AC, value, SR.test(carry), SR.test(decimal)));
 }
 
 void MOS6502::sub(uint8_t value) {
-    add(value ^ 0xFFU);
+    setALUResult(ALU<CPU_VARIANT>::sbc(AC, value, SR.test(carry), SR.test(decimal)));
+}
+
+// Decimal mode N/Z don't always follow the result, so the flags come from the ALU
+void MOS6502::setALUResult(const ALUResult &result) {
+    AC = result.value;
+    SR.set(carry, result.carry);
+    SR.set(zero, result.zero);
+    SR.set(overflow, result.overflow);
+    SR.set(negative, result.negative);
 }
 
 // ADC  add with carry (prepare by CLC)                         
-void MOS6502::ADC_IM(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::ADC_IM(int &clk, uint8_t (&memory)[0x10000]){
     add(getByte(memory));
     clk += 2;
 }
-void MOS6502::ADC_ZP(int &clk, uint8_t (&memory)[0xFFFF]){
-    add(memory[zpModeAddr(memory)]);
+void MOS6502::ADC_ZP(int &clk, uint8_t (&memory)[0x10000]){
+    add(read(zpModeAddr(memory), memory));
     clk += 3;
 }
-void MOS6502::ADC_ZPX(int &clk, uint8_t (&memory)[0xFFFF]){
-    add(memory[zpindModeAddr(X, memory)]);
+void MOS6502::ADC_ZPX(int &clk, uint8_t (&memory)[0x10000]){
+    add(read(zpindModeAddr(X, memory), memory));
     clk += 4;
 }
-void MOS6502::ADC_ABS(int &clk, uint8_t (&memory)[0xFFFF]){
-    add(memory[absModeAddr(memory)]);
+void MOS6502::ADC_ABS(int &clk, uint8_t (&memory)[0x10000]){
+    add(read(absModeAddr(memory), memory));
     clk += 4;
 }
-void MOS6502::ADC_ABSX(int &clk, uint8_t (&memory)[0xFFFF]){
-    add(memory[absindModeAddr(X, memory, clk, true)]);
+void MOS6502::ADC_ABSX(int &clk, uint8_t (&memory)[0x10000]){
+    add(read(absindModeAddr(X, memory, clk, true), memory));
     clk += 4;
 }
-void MOS6502::ADC_ABSY(int &clk, uint8_t (&memory)[0xFFFF]){
-    add(memory[absindModeAddr(Y, memory, clk, true)]);
+void MOS6502::ADC_ABSY(int &clk, uint8_t (&memory)[0x10000]){
+    add(read(absindModeAddr(Y, memory, clk, true), memory));
     clk += 4;
 }
-void MOS6502::ADC_INDX(int &clk, uint8_t (&memory)[0xFFFF]){
-    add(memory[indxModeAddr(memory)]);
+void MOS6502::ADC_INDX(int &clk, uint8_t (&memory)[0x10000]){
+    add(read(indxModeAddr(memory), memory));
     clk += 6;
 }
-void MOS6502::ADC_INDY(int &clk, uint8_t (&memory)[0xFFFF]){
-    add(memory[indyModeAddr(memory, clk, true)]);
+void MOS6502::ADC_INDY(int &clk, uint8_t (&memory)[0x10000]){
+    add(read(indyModeAddr(memory, clk, true), memory));
     clk += 5;
 }
 // SBC  subtract with carry (prepare by SEC)                
-void MOS6502::SBC_IM(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::SBC_IM(int &clk, uint8_t (&memory)[0x10000]){
     sub(getByte(memory));
     clk += 2;
 }
-void MOS6502::SBC_ZP(int &clk, uint8_t (&memory)[0xFFFF]){
-    sub(memory[zpModeAddr(memory)]);
+void MOS6502::SBC_ZP(int &clk, uint8_t (&memory)[0x10000]){
+    sub(read(zpModeAddr(memory), memory));
     clk += 3;
 }
-void MOS6502::SBC_ZPX(int &clk, uint8_t (&memory)[0xFFFF]){
-    sub(memory[zpindModeAddr(X, memory)]);
+void MOS6502::SBC_ZPX(int &clk, uint8_t (&memory)[0x10000]){
+    sub(read(zpindModeAddr(X, memory), memory));
     clk += 4;
 }
-void MOS6502::SBC_ABS(int &clk, uint8_t (&memory)[0xFFFF]){
-    sub(memory[absModeAddr(memory)]);
+void MOS6502::SBC_ABS(int &clk, uint8_t (&memory)[0x10000]){
+    sub(read(absModeAddr(memory), memory));
     clk += 4;
 }
-void MOS6502::SBC_ABSX(int &clk, uint8_t (&memory)[0xFFFF]){
-    sub(memory[absindModeAddr(X, memory, clk, true)]);
+void MOS6502::SBC_ABSX(int &clk, uint8_t (&memory)[0x10000]){
+    sub(read(absindModeAddr(X, memory, clk, true), memory));
     clk += 4;
 }
-void MOS6502::SBC_ABSY(int &clk, uint8_t (&memory)[0xFFFF]){
-    sub(memory[absindModeAddr(Y, memory, clk, true)]);
+void MOS6502::SBC_ABSY(int &clk, uint8_t (&memory)[0x10000]){
+    sub(read(absindModeAddr(Y, memory, clk, true), memory));
     clk += 4;
 }
-void MOS6502::SBC_INDX(int &clk, uint8_t (&memory)[0xFFFF]){
-    sub(memory[indxModeAddr(memory)]);
+void MOS6502::SBC_INDX(int &clk, uint8_t (&memory)[0x10000]){
+    sub(read(indxModeAddr(memory), memory));
     clk += 6;
 }
-void MOS6502::SBC_INDY(int &clk, uint8_t (&memory)[0xFFFF]){
-    sub(memory[indyModeAddr(memory, clk, true)]);
+void MOS6502::SBC_INDY(int &clk, uint8_t (&memory)[0x10000]){
+    sub(read(indyModeAddr(memory, clk, true), memory));
     clk += 5;
 }
 
 // Logical operations
 
 // AND  and (with accumulator) 
-void MOS6502::AND_IM(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::AND_IM(int &clk, uint8_t (&memory)[0x10000]){
     setReg(AC, AC & getByte(memory));
     clk += 2;
 }
-void MOS6502::AND_ZP(int &clk, uint8_t (&memory)[0xFFFF]){
-    setReg(AC, AC & memory[zpModeAddr(memory)]);
+void MOS6502::AND_ZP(int &clk, uint8_t (&memory)[0x10000]){
+    setReg(AC, AC & read(zpModeAddr(memory), memory));
     clk += 3;
 }
-void MOS6502::AND_ZPX(int &clk, uint8_t (&memory)[0xFFFF]){
-    setReg(AC, AC & memory[zpindModeAddr(X, memory)]);
+void MOS6502::AND_ZPX(int &clk, uint8_t (&memory)[0x10000]){
+    setReg(AC, AC & read(zpindModeAddr(X, memory), memory));
     clk += 4;
 }
-void MOS6502::AND_ABS(int &clk, uint8_t (&memory)[0xFFFF]){
-    setReg(AC, AC & memory[absModeAddr(memory)]);
+void MOS6502::AND_ABS(int &clk, uint8_t (&memory)[0x10000]){
+    setReg(AC, AC & read(absModeAddr(memory), memory));
     clk += 4;
 }
-void MOS6502::AND_ABSX(int &clk, uint8_t (&memory)[0xFFFF]){
-    setReg(AC, AC & memory[absindModeAddr(X, memory, clk, true)]);
+void MOS6502::AND_ABSX(int &clk, uint8_t (&memory)[0x10000]){
+    setReg(AC, AC & read(absindModeAddr(X, memory, clk, true), memory));
     clk += 4;
 }
-void MOS6502::AND_ABSY(int &clk, uint8_t (&memory)[0xFFFF]){
-    setReg(AC, AC & memory[absindModeAddr(Y, memory, clk, true)]);
+void MOS6502::AND_ABSY(int &clk, uint8_t (&memory)[0x10000]){
+    setReg(AC, AC & read(absindModeAddr(Y, memory, clk, true), memory));
     clk += 4;
 }
-void MOS6502::AND_INDX(int &clk, uint8_t (&memory)[0xFFFF]){
-    setReg(AC, AC & memory[indxModeAddr(memory)]);
+void MOS6502::AND_INDX(int &clk, uint8_t (&memory)[0x10000]){
+    setReg(AC, AC & read(indxModeAddr(memory), memory));
     clk += 6;
 }
-void MOS6502::AND_INDY(int &clk, uint8_t (&memory)[0xFFFF]){
-    setReg(AC, AC & memory[indyModeAddr(memory, clk, true)]);
+void MOS6502::AND_INDY(int &clk, uint8_t (&memory)[0x10000]){
+    setReg(AC, AC & read(indyModeAddr(memory, clk, true), memory));
     clk += 5;
 }
 // EOR  exclusive or (with accumulator)
-void MOS6502::EOR_IM(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::EOR_IM(int &clk, uint8_t (&memory)[0x10000]){
     setReg(AC, AC ^ getByte(memory));
     clk += 2;
 }
-void MOS6502::EOR_ZP(int &clk, uint8_t (&memory)[0xFFFF]){
-    setReg(AC, AC ^ memory[zpModeAddr(memory)]);
+void MOS6502::EOR_ZP(int &clk, uint8_t (&memory)[0x10000]){
+    setReg(AC, AC ^ read(zpModeAddr(memory), memory));
     clk += 3;
 }
-void MOS6502::EOR_ZPX(int &clk, uint8_t (&memory)[0xFFFF]){
-    setReg(AC, AC ^ memory[zpindModeAddr(X, memory)]);
+void MOS6502::EOR_ZPX(int &clk, uint8_t (&memory)[0x10000]){
+    setReg(AC, AC ^ read(zpindModeAddr(X, memory), memory));
     clk += 4;
 }
-void MOS6502::EOR_ABS(int &clk, uint8_t (&memory)[0xFFFF]){
-    setReg(AC, AC ^ memory[absModeAddr(memory)]);
+void MOS6502::EOR_ABS(int &clk, uint8_t (&memory)[0x10000]){
+    setReg(AC, AC ^ read(absModeAddr(memory), memory));
     clk += 4;
 }
-void MOS6502::EOR_ABSX(int &clk, uint8_t (&memory)[0xFFFF]){
-    setReg(AC, AC ^ memory[absindModeAddr(X, memory, clk, true)]);
+void MOS6502::EOR_ABSX(int &clk, uint8_t (&memory)[0x10000]){
+    setReg(AC, AC ^ read(absindModeAddr(X, memory, clk, true), memory));
     clk += 4;
 }
-void MOS6502::EOR_ABSY(int &clk, uint8_t (&memory)[0xFFFF]){
-    setReg(AC, AC ^ memory[absindModeAddr(Y, memory, clk, true)]);
+void MOS6502::EOR_ABSY(int &clk, uint8_t (&memory)[0x10000]){
+    setReg(AC, AC ^ read(absindModeAddr(Y, memory, clk, true), memory));
     clk += 4;
 }
-void MOS6502::EOR_INDX(int &clk, uint8_t (&memory)[0xFFFF]){
-    setReg(AC, AC ^ memory[indxModeAddr(memory)]);
+void MOS6502::EOR_INDX(int &clk, uint8_t (&memory)[0x10000]){
+    setReg(AC, AC ^ read(indxModeAddr(memory), memory));
     clk += 6;
 }
-void MOS6502::EOR_INDY(int &clk, uint8_t (&memory)[0xFFFF]){
-    setReg(AC, AC ^ memory[indyModeAddr(memory, clk, true)]);
+void MOS6502::EOR_INDY(int &clk, uint8_t (&memory)[0x10000]){
+    setReg(AC, AC ^ read(indyModeAddr(memory, clk, true), memory));
     clk += 5;
 }
 // ORA  (inclusive) or with accumulator 
-void MOS6502::ORA_IM(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::ORA_IM(int &clk, uint8_t (&memory)[0x10000]){
     setReg(AC, AC | getByte(memory));
     clk += 2;
 }
-void MOS6502::ORA_ZP(int &clk, uint8_t (&memory)[0xFFFF]){
-    setReg(AC, AC | memory[zpModeAddr(memory)]);
+void MOS6502::ORA_ZP(int &clk, uint8_t (&memory)[0x10000]){
+    setReg(AC, AC | read(zpModeAddr(memory), memory));
     clk += 3;
 }
-void MOS6502::ORA_ZPX(int &clk, uint8_t (&memory)[0xFFFF]){
-    setReg(AC, AC | memory[zpindModeAddr(X, memory)]);
+void MOS6502::ORA_ZPX(int &clk, uint8_t (&memory)[0x10000]){
+    setReg(AC, AC | read(zpindModeAddr(X, memory), memory));
     clk += 4;
 }
-void MOS6502::ORA_ABS(int &clk, uint8_t (&memory)[0xFFFF]){
-    setReg(AC, AC | memory[absModeAddr(memory)]);
+void MOS6502::ORA_ABS(int &clk, uint8_t (&memory)[0x10000]){
+    setReg(AC, AC | read(absModeAddr(memory), memory));
     clk += 4;
 }
-void MOS6502::ORA_ABSX(int &clk, uint8_t (&memory)[0xFFFF]){
-    setReg(AC, AC | memory[absindModeAddr(X, memory, clk, true)]);
+void MOS6502::ORA_ABSX(int &clk, uint8_t (&memory)[0x10000]){
+    setReg(AC, AC | read(absindModeAddr(X, memory, clk, true), memory));
     clk += 4;
 }
-void MOS6502::ORA_ABSY(int &clk, uint8_t (&memory)[0xFFFF]){
-    setReg(AC, AC | memory[absindModeAddr(Y, memory, clk, true)]);
+void MOS6502::ORA_ABSY(int &clk, uint8_t (&memory)[0x10000]){
+    setReg(AC, AC | read(absindModeAddr(Y, memory, clk, true), memory));
     clk += 4;
 }
-void MOS6502::ORA_INDX(int &clk, uint8_t (&memory)[0xFFFF]){
-    setReg(AC, AC | memory[indxModeAddr(memory)]);
+void MOS6502::ORA_INDX(int &clk, uint8_t (&memory)[0x10000]){
+    setReg(AC, AC | read(indxModeAddr(memory), memory));
     clk += 6;
 }
-void MOS6502::ORA_INDY(int &clk, uint8_t (&memory)[0xFFFF]){
-    setReg(AC, AC | memory[indyModeAddr(memory, clk, true)]);
+void MOS6502::ORA_INDY(int &clk, uint8_t (&memory)[0x10000]){
+    setReg(AC, AC | read(indyModeAddr(memory, clk, true), memory));
     clk += 5;
 }
 
@@ -608,130 +1168,130 @@ void MOS6502::RORMem(uint8_t &memVal) {
 }
 
 // ASL  arithmetic shift left (shifts in a zero bit on the right) 
-void MOS6502::ASL_ACC(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::ASL_ACC(int &clk, uint8_t (&memory)[0x10000]){
     SR.set(carry, AC & 0x80);
     setReg(AC, AC << 1);
     clk += 2;
 }
-void MOS6502::ASL_ZP(int &clk, uint8_t (&memory)[0xFFFF]){
-    ASLMem(memory[zpModeAddr(memory)]);
+void MOS6502::ASL_ZP(int &clk, uint8_t (&memory)[0x10000]){
+    modifyMem(zpModeAddr(memory), &MOS6502::ASLMem, memory);
     clk += 5;
 }
-void MOS6502::ASL_ZPX(int &clk, uint8_t (&memory)[0xFFFF]){
-    ASLMem(memory[zpindModeAddr(X, memory)]);
+void MOS6502::ASL_ZPX(int &clk, uint8_t (&memory)[0x10000]){
+    modifyMem(zpindModeAddr(X, memory), &MOS6502::ASLMem, memory);
     clk += 6;
 }
-void MOS6502::ASL_ABS(int &clk, uint8_t (&memory)[0xFFFF]){
-    ASLMem(memory[absModeAddr(memory)]);
+void MOS6502::ASL_ABS(int &clk, uint8_t (&memory)[0x10000]){
+    modifyMem(absModeAddr(memory), &MOS6502::ASLMem, memory);
     clk += 6;
 }
-void MOS6502::ASL_ABSX(int &clk, uint8_t (&memory)[0xFFFF]){
-    ASLMem(memory[absindModeAddr(X, memory, clk, false)]);
+void MOS6502::ASL_ABSX(int &clk, uint8_t (&memory)[0x10000]){
+    modifyMem(absindModeAddr(X, memory, clk, false), &MOS6502::ASLMem, memory);
     clk += 7;
 }
 // LSR  logical shift right (shifts in a zero bit on the left) 
-void MOS6502::LSR_ACC(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::LSR_ACC(int &clk, uint8_t (&memory)[0x10000]){
     SR.set(carry, AC & 0x01);
     setReg(AC, AC >> 1);
     clk += 2;
 }
-void MOS6502::LSR_ZP(int &clk, uint8_t (&memory)[0xFFFF]){
-    LSRMem(memory[zpModeAddr(memory)]);
+void MOS6502::LSR_ZP(int &clk, uint8_t (&memory)[0x10000]){
+    modifyMem(zpModeAddr(memory), &MOS6502::LSRMem, memory);
     clk += 5;
 }
-void MOS6502::LSR_ZPX(int &clk, uint8_t (&memory)[0xFFFF]){
-    LSRMem(memory[zpindModeAddr(X, memory)]);
+void MOS6502::LSR_ZPX(int &clk, uint8_t (&memory)[0x10000]){
+    modifyMem(zpindModeAddr(X, memory), &MOS6502::LSRMem, memory);
     clk += 6;
 }
-void MOS6502::LSR_ABS(int &clk, uint8_t (&memory)[0xFFFF]){
-    LSRMem(memory[absModeAddr(memory)]);
+void MOS6502::LSR_ABS(int &clk, uint8_t (&memory)[0x10000]){
+    modifyMem(absModeAddr(memory), &MOS6502::LSRMem, memory);
     clk += 6;
 }
-void MOS6502::LSR_ABSX(int &clk, uint8_t (&memory)[0xFFFF]){
-    LSRMem(memory[absindModeAddr(X, memory, clk, false)]);
+void MOS6502::LSR_ABSX(int &clk, uint8_t (&memory)[0x10000]){
+    modifyMem(absindModeAddr(X, memory, clk, false), &MOS6502::LSRMem, memory);
     clk += 7;
 }
 // ROL  rotate left (shifts in carry bit on the right) 
-void MOS6502::ROL_ACC(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::ROL_ACC(int &clk, uint8_t (&memory)[0x10000]){
     uint8_t carryVal = AC & 0x80;
     setReg(AC, (AC << 1) | SR.test(carry));
     SR.set(carry, carryVal);
     clk += 2;
 }
-void MOS6502::ROL_ZP(int &clk, uint8_t (&memory)[0xFFFF]){
-    ROLMem(memory[zpModeAddr(memory)]);
+void MOS6502::ROL_ZP(int &clk, uint8_t (&memory)[0x10000]){
+    modifyMem(zpModeAddr(memory), &MOS6502::ROLMem, memory);
     clk += 5;
 }
-void MOS6502::ROL_ZPX(int &clk, uint8_t (&memory)[0xFFFF]){
-    ROLMem(memory[zpindModeAddr(X, memory)]);
+void MOS6502::ROL_ZPX(int &clk, uint8_t (&memory)[0x10000]){
+    modifyMem(zpindModeAddr(X, memory), &MOS6502::ROLMem, memory);
     clk += 6;
 }
-void MOS6502::ROL_ABS(int &clk, uint8_t (&memory)[0xFFFF]){
-    ROLMem(memory[absModeAddr(memory)]);
+void MOS6502::ROL_ABS(int &clk, uint8_t (&memory)[0x10000]){
+    modifyMem(absModeAddr(memory), &MOS6502::ROLMem, memory);
     clk += 6;
 }
-void MOS6502::ROL_ABSX(int &clk, uint8_t (&memory)[0xFFFF]){
-    ROLMem(memory[absindModeAddr(X, memory, clk, false)]);
+void MOS6502::ROL_ABSX(int &clk, uint8_t (&memory)[0x10000]){
+    modifyMem(absindModeAddr(X, memory, clk, false), &MOS6502::ROLMem, memory);
     clk += 7;
 }
 // ROR  rotate right (shifts in zero bit on the left) 
-void MOS6502::ROR_ACC(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::ROR_ACC(int &clk, uint8_t (&memory)[0x10000]){
     uint8_t carryVal = AC & 0x01;
     setReg(AC, (AC >> 1) | (SR.test(carry) << 7));
     SR.set(carry, carryVal);
     clk += 2;
 }
-void MOS6502::ROR_ZP(int &clk, uint8_t (&memory)[0xFFFF]){
-    RORMem(memory[zpModeAddr(memory)]);
+void MOS6502::ROR_ZP(int &clk, uint8_t (&memory)[0x10000]){
+    modifyMem(zpModeAddr(memory), &MOS6502::RORMem, memory);
     clk += 5;
 }
-void MOS6502::ROR_ZPX(int &clk, uint8_t (&memory)[0xFFFF]){
-    RORMem(memory[zpindModeAddr(X, memory)]);
+void MOS6502::ROR_ZPX(int &clk, uint8_t (&memory)[0x10000]){
+    modifyMem(zpindModeAddr(X, memory), &MOS6502::RORMem, memory);
     clk += 6;
 }
-void MOS6502::ROR_ABS(int &clk, uint8_t (&memory)[0xFFFF]){
-    RORMem(memory[absModeAddr(memory)]);
+void MOS6502::ROR_ABS(int &clk, uint8_t (&memory)[0x10000]){
+    modifyMem(absModeAddr(memory), &MOS6502::RORMem, memory);
     clk += 6;
 }
-void MOS6502::ROR_ABSX(int &clk, uint8_t (&memory)[0xFFFF]){
-    RORMem(memory[absindModeAddr(X, memory, clk, false)]);
+void MOS6502::ROR_ABSX(int &clk, uint8_t (&memory)[0x10000]){
+    modifyMem(absindModeAddr(X, memory, clk, false), &MOS6502::RORMem, memory);
     clk += 7;
 }
 
 // Flag instructions
 
 // CLC  clear carry 
-void MOS6502::CLC(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::CLC(int &clk, uint8_t (&memory)[0x10000]){
     SR.set(carry, false);
     clk += 2;
 }
 // CLD  clear decimal (BCD arithmetics disabled)
-void MOS6502::CLD(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::CLD(int &clk, uint8_t (&memory)[0x10000]){
     SR.set(decimal, false);
     clk += 2;
 }
 // CLI  clear interrupt disable 
-void MOS6502::CLI(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::CLI(int &clk, uint8_t (&memory)[0x10000]){
     SR.set(interrupt, false);
     clk += 2;
 }
 // CLV  clear overflow 
-void MOS6502::CLV(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::CLV(int &clk, uint8_t (&memory)[0x10000]){
     SR.set(overflow, false);
     clk += 2;
 }
 // SEC  set carry 
-void MOS6502::SEC(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::SEC(int &clk, uint8_t (&memory)[0x10000]){
     SR.set(carry);
     clk += 2;
 }
 // SED  set decimal (BCD arithmetics enabled) 
-void MOS6502::SED(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::SED(int &clk, uint8_t (&memory)[0x10000]){
     SR.set(decimal);
     clk += 2;
 }
 // SEI  set interrupt disable 
-void MOS6502::SEI(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::SEI(int &clk, uint8_t (&memory)[0x10000]){
     SR.set(interrupt);
     clk += 2;
 }
@@ -745,149 +1305,145 @@ void MOS6502::CMPTest(uint8_t reg, uint8_t val) {
 }
 
 // CMP  compare (with accumulator)
-void MOS6502::CMP_IM(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::CMP_IM(int &clk, uint8_t (&memory)[0x10000]){
     CMPTest(AC, getByte(memory));
     clk += 2;
 }
-void MOS6502::CMP_ZP(int &clk, uint8_t (&memory)[0xFFFF]){
-    CMPTest(AC, memory[zpModeAddr(memory)]);
+void MOS6502::CMP_ZP(int &clk, uint8_t (&memory)[0x10000]){
+    CMPTest(AC, read(zpModeAddr(memory), memory));
     clk += 3;
 }
-void MOS6502::CMP_ZPX(int &clk, uint8_t (&memory)[0xFFFF]){
-    CMPTest(AC, memory[zpindModeAddr(X, memory)]);
+void MOS6502::CMP_ZPX(int &clk, uint8_t (&memory)[0x10000]){
+    CMPTest(AC, read(zpindModeAddr(X, memory), memory));
     clk += 4;
 }
-void MOS6502::CMP_ABS(int &clk, uint8_t (&memory)[0xFFFF]){
-    CMPTest(AC, memory[absModeAddr(memory)]);
+void MOS6502::CMP_ABS(int &clk, uint8_t (&memory)[0x10000]){
+    CMPTest(AC, read(absModeAddr(memory), memory));
     clk += 4;
 }
-void MOS6502::CMP_ABSX(int &clk, uint8_t (&memory)[0xFFFF]){
-    CMPTest(AC, memory[absindModeAddr(X, memory, clk, true)]);
+void MOS6502::CMP_ABSX(int &clk, uint8_t (&memory)[0x10000]){
+    CMPTest(AC, read(absindModeAddr(X, memory, clk, true), memory));
     clk += 4;
 }
-void MOS6502::CMP_ABSY(int &clk, uint8_t (&memory)[0xFFFF]){
-    CMPTest(AC, memory[absindModeAddr(Y, memory, clk, true)]);
+void MOS6502::CMP_ABSY(int &clk, uint8_t (&memory)[0x10000]){
+    CMPTest(AC, read(absindModeAddr(Y, memory, clk, true), memory));
     clk += 4;
 }
-void MOS6502::CMP_INDX(int &clk, uint8_t (&memory)[0xFFFF]){
-    CMPTest(AC, memory[indxModeAddr(memory)]);
+void MOS6502::CMP_INDX(int &clk, uint8_t (&memory)[0x10000]){
+    CMPTest(AC, read(indxModeAddr(memory), memory));
     clk += 6;
 }
-void MOS6502::CMP_INDY(int &clk, uint8_t (&memory)[0xFFFF]){
-    CMPTest(AC, memory[indyModeAddr(memory, clk, true)]);
+void MOS6502::CMP_INDY(int &clk, uint8_t (&memory)[0x10000]){
+    CMPTest(AC, read(indyModeAddr(memory, clk, true), memory));
     clk += 5;
 }
 // CPX  compare with X 
-void MOS6502::CPX_IM(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::CPX_IM(int &clk, uint8_t (&memory)[0x10000]){
     CMPTest(X, getByte(memory));
     clk += 2;
 }
-void MOS6502::CPX_ZP(int &clk, uint8_t (&memory)[0xFFFF]){
-    CMPTest(X, memory[zpModeAddr(memory)]);
+void MOS6502::CPX_ZP(int &clk, uint8_t (&memory)[0x10000]){
+    CMPTest(X, read(zpModeAddr(memory), memory));
     clk += 3;
 }
-void MOS6502::CPX_ABS(int &clk, uint8_t (&memory)[0xFFFF]){
-    CMPTest(X, memory[absModeAddr(memory)]);
+void MOS6502::CPX_ABS(int &clk, uint8_t (&memory)[0x10000]){
+    CMPTest(X, read(absModeAddr(memory), memory));
     clk += 4;
 }
 // CPY  compare with Y 
-void MOS6502::CPY_IM(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::CPY_IM(int &clk, uint8_t (&memory)[0x10000]){
     CMPTest(Y, getByte(memory));
     clk += 2;
 }
-void MOS6502::CPY_ZP(int &clk, uint8_t (&memory)[0xFFFF]){
-    CMPTest(Y, memory[zpModeAddr(memory)]);
+void MOS6502::CPY_ZP(int &clk, uint8_t (&memory)[0x10000]){
+    CMPTest(Y, read(zpModeAddr(memory), memory));
     clk += 3;
 }
-void MOS6502::CPY_ABS(int &clk, uint8_t (&memory)[0xFFFF]){
-    CMPTest(Y, memory[absModeAddr(memory)]);
+void MOS6502::CPY_ABS(int &clk, uint8_t (&memory)[0x10000]){
+    CMPTest(Y, read(absModeAddr(memory), memory));
     clk += 4;
 }
 
 // Conditional branch instructions
 void MOS6502::checkBranchPgCross(int8_t jump, int &clk){
-    if ((PC % 256 + jump) > 255) {
+    if (((PC + jump) & 0xFF00) != (PC & 0xFF00)) {
         clk++;
     }
 }
 
+// Taken branch: one extra cycle, two when the target is on another page
+void MOS6502::takeBranch(int8_t jump, int &clk, uint8_t (&memory)[0x10000]){
+    uint16_t target = PC + jump;
+    dummyRead(PC, memory);
+    if ((target & 0xFF00) != (PC & 0xFF00)) {
+        dummyRead((PC & 0xFF00) | (target & 0x00FF), memory);
+    }
+    checkBranchPgCross(jump, clk);
+    PC = target;
+    clk++;
+}
+
 // BCC  branch on carry clear 
-void MOS6502::BCC(int &clk, uint8_t (&memory)[0xFFFF]){
-    uint8_t jump = getByte(memory);
+void MOS6502::BCC(int &clk, uint8_t (&memory)[0x10000]){
+    int8_t jump = getByte(memory);
     if (!SR.test(carry)){
-        checkBranchPgCross(jump, clk);
-        PC += jump;
-        clk++;
+        takeBranch(jump, clk, memory);
     } 
     clk += 2;
 }
 // BCS  branch on carry set 
-void MOS6502::BCS(int &clk, uint8_t (&memory)[0xFFFF]){
-    uint8_t jump = getByte(memory);
+void MOS6502::BCS(int &clk, uint8_t (&memory)[0x10000]){
+    int8_t jump = getByte(memory);
     if (SR.test(carry)){
-        checkBranchPgCross(jump, clk);
-        PC += jump;
-        clk++;
+        takeBranch(jump, clk, memory);
     } 
     clk += 2;
 }
 // BEQ  branch on equal (zero set) 
-void MOS6502::BEQ(int &clk, uint8_t (&memory)[0xFFFF]){
-    uint8_t jump = getByte(memory);
+void MOS6502::BEQ(int &clk, uint8_t (&memory)[0x10000]){
+    int8_t jump = getByte(memory);
     if (SR.test(zero)){
-        checkBranchPgCross(jump, clk);
-        PC += jump;
-        clk++;
+        takeBranch(jump, clk, memory);
     } 
     clk += 2;
 }
 // BMI  branch on minus (negative set) 
-void MOS6502::BMI(int &clk, uint8_t (&memory)[0xFFFF]){
-    uint8_t jump = getByte(memory);
+void MOS6502::BMI(int &clk, uint8_t (&memory)[0x10000]){
+    int8_t jump = getByte(memory);
     if (SR.test(negative)){
-        checkBranchPgCross(jump, clk);
-        PC += jump;
-        clk++;
+        takeBranch(jump, clk, memory);
     } 
     clk += 2;
 }
 // BNE  branch on not equal (zero clear) 
-void MOS6502::BNE(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::BNE(int &clk, uint8_t (&memory)[0x10000]){
     int8_t jump = getByte(memory);
     if (!SR.test(zero)){
-        checkBranchPgCross(jump, clk);
-        PC += jump;
-        clk++;
+        takeBranch(jump, clk, memory);
     } 
     clk += 2;
 }
 // BPL   branch on plus (negative clear) 
-void MOS6502::BPL(int &clk, uint8_t (&memory)[0xFFFF]){
-    uint8_t jump = getByte(memory);
+void MOS6502::BPL(int &clk, uint8_t (&memory)[0x10000]){
+    int8_t jump = getByte(memory);
     if (!SR.test(negative)){
-        checkBranchPgCross(jump, clk);
-        PC += jump;
-        clk++;
+        takeBranch(jump, clk, memory);
     }
     clk += 2; 
 }
 // BVC  branch on overflow clear 
-void MOS6502::BVC(int &clk, uint8_t (&memory)[0xFFFF]){
-    uint8_t jump = getByte(memory);
+void MOS6502::BVC(int &clk, uint8_t (&memory)[0x10000]){
+    int8_t jump = getByte(memory);
     if (!SR.test(overflow)){
-        checkBranchPgCross(jump, clk);
-        PC += jump;
-        clk = 1; // 3 cycles no matter the adress
+        takeBranch(jump, clk, memory);
     } 
     clk += 2;
 }
 // BVS  branch on overflow set 
-void MOS6502::BVS(int &clk, uint8_t (&memory)[0xFFFF]){
-    uint8_t jump = getByte(memory);
+void MOS6502::BVS(int &clk, uint8_t (&memory)[0x10000]){
+    int8_t jump = getByte(memory);
     if (SR.test(overflow)){
-        checkBranchPgCross(jump, clk);
-        PC += jump;
-        clk++;
+        takeBranch(jump, clk, memory);
     } 
     clk += 2;
 }
@@ -895,49 +1451,49 @@ void MOS6502::BVS(int &clk, uint8_t (&memory)[0xFFFF]){
 // Jumps and subroutines
 
 // JMP  jump 
-void MOS6502::JMP_ABS(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::JMP_ABS(int &clk, uint8_t (&memory)[0x10000]){
     PC = absModeAddr(memory);
     clk += 3;
 }
-void MOS6502::JMP_IND(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::JMP_IND(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = absModeAddr(memory);
-    if ((addr & 0x00FF) == 0xFF) {
-        PC = (memory[addr & 0xFF00] << 8) + memory[addr];
-    }
-    else 
-        PC = (memory[addr + 1] << 8) + memory[addr];
+    uint8_t LSB = read(addr, memory);
+    // The high byte does not carry into the next page
+    uint8_t MSB = read((addr & 0xFF00) | ((addr + 1) & 0x00FF), memory);
+    PC = (MSB << 8) + LSB;
     clk += 5;
 }
 // JSR  jump subroutine 
-void MOS6502::JSR_ABS(int &clk, uint8_t (&memory)[0xFFFF]){
-    uint16_t addr = absModeAddr(memory);
-    pushToStack((PC - 1) >> 8, memory);
-    pushToStack((PC - 1) & 0x00FF, memory);
-    PC = addr;
+// The high byte of the target is only read after the return address is pushed
+void MOS6502::JSR_ABS(int &clk, uint8_t (&memory)[0x10000]){
+    uint8_t LSB = getByte(memory);
+    dummyRead(SPToAddr(), memory);
+    pushToStack(PC >> 8, memory);
+    pushToStack(PC & 0x00FF, memory);
+    uint8_t MSB = getByte(memory);
+    PC = (MSB << 8) + LSB;
     clk += 6;
 }
 // RTS  return from subroutine 
-void MOS6502::RTS_IMP(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::RTS_IMP(int &clk, uint8_t (&memory)[0x10000]){
+    dummyRead(SPToAddr(), memory);
     uint8_t LSB = pullFromStack(memory);
     uint8_t MSB = pullFromStack(memory);
-    PC = ((MSB << 8) + LSB) + 1;
+    PC = (MSB << 8) + LSB;
+    dummyRead(PC, memory);
+    PC++;
     clk += 6;
 }
 
 // Interrupts
 
 // BRK  break / software interrupt 
-void MOS6502::BRK_IMP(int &clk, uint8_t (&memory)[0xFFFF]){
-    pushToStack((PC + 1) >> 8, memory);
-    pushToStack((PC + 1) & 0x00FF, memory);
-    pushToStack(SR.to_ulong(), memory);
-    PC = memory[INTERRUPTVEC] + (memory[INTERRUPTVEC + 1] << 8);
-    SR.set(brk);
-    SR.set(interrupt);
-    clk += 7;
+void MOS6502::BRK_IMP(int &clk, uint8_t (&memory)[0x10000]){
+    interruptSequence(INTERRUPTVEC, PC + 1, true, clk, memory);
 }
 // RTI  return from interrupt 
-void MOS6502::RTI_IMP(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::RTI_IMP(int &clk, uint8_t (&memory)[0x10000]){
+    dummyRead(SPToAddr(), memory);
     SR = pullFromStack(memory);
     SR.set(brk, false);
     SR.set(none);
@@ -951,390 +1507,340 @@ void MOS6502::RTI_IMP(int &clk, uint8_t (&memory)[0xFFFF]){
 // Other
 
 // BIT  bit test (accumulator & memory) 
-void MOS6502::BIT_ZP(int &clk, uint8_t (&memory)[0xFFFF]){
-    uint8_t value = memory[zpModeAddr(memory)];
+void MOS6502::BIT_ZP(int &clk, uint8_t (&memory)[0x10000]){
+    uint8_t value = read(zpModeAddr(memory), memory);
     SR.set(zero, !(AC & value));
     SR.set(negative, (value & 0b10000000) != 0);
     SR.set(overflow, (value & 0b01000000) != 0);
     clk += 3;
 }
-void MOS6502::BIT_ABS(int &clk, uint8_t (&memory)[0xFFFF]){
-    uint8_t value = memory[absModeAddr(memory)];
+void MOS6502::BIT_ABS(int &clk, uint8_t (&memory)[0x10000]){
+    uint8_t value = read(absModeAddr(memory), memory);
     SR.set(zero, !(AC & value));
     SR.set(negative, (value & 0b10000000) != 0);
     SR.set(overflow, (value & 0b01000000) != 0);
     clk += 4;
 }
 // NOP  no operation 
-void MOS6502::NOP_IMP(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::NOP_IMP(int &clk, uint8_t (&memory)[0x10000]){
     clk += 2;
 }
 
 // Illegal opcodes
-void MOS6502::ALR_IM(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::ALR_IM(int &clk, uint8_t (&memory)[0x10000]){
     uint8_t andValue = AC & getByte(memory);
     SR.set(carry, andValue & 0x01);
     setReg(AC, andValue >> 1);
     clk += 2;
 }
-void MOS6502::ANC_IM(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::ANC_IM(int &clk, uint8_t (&memory)[0x10000]){
     SR.set(carry, AC & 0x80);
     setReg(AC, AC & getByte(memory));
     clk += 2;
 }
 // unstable, not implemented
-void MOS6502::ANE_IM(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::ANE_IM(int &clk, uint8_t (&memory)[0x10000]){
     clk += 2;
 }
-void MOS6502::ARR_IM(int &clk, uint8_t (&memory)[0xFFFF]){}
-void MOS6502::DCP_ZP(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::ARR_IM(int &clk, uint8_t (&memory)[0x10000]){}
+void MOS6502::DCP_ZP(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = zpModeAddr(memory);
-    memory[addr]--;
-    CMPTest(AC, memory[addr]);
+    CMPTest(AC, modifyMem(addr, &MOS6502::DECMem, memory));
     clk += 5;
 }
-void MOS6502::DCP_ZPX(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::DCP_ZPX(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = zpindModeAddr(X, memory);
-    memory[addr]--;
-    CMPTest(AC, memory[addr]);
+    CMPTest(AC, modifyMem(addr, &MOS6502::DECMem, memory));
     clk += 6;
 }
-void MOS6502::DCP_ABS(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::DCP_ABS(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = absModeAddr(memory);
-    memory[addr]--;
-    CMPTest(AC, memory[addr]);
+    CMPTest(AC, modifyMem(addr, &MOS6502::DECMem, memory));
     clk += 6;
 }
-void MOS6502::DCP_ABSX(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::DCP_ABSX(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = absindModeAddr(X, memory, clk, false);
-    memory[addr]--;
-    CMPTest(AC, memory[addr]);
+    CMPTest(AC, modifyMem(addr, &MOS6502::DECMem, memory));
     clk += 7;
 }
-void MOS6502::DCP_ABSY(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::DCP_ABSY(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = absindModeAddr(Y, memory, clk, false);
-    memory[addr]--;
-    CMPTest(AC, memory[addr]);
+    CMPTest(AC, modifyMem(addr, &MOS6502::DECMem, memory));
     clk += 7;
 }
-void MOS6502::DCP_INDX(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::DCP_INDX(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = indxModeAddr(memory);
-    memory[addr]--;
-    CMPTest(AC, memory[addr]);
+    CMPTest(AC, modifyMem(addr, &MOS6502::DECMem, memory));
     clk += 8;
 }
-void MOS6502::DCP_INDY(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::DCP_INDY(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = indyModeAddr(memory, clk, false);
-    memory[addr]--;
-    CMPTest(AC, memory[addr]);
+    CMPTest(AC, modifyMem(addr, &MOS6502::DECMem, memory));
     clk += 8;
 }
-void MOS6502::ISC_ZP(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::ISC_ZP(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = zpModeAddr(memory);
-    memory[addr]++;
-    sub(memory[addr]);
+    sub(modifyMem(addr, &MOS6502::INCMem, memory));
     clk += 5;
 }
-void MOS6502::ISC_ZPX(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::ISC_ZPX(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = zpindModeAddr(X, memory);
-    memory[addr]++;
-    sub(memory[addr]);
+    sub(modifyMem(addr, &MOS6502::INCMem, memory));
     clk += 6;
 }
-void MOS6502::ISC_ABS(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::ISC_ABS(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = absModeAddr(memory);
-    memory[addr]++;
-    sub(memory[addr]);
+    sub(modifyMem(addr, &MOS6502::INCMem, memory));
     clk += 6;
 }
-void MOS6502::ISC_ABSX(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::ISC_ABSX(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = absindModeAddr(X, memory, clk, false);
-    memory[addr]++;
-    sub(memory[addr]);
+    sub(modifyMem(addr, &MOS6502::INCMem, memory));
     clk += 7;
 }
-void MOS6502::ISC_ABSY(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::ISC_ABSY(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = absindModeAddr(Y, memory, clk, false);
-    memory[addr]++;
-    sub(memory[addr]);
+    sub(modifyMem(addr, &MOS6502::INCMem, memory));
     clk += 7;
 }
-void MOS6502::ISC_INDX(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::ISC_INDX(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = indxModeAddr(memory);
-    memory[addr]++;
-    sub(memory[addr]);
+    sub(modifyMem(addr, &MOS6502::INCMem, memory));
     clk += 8;
 }
-void MOS6502::ISC_INDY(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::ISC_INDY(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = indyModeAddr(memory, clk, false);
-    memory[addr]++;
-    sub(memory[addr]);
+    sub(modifyMem(addr, &MOS6502::INCMem, memory));
     clk += 8;
 }
-void MOS6502::LAS_ABSY(int &clk, uint8_t (&memory)[0xFFFF]){}
-void MOS6502::LAX_ZP(int &clk, uint8_t (&memory)[0xFFFF]){
-    uint8_t value = memory[zpModeAddr(memory)];
+void MOS6502::LAS_ABSY(int &clk, uint8_t (&memory)[0x10000]){}
+void MOS6502::LAX_ZP(int &clk, uint8_t (&memory)[0x10000]){
+    uint8_t value = read(zpModeAddr(memory), memory);
     setReg(AC, value);
     setReg(X, value);
     clk += 3;
 }
-void MOS6502::LAX_ZPY(int &clk, uint8_t (&memory)[0xFFFF]){
-    uint8_t value = memory[zpindModeAddr(Y, memory)];
+void MOS6502::LAX_ZPY(int &clk, uint8_t (&memory)[0x10000]){
+    uint8_t value = read(zpindModeAddr(Y, memory), memory);
     setReg(AC, value);
     setReg(X, value);
     clk += 4;
 }
-void MOS6502::LAX_ABS(int &clk, uint8_t (&memory)[0xFFFF]){
-    uint8_t value = memory[absModeAddr(memory)];
+void MOS6502::LAX_ABS(int &clk, uint8_t (&memory)[0x10000]){
+    uint8_t value = read(absModeAddr(memory), memory);
     setReg(AC, value);
     setReg(X, value);
     clk += 4;
 }
-void MOS6502::LAX_ABSY(int &clk, uint8_t (&memory)[0xFFFF]){
-    uint8_t value = memory[absindModeAddr(Y, memory, clk, true)];
+void MOS6502::LAX_ABSY(int &clk, uint8_t (&memory)[0x10000]){
+    uint8_t value = read(absindModeAddr(Y, memory, clk, true), memory);
     setReg(AC, value);
     setReg(X, value);
     clk += 4;
 }
-void MOS6502::LAX_INDX(int &clk, uint8_t (&memory)[0xFFFF]) {
-    uint8_t value = memory[indxModeAddr(memory)];
+void MOS6502::LAX_INDX(int &clk, uint8_t (&memory)[0x10000]) {
+    uint8_t value = read(indxModeAddr(memory), memory);
     setReg(AC, value);
     setReg(X, value);
     clk += 6;
 }
-void MOS6502::LAX_INDY(int &clk, uint8_t (&memory)[0xFFFF]){
-    uint8_t value = memory[indyModeAddr(memory, clk, true)];
+void MOS6502::LAX_INDY(int &clk, uint8_t (&memory)[0x10000]){
+    uint8_t value = read(indyModeAddr(memory, clk, true), memory);
     setReg(AC, value);
     setReg(X, value);
     clk += 5;
 }
 // unstable, not implemented
-void MOS6502::LXA_IM(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::LXA_IM(int &clk, uint8_t (&memory)[0x10000]){
     clk += 2;
 }
-void MOS6502::RLA_ZP(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::RLA_ZP(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = zpModeAddr(memory);
-    ROLMem(memory[addr]);
-    setReg(AC, AC & memory[addr]);
+    setReg(AC, AC & modifyMem(addr, &MOS6502::ROLMem, memory));
     clk += 5;
 }
-void MOS6502::RLA_ZPX(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::RLA_ZPX(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = zpindModeAddr(X, memory);
-    ROLMem(memory[addr]);
-    setReg(AC, AC & memory[addr]);
+    setReg(AC, AC & modifyMem(addr, &MOS6502::ROLMem, memory));
     clk += 6;
 }
-void MOS6502::RLA_ABS(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::RLA_ABS(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = absModeAddr(memory);
-    ROLMem(memory[addr]);
-    setReg(AC, AC & memory[addr]);
+    setReg(AC, AC & modifyMem(addr, &MOS6502::ROLMem, memory));
     clk += 6;
 }
-void MOS6502::RLA_ABSX(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::RLA_ABSX(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = absindModeAddr(X, memory, clk, false);
-    ROLMem(memory[addr]);
-    setReg(AC, AC & memory[addr]);
+    setReg(AC, AC & modifyMem(addr, &MOS6502::ROLMem, memory));
     clk += 7;
 }
-void MOS6502::RLA_ABSY(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::RLA_ABSY(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = absindModeAddr(Y, memory, clk, false);
-    ROLMem(memory[addr]);
-    setReg(AC, AC & memory[addr]);
+    setReg(AC, AC & modifyMem(addr, &MOS6502::ROLMem, memory));
     clk += 7;
 }
-void MOS6502::RLA_INDX(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::RLA_INDX(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = indxModeAddr(memory);
-    ROLMem(memory[addr]);
-    setReg(AC, AC & memory[addr]);
+    setReg(AC, AC & modifyMem(addr, &MOS6502::ROLMem, memory));
     clk += 8;
 }
-void MOS6502::RLA_INDY(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::RLA_INDY(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = indyModeAddr(memory, clk, false);
-    ROLMem(memory[addr]);
-    setReg(AC, AC & memory[addr]);
+    setReg(AC, AC & modifyMem(addr, &MOS6502::ROLMem, memory));
     clk += 8;
 }
-void MOS6502::RRA_ZP(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::RRA_ZP(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = zpModeAddr(memory);
-    RORMem(memory[addr]);
-    add(memory[addr]);
+    add(modifyMem(addr, &MOS6502::RORMem, memory));
     clk += 5;
 }
-void MOS6502::RRA_ZPX(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::RRA_ZPX(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = zpindModeAddr(X, memory);
-    RORMem(memory[addr]);
-    add(memory[addr]);
+    add(modifyMem(addr, &MOS6502::RORMem, memory));
     clk += 6;
 }
-void MOS6502::RRA_ABS(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::RRA_ABS(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = absModeAddr(memory);
-    RORMem(memory[addr]);
-    add(memory[addr]);
+    add(modifyMem(addr, &MOS6502::RORMem, memory));
     clk += 6;
 }
-void MOS6502::RRA_ABSX(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::RRA_ABSX(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = absindModeAddr(X, memory, clk, false);
-    RORMem(memory[addr]);
-    add(memory[addr]);
+    add(modifyMem(addr, &MOS6502::RORMem, memory));
     clk += 7;
 }
-void MOS6502::RRA_ABSY(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::RRA_ABSY(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = absindModeAddr(Y, memory, clk, false);
-    RORMem(memory[addr]);
-    add(memory[addr]);
+    add(modifyMem(addr, &MOS6502::RORMem, memory));
     clk += 7;
 }
-void MOS6502::RRA_INDX(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::RRA_INDX(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = indxModeAddr(memory);
-    RORMem(memory[addr]);
-    add(memory[addr]);
+    add(modifyMem(addr, &MOS6502::RORMem, memory));
     clk += 8;
 }
-void MOS6502::RRA_INDY(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::RRA_INDY(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = indyModeAddr(memory, clk, false);
-    RORMem(memory[addr]);
-    add(memory[addr]);
+    add(modifyMem(addr, &MOS6502::RORMem, memory));
     clk += 8;
 }
-void MOS6502::SAX_ZP(int &clk, uint8_t (&memory)[0xFFFF]){
-    memory[zpModeAddr(memory)] = AC & X;
+void MOS6502::SAX_ZP(int &clk, uint8_t (&memory)[0x10000]){
+    write(zpModeAddr(memory), AC & X, memory);
     clk += 3;
 }
-void MOS6502::SAX_ZPY(int &clk, uint8_t (&memory)[0xFFFF]){
-    memory[zpindModeAddr(Y, memory)] = AC & X;
+void MOS6502::SAX_ZPY(int &clk, uint8_t (&memory)[0x10000]){
+    write(zpindModeAddr(Y, memory), AC & X, memory);
     clk += 4;
 }
-void MOS6502::SAX_ABS(int &clk, uint8_t (&memory)[0xFFFF]){
-    memory[absModeAddr(memory)] = AC & X;
+void MOS6502::SAX_ABS(int &clk, uint8_t (&memory)[0x10000]){
+    write(absModeAddr(memory), AC & X, memory);
     clk += 4;
 }
-void MOS6502::SAX_INDX(int &clk, uint8_t (&memory)[0xFFFF]){
-    memory[indxModeAddr(memory)] = AC & X;
+void MOS6502::SAX_INDX(int &clk, uint8_t (&memory)[0x10000]){
+    write(indxModeAddr(memory), AC & X, memory);
     clk += 6;
 }
-void MOS6502::SBX_IM(int &clk, uint8_t (&memory)[0xFFFF]){}
-void MOS6502::SHA_ABSY(int &clk, uint8_t (&memory)[0xFFFF]){}
-void MOS6502::SHA_INDY(int &clk, uint8_t (&memory)[0xFFFF]){}
-void MOS6502::SHX_ABSY(int &clk, uint8_t (&memory)[0xFFFF]){}
-void MOS6502::SHY_ABSX(int &clk, uint8_t (&memory)[0xFFFF]){}
-void MOS6502::SLO_ZP(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::SBX_IM(int &clk, uint8_t (&memory)[0x10000]){}
+void MOS6502::SHA_ABSY(int &clk, uint8_t (&memory)[0x10000]){}
+void MOS6502::SHA_INDY(int &clk, uint8_t (&memory)[0x10000]){}
+void MOS6502::SHX_ABSY(int &clk, uint8_t (&memory)[0x10000]){}
+void MOS6502::SHY_ABSX(int &clk, uint8_t (&memory)[0x10000]){}
+void MOS6502::SLO_ZP(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = zpModeAddr(memory);
-    ASLMem(memory[addr]);
-    setReg(AC, AC | memory[addr]);
+    setReg(AC, AC | modifyMem(addr, &MOS6502::ASLMem, memory));
     clk += 5;
 }
-void MOS6502::SLO_ZPX(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::SLO_ZPX(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = zpindModeAddr(X, memory);
-    ASLMem(memory[addr]);
-    setReg(AC, AC | memory[addr]);
+    setReg(AC, AC | modifyMem(addr, &MOS6502::ASLMem, memory));
     clk += 6;
 }
-void MOS6502::SLO_ABS(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::SLO_ABS(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = absModeAddr(memory);
-    ASLMem(memory[addr]);
-    setReg(AC, AC | memory[addr]);
+    setReg(AC, AC | modifyMem(addr, &MOS6502::ASLMem, memory));
     clk += 6;
 }
-void MOS6502::SLO_ABSX(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::SLO_ABSX(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = absindModeAddr(X, memory, clk, false);
-    ASLMem(memory[addr]);
-    setReg(AC, AC | memory[addr]);
+    setReg(AC, AC | modifyMem(addr, &MOS6502::ASLMem, memory));
     clk += 7;
 }
-void MOS6502::SLO_ABSY(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::SLO_ABSY(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = absindModeAddr(Y, memory, clk, false);
-    ASLMem(memory[addr]);
-    setReg(AC, AC | memory[addr]);
+    setReg(AC, AC | modifyMem(addr, &MOS6502::ASLMem, memory));
     clk += 7;
 }
-void MOS6502::SLO_INDX(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::SLO_INDX(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = indxModeAddr(memory);
-    ASLMem(memory[addr]);
-    setReg(AC, AC | memory[addr]);
+    setReg(AC, AC | modifyMem(addr, &MOS6502::ASLMem, memory));
     clk += 8;
 }
-void MOS6502::SLO_INDY(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::SLO_INDY(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = indyModeAddr(memory, clk, false);
-    ASLMem(memory[addr]);
-    setReg(AC, AC | memory[addr]);
+    setReg(AC, AC | modifyMem(addr, &MOS6502::ASLMem, memory));
     clk += 8;
 }
-void MOS6502::SRE_ZP(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::SRE_ZP(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = zpModeAddr(memory);
-    LSRMem(memory[addr]);
-    setReg(AC, AC ^ memory[addr]);
+    setReg(AC, AC ^ modifyMem(addr, &MOS6502::LSRMem, memory));
     clk += 5;
 }
-void MOS6502::SRE_ZPX(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::SRE_ZPX(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = zpindModeAddr(X, memory);
-    LSRMem(memory[addr]);
-    setReg(AC, AC ^ memory[addr]);
+    setReg(AC, AC ^ modifyMem(addr, &MOS6502::LSRMem, memory));
     clk += 6;
 }
-void MOS6502::SRE_ABS(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::SRE_ABS(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = absModeAddr(memory);
-    LSRMem(memory[addr]);
-    setReg(AC, AC ^ memory[addr]);
+    setReg(AC, AC ^ modifyMem(addr, &MOS6502::LSRMem, memory));
     clk += 6;
 }
-void MOS6502::SRE_ABSX(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::SRE_ABSX(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = absindModeAddr(X, memory, clk, false);
-    LSRMem(memory[addr]);
-    setReg(AC, AC ^ memory[addr]);
+    setReg(AC, AC ^ modifyMem(addr, &MOS6502::LSRMem, memory));
     clk += 7;
 }
-void MOS6502::SRE_ABSY(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::SRE_ABSY(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = absindModeAddr(Y, memory, clk, false);
-    LSRMem(memory[addr]);
-    setReg(AC, AC ^ memory[addr]);
+    setReg(AC, AC ^ modifyMem(addr, &MOS6502::LSRMem, memory));
     clk += 7;
 }
-void MOS6502::SRE_INDX(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::SRE_INDX(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = indxModeAddr(memory);
-    LSRMem(memory[addr]);
-    setReg(AC, AC ^ memory[addr]);
+    setReg(AC, AC ^ modifyMem(addr, &MOS6502::LSRMem, memory));
     clk += 8;
 }
-void MOS6502::SRE_INDY(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::SRE_INDY(int &clk, uint8_t (&memory)[0x10000]){
     uint16_t addr = indyModeAddr(memory, clk, false);
-    LSRMem(memory[addr]);
-    setReg(AC, AC ^ memory[addr]);
+    setReg(AC, AC ^ modifyMem(addr, &MOS6502::LSRMem, memory));
     clk += 8;
 }
-void MOS6502::TAS_ABSY(int &clk, uint8_t (&memory)[0xFFFF]){}
-void MOS6502::USBC_IM(int &clk, uint8_t (&memory)[0xFFFF]){
+void MOS6502::TAS_ABSY(int &clk, uint8_t (&memory)[0x10000]){}
+void MOS6502::USBC_IM(int &clk, uint8_t (&memory)[0x10000]){
     SBC_IM(clk, memory);
 }
-void MOS6502::NOP_0B2C(int &clk, uint8_t (&memory)[0xFFFF]){
-    clk += 2;
-}
-void MOS6502::NOP_1B2C(int &clk, uint8_t (&memory)[0xFFFF]){
-    getByte(memory);
+void MOS6502::NOP_0B2C(int &clk, uint8_t (&memory)[0x10000]){
     clk += 2;
 }
-void MOS6502::NOP_2B2C(int &clk, uint8_t (&memory)[0xFFFF]){
-    getByte(memory);
+void MOS6502::NOP_1B2C(int &clk, uint8_t (&memory)[0x10000]){
     getByte(memory);
     clk += 2;
 }
-void MOS6502::NOP_1B3C(int &clk, uint8_t (&memory)[0xFFFF]){
-    getByte(memory);
+void MOS6502::NOP_1B3C(int &clk, uint8_t (&memory)[0x10000]){
+    read(zpModeAddr(memory), memory);
     clk += 3;
 }
-void MOS6502::NOP_1B4C(int &clk, uint8_t (&memory)[0xFFFF]){
-    getByte(memory);
+void MOS6502::NOP_1B4C(int &clk, uint8_t (&memory)[0x10000]){
+    read(zpindModeAddr(X, memory), memory);
     clk += 4;
 }
-void MOS6502::NOP_2B4C(int &clk, uint8_t (&memory)[0xFFFF]){
-    getByte(memory);
-    getByte(memory);
+void MOS6502::NOP_2B4C(int &clk, uint8_t (&memory)[0x10000]){
+    read(absModeAddr(memory), memory);
     clk += 4;
 }
-void MOS6502::NOP_2B45C(int &clk, uint8_t (&memory)[0xFFFF]){
-    uint8_t LSB = getByte(memory);
-    uint8_t MSB = getByte(memory);
-    addPgCross(LSB, X, MSB, clk, true);
+void MOS6502::NOP_2B45C(int &clk, uint8_t (&memory)[0x10000]){
+    read(absindModeAddr(X, memory, clk, true), memory);
     clk += 4;
 }
 
-void MOS6502::JAM(int &clk, uint8_t (&memory)[0xFFFF]){}
\ No newline at end of file
+void MOS6502::JAM(int &clk, uint8_t (&memory)[0x10000]){}
\ No newline at end of file
@@ -0,0 +1,202 @@
+#include <Movie.h>
+#include <Controller.h>
+#include <cstdlib>
+
+static const char MAGIC[4] = {'N', 'M', 'V', 0x1A};
+static const int HEADERSIZE = 16;
+static const int MAXPORTS = 2;
+
+static void putWord(uint8_t *p, uint64_t value) {
+    for (int i = 0; i < 8; i++)
+        p[i] = value >> (i * 8);
+}
+
+static uint64_t getWord(const uint8_t *p) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++)
+        value |= (uint64_t)p[i] << (i * 8);
+    return value;
+}
+
+MovieReader::MovieReader(std::istream &in) : in(in) {
+    uint8_t header[HEADERSIZE];
+    in.read((char *)header, sizeof(header));
+    if (!in || std::char_traits<char>::compare((const char *)header, MAGIC, 4) != 0 || header[4] != MovieWriter::VERSION)
+        return;
+    portCount = header[5];
+    hashed = header[6] & MovieWriter::flagHashes;
+    rom = getWord(header + 8);
+    ok = portCount >= 1 && portCount <= MAXPORTS;
+}
+
+bool MovieReader::next(MovieFrame &frame) {
+    if (!ok)
+        return false;
+    uint8_t record[1 + MAXPORTS + 8];
+    int size = 1 + portCount + (hashed ? 8 : 0);
+    if (!in.read((char *)record, size))
+        return false;
+    frame.commands = record[0];
+    for (int port = 0; port < MAXPORTS; port++)
+        frame.buttons[port] = port < portCount ? record[1 + port] : 0;
+    frame.hashed = hashed;
+    frame.hash = hashed ? getWord(record + 1 + portCount) : 0;
+    return true;
+}
+
+bool MovieReader::valid() const {
+    return ok;
+}
+
+int MovieReader::ports() const {
+    return portCount;
+}
+
+bool MovieReader::hashes() const {
+    return hashed;
+}
+
+uint64_t MovieReader::romChecksum() const {
+    return rom;
+}
+
+MovieWriter::MovieWriter(std::ostream &out, int ports, bool hashes, uint64_t romChecksum)
+    : out(out), ports(ports < 1 ? 1 : ports > MAXPORTS ? MAXPORTS : ports), hashes(hashes) {
+    uint8_t header[HEADERSIZE] = {};
+    std::char_traits<char>::copy((char *)header, MAGIC, 4);
+    header[4] = VERSION;
+    header[5] = this->ports;
+    header[6] = hashes ? flagHashes : 0;
+    putWord(header + 8, romChecksum);
+    out.write((const char *)header, sizeof(header));
+}
+
+bool MovieWriter::write(const MovieFrame &frame) {
+    uint8_t record[1 + MAXPORTS + 8];
+    int size = 1 + ports;
+    record[0] = frame.commands;
+    for (int port = 0; port < ports; port++)
+        record[1 + port] = frame.buttons[port];
+    if (hashes) {
+        putWord(record + size, frame.hash);
+        size += 8;
+    }
+    return (bool)out.write((const char *)record, size);
+}
+
+// The header ends at the first input line, which is kept for next()
+FM2Reader::FM2Reader(std::istream &in) : in(in) {
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (!line.empty() && line[0] == '|') {
+            pending = line;
+            return;
+        }
+        size_t space = line.find(' ');
+        std::string key = line.substr(0, space);
+        int value = space == std::string::npos ? 0 : atoi(line.c_str() + space + 1);
+        if (key == "binary" || key == "fourscore")
+            ok = ok && value == 0;
+        else if (key == "port0")
+            gamepad[0] = value == 1;
+        else if (key == "port1")
+            gamepad[1] = value == 1;
+    }
+}
+
+bool FM2Reader::next(MovieFrame &frame) {
+    std::string line;
+    if (!ok)
+        return false;
+    if (!pending.empty()) {
+        line.swap(pending);
+    }
+    else {
+        do {
+            if (!std::getline(in, line))
+                return false;
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+        } while (line.empty());
+    }
+    if (line[0] != '|')
+        return false;
+
+    // Fields between the bars: commands, port 0, port 1, expansion port
+    size_t start = 1;
+    size_t bar = line.find('|', start);
+    if (bar == std::string::npos)
+        return false;
+    frame = MovieFrame();
+    frame.commands = atoi(line.substr(start, bar - start).c_str());
+    for (int port = 0; port < MAXPORTS; port++) {
+        start = bar + 1;
+        bar = line.find('|', start);
+        if (bar == std::string::npos)
+            return false;
+        if (!gamepad[port])
+            continue;
+        if (bar - start != 8)
+            return false;
+        for (int i = 0; i < 8; i++) {
+            char c = line[start + i];
+            if (c != '.' && c != ' ')
+                frame.buttons[port] |= 0x80 >> i;
+        }
+    }
+    return true;
+}
+
+bool FM2Reader::valid() const {
+    return ok;
+}
+
+MoviePlayer::MoviePlayer(Controller &controller, MovieSource &movie, MovieWriter *recorder)
+    : controller(controller), movie(movie), recorder(recorder) {}
+
+// Commands and buttons apply from the start of the frame; there's only one
+// console, so a power cycle is played as a reset
+bool MoviePlayer::step() {
+    MovieFrame frame;
+    if (mismatch || !movie.next(frame))
+        return false;
+    if (frame.commands & (MovieFrame::commandReset | MovieFrame::commandPower))
+        controller.reset();
+    for (int port = 0; port < MAXPORTS; port++)
+        controller.setButtons(port, frame.buttons[port]);
+    controller.runFrame();
+    played++;
+
+    if (frame.hashed || recorder) {
+        actualHash = controller.checksum();
+        if (frame.hashed && frame.hash != actualHash) {
+            expectedHash = frame.hash;
+            mismatch = true;
+            return false;
+        }
+    }
+    if (recorder) {
+        frame.hashed = true;
+        frame.hash = actualHash;
+        recorder->write(frame);
+    }
+    return true;
+}
+
+uint64_t MoviePlayer::frames() const {
+    return played;
+}
+
+bool MoviePlayer::desynced() const {
+    return mismatch;
+}
+
+uint64_t MoviePlayer::expected() const {
+    return expectedHash;
+}
+
+uint64_t MoviePlayer::actual() const {
+    return actualHash;
+}
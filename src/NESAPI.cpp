@@ -0,0 +1,202 @@
+#include <NESAPI.h>
+#include <Controller.h>
+#include <Observation.h>
+#include <ThreadPool.h>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <new>
+
+struct nes
+{
+    explicit nes(std::ifstream &ROM) : controller(ROM) {}
+
+    Controller controller;
+    nes_render render = NES_RENDER_OFF;
+    std::unique_ptr<Observation> observation;
+    // Caller buffers needn't be aligned for the struct
+    Controller::SaveState state;
+};
+
+static std::unique_ptr<ThreadPool> pool;
+static std::once_flag poolCreated;
+
+static ThreadPool &threadPool() {
+    std::call_once(poolCreated, [] {
+        if (!pool)
+            nes_set_threads(0);
+    });
+    return *pool;
+}
+
+nes_t *nes_create(const char *rom_path) {
+    std::ifstream ROM(rom_path, std::ios::binary);
+    if (!ROM)
+        return nullptr;
+    nes_t *nes = new (std::nothrow) nes_t(ROM);
+    if (!nes)
+        return nullptr;
+    if (!nes->controller.romInfo().iNES) {
+        delete nes;
+        return nullptr;
+    }
+    nes->controller.setLogging(false);
+    nes_set_render(nes, NES_RENDER_LAST);
+    return nes;
+}
+
+void nes_destroy(nes_t *nes) {
+    delete nes;
+}
+
+void nes_reset(nes_t *nes) {
+    nes->controller.reset();
+    if (nes->observation)
+        nes->observation->clear();
+}
+
+// Serial pipelines: the pool already keeps every core busy
+void nes_set_render(nes_t *nes, nes_render mode) {
+    Controller &controller = nes->controller;
+    controller.setRenderSkip(mode == NES_RENDER_ALL ? 1 : 0);
+    if ((mode == NES_RENDER_OFF) != (nes->render == NES_RENDER_OFF))
+        controller.setRendering(mode == NES_RENDER_OFF ? Controller::renderOff : Controller::renderSerial);
+    nes->render = mode;
+}
+
+void nes_step(nes_t *nes, const uint8_t *actions, int frames) {
+    Controller &controller = nes->controller;
+    controller.setButtons(0, actions ? actions[0] : 0);
+    controller.setButtons(1, actions ? actions[1] : 0);
+    Observation *observation = nes->render != NES_RENDER_OFF ? nes->observation.get() : nullptr;
+    // The frames an observation is made of
+    int observed = observation && observation->config().maxPool ? 2 : 1;
+    for (int i = 0; i < frames; i++) {
+        bool last = i >= frames - observed;
+        if (last && nes->render == NES_RENDER_LAST)
+            controller.requestFrame();
+        controller.runFrame();
+        if (last && observation)
+            observation->frame(controller.framePixels());
+    }
+    if (observation && frames > 0)
+        observation->push();
+}
+
+void nes_step_many(nes_t *const *instances, int count, const uint8_t *actions, int frames, uint8_t *observations) {
+    threadPool().run(count, [&](int i) {
+        nes_step(instances[i], actions ? actions + 2 * i : nullptr, frames);
+        if (!observations)
+            return;
+        size_t size = nes_observation_size(instances[i]);
+        if (nes_get_observation(instances[i], observations + i * size) != 0)
+            memset(observations + i * size, 0, size);
+    });
+}
+
+void nes_set_threads(int threads) {
+    if (threads <= 0)
+        threads = std::thread::hardware_concurrency();
+    pool.reset();
+    pool.reset(new ThreadPool(threads > 1 ? threads - 1 : 0));
+}
+
+const uint8_t *nes_get_ram(nes_t *nes) {
+    return nes->controller.ram();
+}
+
+const uint8_t *nes_get_frame(nes_t *nes) {
+    return nes->controller.framePixels();
+}
+
+int nes_copy_ram(nes_t *nes, uint8_t *buffer) {
+    memcpy(buffer, nes->controller.ram(), NES_RAM_SIZE);
+    return 0;
+}
+
+int nes_set_observation(nes_t *nes, const nes_observation *config) {
+    if (!config) {
+        nes->observation.reset();
+        return 0;
+    }
+    Observation::Config settings;
+    settings.cropTop = config->crop_top;
+    settings.cropBottom = config->crop_bottom;
+    settings.cropLeft = config->crop_left;
+    settings.cropRight = config->crop_right;
+    settings.width = config->width;
+    settings.height = config->height;
+    settings.maxPool = config->max_pool != 0;
+    settings.stack = config->stack;
+    if (!Observation::valid(settings))
+        return -1;
+    nes->observation.reset(new Observation(settings));
+    if (nes->render == NES_RENDER_OFF)
+        nes_set_render(nes, NES_RENDER_LAST);
+    return 0;
+}
+
+size_t nes_observation_size(nes_t *nes) {
+    return nes->observation ? nes->observation->size() : NES_FRAME_SIZE;
+}
+
+int nes_get_observation(nes_t *nes, uint8_t *buffer) {
+    if (nes->render == NES_RENDER_OFF)
+        return -1;
+    if (!nes->observation)
+        return nes_copy_frame(nes, buffer);
+    nes->observation->write(buffer);
+    return 0;
+}
+
+int nes_copy_frame(nes_t *nes, uint8_t *buffer) {
+    const uint8_t *pixels = nes->controller.framePixels();
+    if (!pixels)
+        return -1;
+    memcpy(buffer, pixels, NES_FRAME_SIZE);
+    return 0;
+}
+
+uint64_t nes_frame_count(nes_t *nes) {
+    return nes->controller.frame();
+}
+
+uint64_t nes_checksum(nes_t *nes) {
+    return nes->controller.checksum();
+}
+
+void nes_set_state_hashing(nes_t *nes, int enabled) {
+    nes->controller.setStateHashing(enabled != 0);
+}
+
+uint64_t nes_state_hash(nes_t *nes) {
+    return nes->controller.stateHash();
+}
+
+void nes_mask_state_hash(nes_t *nes, uint16_t first, uint16_t last) {
+    nes->controller.maskStateHash(first, last);
+}
+
+size_t nes_state_size(void) {
+    return sizeof(Controller::SaveState);
+}
+
+int nes_save_state(nes_t *nes, void *buffer, size_t size) {
+    if (size < sizeof(Controller::SaveState))
+        return -1;
+    nes->controller.saveState(nes->state);
+    memcpy(buffer, &nes->state, sizeof(Controller::SaveState));
+    return 0;
+}
+
+int nes_load_state(nes_t *nes, const void *buffer, size_t size) {
+    if (size < sizeof(Controller::SaveState))
+        return -1;
+    memcpy(&nes->state, buffer, sizeof(Controller::SaveState));
+    if (!nes->controller.loadState(nes->state))
+        return -1;
+    if (nes->observation)
+        nes->observation->clear();
+    return 0;
+}
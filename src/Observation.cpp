@@ -0,0 +1,166 @@
+#include <Observation.h>
+#include <PPURenderer.h>
+#include <algorithm>
+#include <cstring>
+
+// 2C02 palette, 0xRRGGBB
+static const uint32_t PALETTE[64] = {
+    0x666666, 0x002A88, 0x1412A7, 0x3B00A4, 0x5C007E, 0x6E0040, 0x6C0600, 0x561D00,
+    0x333500, 0x0B4800, 0x005200, 0x004F08, 0x00404D, 0x000000, 0x000000, 0x000000,
+    0xADADAD, 0x155FD9, 0x4240FF, 0x7527FE, 0xA01ACC, 0xB71E7B, 0xB53120, 0x994E00,
+    0x6B6D00, 0x388700, 0x0C9300, 0x008F32, 0x007C8D, 0x000000, 0x000000, 0x000000,
+    0xFFFEFF, 0x64B0FF, 0x9290FF, 0xC676FF, 0xF36AFF, 0xFE6ECC, 0xFE8170, 0xEA9E22,
+    0xBCBE00, 0x88D800, 0x5CE430, 0x45E082, 0x48CDDE, 0x4F4F4F, 0x000000, 0x000000,
+    0xFFFEFF, 0xC0DFFF, 0xD3D2FF, 0xE8C8FF, 0xFBC2FF, 0xFEC4EA, 0xFECCC5, 0xF7D8A5,
+    0xE4E594, 0xCFEF96, 0xBDF4AB, 0xB3F3CC, 0xB5EBF2, 0xB8B8B8, 0x000000, 0x000000
+};
+
+// Rec. 601 luma; indices are 6 bits but the table covers a whole byte
+const uint8_t *Observation::grayPalette() {
+    static const struct Table
+    {
+        uint8_t gray[256];
+        Table()
+        {
+            for (int i = 0; i < 256; i++) {
+                uint32_t rgb = PALETTE[i & 0x3F];
+                int r = (rgb >> 16) & 0xFF, g = (rgb >> 8) & 0xFF, b = rgb & 0xFF;
+                gray[i] = (uint8_t)((299 * r + 587 * g + 114 * b + 500) / 1000);
+            }
+        }
+    } table;
+    return table.gray;
+}
+
+bool Observation::valid(const Config &config) {
+    return config.cropTop >= 0 && config.cropBottom >= 0 && config.cropLeft >= 0 && config.cropRight >= 0
+           && config.cropTop + config.cropBottom < PPURenderer::HEIGHT
+           && config.cropLeft + config.cropRight < PPURenderer::WIDTH && config.width >= 0 && config.height >= 0
+           && config.width <= PPURenderer::WIDTH && config.height <= PPURenderer::HEIGHT && config.stack >= 1;
+}
+
+Observation::Observation(const Config &config) : settings(config) {
+    cropWidth = PPURenderer::WIDTH - config.cropLeft - config.cropRight;
+    cropHeight = PPURenderer::HEIGHT - config.cropTop - config.cropBottom;
+    outWidth = config.width ? config.width : cropWidth;
+    outHeight = config.height ? config.height : cropHeight;
+    gray[0].resize(cropWidth * cropHeight);
+    gray[1].resize(cropWidth * cropHeight);
+    pooled.resize(cropWidth * cropHeight);
+    rowSums.resize(cropWidth);
+    ring.resize(size());
+    areaTaps(cropWidth, outWidth, columnTaps, columnFirst);
+    areaTaps(cropHeight, outHeight, rowTaps, rowFirst);
+}
+
+const Observation::Config &Observation::config() const {
+    return settings;
+}
+
+int Observation::width() const {
+    return outWidth;
+}
+
+int Observation::height() const {
+    return outHeight;
+}
+
+size_t Observation::size() const {
+    return (size_t)settings.stack * outWidth * outHeight;
+}
+
+// Output pixel o covers source [o * S / D, (o + 1) * S / D). Weights are
+// rounded from the running sum, so each output's add up to WEIGHTONE
+void Observation::areaTaps(int sourceSize, int outSize, std::vector<Tap> &taps, std::vector<int> &first) {
+    taps.clear();
+    first.clear();
+    for (int o = 0; o < outSize; o++) {
+        first.push_back(taps.size());
+        // In units of 1 / outSize source pixels
+        long low = (long)o * sourceSize;
+        long high = low + sourceSize;
+        long covered = 0;
+        int given = 0;
+        for (int s = (int)(low / outSize); s < sourceSize && (long)s * outSize < high; s++) {
+            long overlap = std::min(high, (long)(s + 1) * outSize) - std::max(low, (long)s * outSize);
+            covered += overlap;
+            int weight = (int)((covered * WEIGHTONE + sourceSize / 2) / sourceSize) - given;
+            given += weight;
+            if (weight > 0)
+                taps.push_back({(uint16_t)s, (uint16_t)weight});
+        }
+    }
+    first.push_back(taps.size());
+}
+
+void Observation::frame(const uint8_t *pixels) {
+    const uint8_t *table = grayPalette();
+    latest ^= 1;
+    uint8_t *out = gray[latest].data();
+    for (int y = 0; y < cropHeight; y++) {
+        const uint8_t *row = pixels + (y + settings.cropTop) * PPURenderer::WIDTH + settings.cropLeft;
+        for (int x = 0; x < cropWidth; x++)
+            out[x] = table[row[x]];
+        out += cropWidth;
+    }
+}
+
+void Observation::push() {
+    const uint8_t *source = gray[latest].data();
+    if (settings.maxPool) {
+        const uint8_t *previous = gray[latest ^ 1].data();
+        uint8_t *out = pooled.data();
+        size_t count = pooled.size();
+        for (size_t i = 0; i < count; i++)
+            out[i] = std::max(source[i], previous[i]);
+        source = out;
+    }
+    uint8_t *slot = ring.data() + (size_t)head * outWidth * outHeight;
+    if (outWidth == cropWidth && outHeight == cropHeight)
+        memcpy(slot, source, (size_t)outWidth * outHeight);
+    else
+        resize(source, slot);
+    head = (head + 1) % settings.stack;
+}
+
+// Rows first: each output row is a weighted sum of whole source rows, the
+// wide part that vectorises, then the columns of that one row. Tables are
+// read through locals, stores to out could alias the vectors otherwise
+void Observation::resize(const uint8_t *source, uint8_t *out) {
+    uint16_t *sums = rowSums.data();
+    const Tap *rows = rowTaps.data();
+    const int *rowStart = rowFirst.data();
+    const Tap *columns = columnTaps.data();
+    const int *columnStart = columnFirst.data();
+    int width = cropWidth;
+    for (int oy = 0; oy < outHeight; oy++) {
+        std::fill(sums, sums + width, 0);
+        for (int t = rowStart[oy]; t < rowStart[oy + 1]; t++) {
+            const uint8_t *row = source + rows[t].source * width;
+            uint16_t weight = rows[t].weight;
+            for (int x = 0; x < width; x++)
+                sums[x] += weight * row[x];
+        }
+        int t = 0;
+        for (int ox = 0; ox < outWidth; ox++) {
+            uint32_t sum = 0;
+            for (int end = columnStart[ox + 1]; t < end; t++)
+                sum += columns[t].weight * sums[columns[t].source];
+            out[ox] = (sum + (1 << (2 * WEIGHTBITS - 1))) >> (2 * WEIGHTBITS);
+        }
+        out += outWidth;
+    }
+}
+
+void Observation::write(uint8_t *out) const {
+    size_t image = (size_t)outWidth * outHeight;
+    size_t newer = (size_t)head * image;
+    memcpy(out, ring.data() + newer, ring.size() - newer);
+    memcpy(out + ring.size() - newer, ring.data(), newer);
+}
+
+void Observation::clear() {
+    std::fill(ring.begin(), ring.end(), 0);
+    std::fill(gray[0].begin(), gray[0].end(), 0);
+    std::fill(gray[1].begin(), gray[1].end(), 0);
+}
@@ -0,0 +1,283 @@
+#include <OpcodeInfo.h>
+
+const OpcodeInfo opcodeInfo[256] = {
+    {"BRK", implied, noAccess, 7, false}, // 00 BRK_IMP
+    {"ORA", indirectX, readAccess, 6, false}, // 01 ORA_INDX
+    {"JAM", implied, noAccess, 0, true}, // 02 JAM
+    {"SLO", indirectX, rmwAccess, 8, true}, // 03 SLO_INDX
+    {"NOP", zeroPage, readAccess, 3, true}, // 04 NOP_1B3C
+    {"ORA", zeroPage, readAccess, 3, false}, // 05 ORA_ZP
+    {"ASL", zeroPage, rmwAccess, 5, false}, // 06 ASL_ZP
+    {"SLO", zeroPage, rmwAccess, 5, true}, // 07 SLO_ZP
+    {"PHP", implied, noAccess, 3, false}, // 08 PHP
+    {"ORA", immediate, noAccess, 2, false}, // 09 ORA_IM
+    {"ASL", accumulator, noAccess, 2, false}, // 0A ASL_ACC
+    {"ANC", immediate, noAccess, 2, true}, // 0B ANC_IM
+    {"NOP", absolute, readAccess, 4, true}, // 0C NOP_2B4C
+    {"ORA", absolute, readAccess, 4, false}, // 0D ORA_ABS
+    {"ASL", absolute, rmwAccess, 6, false}, // 0E ASL_ABS
+    {"SLO", absolute, rmwAccess, 6, true}, // 0F SLO_ABS
+    {"BPL", relative, noAccess, 2, false}, // 10 BPL
+    {"ORA", indirectY, readAccess, 5, false}, // 11 ORA_INDY
+    {"JAM", implied, noAccess, 0, true}, // 12 JAM
+    {"SLO", indirectY, rmwAccess, 8, true}, // 13 SLO_INDY
+    {"NOP", zeroPageX, readAccess, 4, true}, // 14 NOP_1B4C
+    {"ORA", zeroPageX, readAccess, 4, false}, // 15 ORA_ZPX
+    {"ASL", zeroPageX, rmwAccess, 6, false}, // 16 ASL_ZPX
+    {"SLO", zeroPageX, rmwAccess, 6, true}, // 17 SLO_ZPX
+    {"CLC", implied, noAccess, 2, false}, // 18 CLC
+    {"ORA", absoluteY, readAccess, 4, false}, // 19 ORA_ABSY
+    {"NOP", implied, noAccess, 2, true}, // 1A NOP_0B2C
+    {"SLO", absoluteY, rmwAccess, 7, true}, // 1B SLO_ABSY
+    {"NOP", absoluteX, readAccess, 4, true}, // 1C NOP_2B45C
+    {"ORA", absoluteX, readAccess, 4, false}, // 1D ORA_ABSX
+    {"ASL", absoluteX, rmwAccess, 7, false}, // 1E ASL_ABSX
+    {"SLO", absoluteX, rmwAccess, 7, true}, // 1F SLO_ABSX
+    {"JSR", absolute, noAccess, 6, false}, // 20 JSR_ABS
+    {"AND", indirectX, readAccess, 6, false}, // 21 AND_INDX
+    {"JAM", implied, noAccess, 0, true}, // 22 JAM
+    {"RLA", indirectX, rmwAccess, 8, true}, // 23 RLA_INDX
+    {"BIT", zeroPage, readAccess, 3, false}, // 24 BIT_ZP
+    {"AND", zeroPage, readAccess, 3, false}, // 25 AND_ZP
+    {"ROL", zeroPage, rmwAccess, 5, false}, // 26 ROL_ZP
+    {"RLA", zeroPage, rmwAccess, 5, true}, // 27 RLA_ZP
+    {"PLP", implied, noAccess, 4, false}, // 28 PLP
+    {"AND", immediate, noAccess, 2, false}, // 29 AND_IM
+    {"ROL", accumulator, noAccess, 2, false}, // 2A ROL_ACC
+    {"ANC", immediate, noAccess, 2, true}, // 2B ANC_IM
+    {"BIT", absolute, readAccess, 4, false}, // 2C BIT_ABS
+    {"AND", absolute, readAccess, 4, false}, // 2D AND_ABS
+    {"ROL", absolute, rmwAccess, 6, false}, // 2E ROL_ABS
+    {"RLA", absolute, rmwAccess, 6, true}, // 2F RLA_ABS
+    {"BMI", relative, noAccess, 2, false}, // 30 BMI
+    {"AND", indirectY, readAccess, 5, false}, // 31 AND_INDY
+    {"JAM", implied, noAccess, 0, true}, // 32 JAM
+    {"RLA", indirectY, rmwAccess, 8, true}, // 33 RLA_INDY
+    {"NOP", zeroPageX, readAccess, 4, true}, // 34 NOP_1B4C
+    {"AND", zeroPageX, readAccess, 4, false}, // 35 AND_ZPX
+    {"ROL", zeroPageX, rmwAccess, 6, false}, // 36 ROL_ZPX
+    {"RLA", zeroPageX, rmwAccess, 6, true}, // 37 RLA_ZPX
+    {"SEC", implied, noAccess, 2, false}, // 38 SEC
+    {"AND", absoluteY, readAccess, 4, false}, // 39 AND_ABSY
+    {"NOP", implied, noAccess, 2, true}, // 3A NOP_0B2C
+    {"RLA", absoluteY, rmwAccess, 7, true}, // 3B RLA_ABSY
+    {"NOP", absoluteX, readAccess, 4, true}, // 3C NOP_2B45C
+    {"AND", absoluteX, readAccess, 4, false}, // 3D AND_ABSX
+    {"ROL", absoluteX, rmwAccess, 7, false}, // 3E ROL_ABSX
+    {"RLA", absoluteX, rmwAccess, 7, true}, // 3F RLA_ABSX
+    {"RTI", implied, noAccess, 6, false}, // 40 RTI_IMP
+    {"EOR", indirectX, readAccess, 6, false}, // 41 EOR_INDX
+    {"JAM", implied, noAccess, 0, true}, // 42 JAM
+    {"SRE", indirectX, rmwAccess, 8, true}, // 43 SRE_INDX
+    {"NOP", zeroPage, readAccess, 3, true}, // 44 NOP_1B3C
+    {"EOR", zeroPage, readAccess, 3, false}, // 45 EOR_ZP
+    {"LSR", zeroPage, rmwAccess, 5, false}, // 46 LSR_ZP
+    {"SRE", zeroPage, rmwAccess, 5, true}, // 47 SRE_ZP
+    {"PHA", implied, noAccess, 3, false}, // 48 PHA
+    {"EOR", immediate, noAccess, 2, false}, // 49 EOR_IM
+    {"LSR", accumulator, noAccess, 2, false}, // 4A LSR_ACC
+    {"ALR", immediate, noAccess, 2, true}, // 4B ALR_IM
+    {"JMP", absolute, noAccess, 3, false}, // 4C JMP_ABS
+    {"EOR", absolute, readAccess, 4, false}, // 4D EOR_ABS
+    {"LSR", absolute, rmwAccess, 6, false}, // 4E LSR_ABS
+    {"SRE", absolute, rmwAccess, 6, true}, // 4F SRE_ABS
+    {"BVC", relative, noAccess, 2, false}, // 50 BVC
+    {"EOR", indirectY, readAccess, 5, false}, // 51 EOR_INDY
+    {"JAM", implied, noAccess, 0, true}, // 52 JAM
+    {"SRE", indirectY, rmwAccess, 8, true}, // 53 SRE_INDY
+    {"NOP", zeroPageX, readAccess, 4, true}, // 54 NOP_1B4C
+    {"EOR", zeroPageX, readAccess, 4, false}, // 55 EOR_ZPX
+    {"LSR", zeroPageX, rmwAccess, 6, false}, // 56 LSR_ZPX
+    {"SRE", zeroPageX, rmwAccess, 6, true}, // 57 SRE_ZPX
+    {"CLI", implied, noAccess, 2, false}, // 58 CLI
+    {"EOR", absoluteY, readAccess, 4, false}, // 59 EOR_ABSY
+    {"NOP", implied, noAccess, 2, true}, // 5A NOP_0B2C
+    {"SRE", absoluteY, rmwAccess, 7, true}, // 5B SRE_ABSY
+    {"NOP", absoluteX, readAccess, 4, true}, // 5C NOP_2B45C
+    {"EOR", absoluteX, readAccess, 4, false}, // 5D EOR_ABSX
+    {"LSR", absoluteX, rmwAccess, 7, false}, // 5E LSR_ABSX
+    {"SRE", absoluteX, rmwAccess, 7, true}, // 5F SRE_ABSX
+    {"RTS", implied, noAccess, 6, false}, // 60 RTS_IMP
+    {"ADC", indirectX, readAccess, 6, false}, // 61 ADC_INDX
+    {"JAM", implied, noAccess, 0, true}, // 62 JAM
+    {"RRA", indirectX, rmwAccess, 8, true}, // 63 RRA_INDX
+    {"NOP", zeroPage, readAccess, 3, true}, // 64 NOP_1B3C
+    {"ADC", zeroPage, readAccess, 3, false}, // 65 ADC_ZP
+    {"ROR", zeroPage, rmwAccess, 5, false}, // 66 ROR_ZP
+    {"RRA", zeroPage, rmwAccess, 5, true}, // 67 RRA_ZP
+    {"PLA", implied, noAccess, 4, false}, // 68 PLA
+    {"ADC", immediate, noAccess, 2, false}, // 69 ADC_IM
+    {"ROR", accumulator, noAccess, 2, false}, // 6A ROR_ACC
+    {"ARR", immediate, noAccess, 2, true}, // 6B ARR_IM
+    {"JMP", indirect, noAccess, 5, false}, // 6C JMP_IND
+    {"ADC", absolute, readAccess, 4, false}, // 6D ADC_ABS
+    {"ROR", absolute, rmwAccess, 6, false}, // 6E ROR_ABS
+    {"RRA", absolute, rmwAccess, 6, true}, // 6F RRA_ABS
+    {"BVS", relative, noAccess, 2, false}, // 70 BVS
+    {"ADC", indirectY, readAccess, 5, false}, // 71 ADC_INDY
+    {"JAM", implied, noAccess, 0, true}, // 72 JAM
+    {"RRA", indirectY, rmwAccess, 8, true}, // 73 RRA_INDY
+    {"NOP", zeroPageX, readAccess, 4, true}, // 74 NOP_1B4C
+    {"ADC", zeroPageX, readAccess, 4, false}, // 75 ADC_ZPX
+    {"ROR", zeroPageX, rmwAccess, 6, false}, // 76 ROR_ZPX
+    {"RRA", zeroPageX, rmwAccess, 6, true}, // 77 RRA_ZPX
+    {"SEI", implied, noAccess, 2, false}, // 78 SEI
+    {"ADC", absoluteY, readAccess, 4, false}, // 79 ADC_ABSY
+    {"NOP", implied, noAccess, 2, true}, // 7A NOP_0B2C
+    {"RRA", absoluteY, rmwAccess, 7, true}, // 7B RRA_ABSY
+    {"NOP", absoluteX, readAccess, 4, true}, // 7C NOP_2B45C
+    {"ADC", absoluteX, readAccess, 4, false}, // 7D ADC_ABSX
+    {"ROR", absoluteX, rmwAccess, 7, false}, // 7E ROR_ABSX
+    {"RRA", absoluteX, rmwAccess, 7, true}, // 7F RRA_ABSX
+    {"NOP", immediate, noAccess, 2, true}, // 80 NOP_1B2C
+    {"STA", indirectX, writeAccess, 6, false}, // 81 STA_INDX
+    {"NOP", immediate, noAccess, 2, true}, // 82 NOP_1B2C
+    {"SAX", indirectX, writeAccess, 6, true}, // 83 SAX_INDX
+    {"STY", zeroPage, writeAccess, 3, false}, // 84 STY_ZP
+    {"STA", zeroPage, writeAccess, 3, false}, // 85 STA_ZP
+    {"STX", zeroPage, writeAccess, 3, false}, // 86 STX_ZP
+    {"SAX", zeroPage, writeAccess, 3, true}, // 87 SAX_ZP
+    {"DEY", implied, noAccess, 2, false}, // 88 DEY
+    {"NOP", immediate, noAccess, 2, true}, // 89 NOP_1B2C
+    {"TXA", implied, noAccess, 2, false}, // 8A TXA
+    {"ANE", immediate, noAccess, 2, true}, // 8B ANE_IM
+    {"STY", absolute, writeAccess, 4, false}, // 8C STY_ABS
+    {"STA", absolute, writeAccess, 4, false}, // 8D STA_ABS
+    {"STX", absolute, writeAccess, 4, false}, // 8E STX_ABS
+    {"SAX", absolute, writeAccess, 4, true}, // 8F SAX_ABS
+    {"BCC", relative, noAccess, 2, false}, // 90 BCC
+    {"STA", indirectY, writeAccess, 6, false}, // 91 STA_INDY
+    {"JAM", implied, noAccess, 0, true}, // 92 JAM
+    {"SHA", indirectY, writeAccess, 6, true}, // 93 SHA_INDY
+    {"STY", zeroPageX, writeAccess, 4, false}, // 94 STY_ZPX
+    {"STA", zeroPageX, writeAccess, 4, false}, // 95 STA_ZPX
+    {"STX", zeroPageY, writeAccess, 4, false}, // 96 STX_ZPY
+    {"SAX", zeroPageY, writeAccess, 4, true}, // 97 SAX_ZPY
+    {"TYA", implied, noAccess, 2, false}, // 98 TYA
+    {"STA", absoluteY, writeAccess, 5, false}, // 99 STA_ABSY
+    {"TXS", implied, noAccess, 2, false}, // 9A TXS
+    {"TAS", absoluteY, writeAccess, 5, true}, // 9B TAS_ABSY
+    {"SHY", absoluteX, writeAccess, 5, true}, // 9C SHY_ABSX
+    {"STA", absoluteX, writeAccess, 5, false}, // 9D STA_ABSX
+    {"SHX", absoluteY, writeAccess, 5, true}, // 9E SHX_ABSY
+    {"SHA", absoluteY, writeAccess, 5, true}, // 9F SHA_ABSY
+    {"LDY", immediate, noAccess, 2, false}, // A0 LDY_IM
+    {"LDA", indirectX, readAccess, 6, false}, // A1 LDA_INDX
+    {"LDX", immediate, noAccess, 2, false}, // A2 LDX_IM
+    {"LAX", indirectX, readAccess, 6, true}, // A3 LAX_INDX
+    {"LDY", zeroPage, readAccess, 3, false}, // A4 LDY_ZP
+    {"LDA", zeroPage, readAccess, 3, false}, // A5 LDA_ZP
+    {"LDX", zeroPage, readAccess, 3, false}, // A6 LDX_ZP
+    {"LAX", zeroPage, readAccess, 3, true}, // A7 LAX_ZP
+    {"TAY", implied, noAccess, 2, false}, // A8 TAY
+    {"LDA", immediate, noAccess, 2, false}, // A9 LDA_IM
+    {"TAX", implied, noAccess, 2, false}, // AA TAX
+    {"LXA", immediate, noAccess, 2, true}, // AB LXA_IM
+    {"LDY", absolute, readAccess, 4, false}, // AC LDY_ABS
+    {"LDA", absolute, readAccess, 4, false}, // AD LDA_ABS
+    {"LDX", absolute, readAccess, 4, false}, // AE LDX_ABS
+    {"LAX", absolute, readAccess, 4, true}, // AF LAX_ABS
+    {"BCS", relative, noAccess, 2, false}, // B0 BCS
+    {"LDA", indirectY, readAccess, 5, false}, // B1 LDA_INDY
+    {"JAM", implied, noAccess, 0, true}, // B2 JAM
+    {"LAX", indirectY, readAccess, 5, true}, // B3 LAX_INDY
+    {"LDY", zeroPageX, readAccess, 4, false}, // B4 LDY_ZPX
+    {"LDA", zeroPageX, readAccess, 4, false}, // B5 LDA_ZPX
+    {"LDX", zeroPageY, readAccess, 4, false}, // B6 LDX_ZPY
+    {"LAX", zeroPageY, readAccess, 4, true}, // B7 LAX_ZPY
+    {"CLV", implied, noAccess, 2, false}, // B8 CLV
+    {"LDA", absoluteY, readAccess, 4, false}, // B9 LDA_ABSY
+    {"TSX", implied, noAccess, 2, false}, // BA TSX
+    {"LAS", absoluteY, readAccess, 4, true}, // BB LAS_ABSY
+    {"LDY", absoluteX, readAccess, 4, false}, // BC LDY_ABSX
+    {"LDA", absoluteX, readAccess, 4, false}, // BD LDA_ABSX
+    {"LDX", absoluteY, readAccess, 4, false}, // BE LDX_ABSY
+    {"LAX", absoluteY, readAccess, 4, true}, // BF LAX_ABSY
+    {"CPY", immediate, noAccess, 2, false}, // C0 CPY_IM
+    {"CMP", indirectX, readAccess, 6, false}, // C1 CMP_INDX
+    {"NOP", immediate, noAccess, 2, true}, // C2 NOP_1B2C
+    {"DCP", indirectX, rmwAccess, 8, true}, // C3 DCP_INDX
+    {"CPY", zeroPage, readAccess, 3, false}, // C4 CPY_ZP
+    {"CMP", zeroPage, readAccess, 3, false}, // C5 CMP_ZP
+    {"DEC", zeroPage, rmwAccess, 5, false}, // C6 DEC_ZP
+    {"DCP", zeroPage, rmwAccess, 5, true}, // C7 DCP_ZP
+    {"INY", implied, noAccess, 2, false}, // C8 INY
+    {"CMP", immediate, noAccess, 2, false}, // C9 CMP_IM
+    {"DEX", implied, noAccess, 2, false}, // CA DEX
+    {"SBX", immediate, noAccess, 2, true}, // CB SBX_IM
+    {"CPY", absolute, readAccess, 4, false}, // CC CPY_ABS
+    {"CMP", absolute, readAccess, 4, false}, // CD CMP_ABS
+    {"DEC", absolute, rmwAccess, 6, false}, // CE DEC_ABS
+    {"DCP", absolute, rmwAccess, 6, true}, // CF DCP_ABS
+    {"BNE", relative, noAccess, 2, false}, // D0 BNE
+    {"CMP", indirectY, readAccess, 5, false}, // D1 CMP_INDY
+    {"JAM", implied, noAccess, 0, true}, // D2 JAM
+    {"DCP", indirectY, rmwAccess, 8, true}, // D3 DCP_INDY
+    {"NOP", zeroPageX, readAccess, 4, true}, // D4 NOP_1B4C
+    {"CMP", zeroPageX, readAccess, 4, false}, // D5 CMP_ZPX
+    {"DEC", zeroPageX, rmwAccess, 6, false}, // D6 DEC_ZPX
+    {"DCP", zeroPageX, rmwAccess, 6, true}, // D7 DCP_ZPX
+    {"CLD", implied, noAccess, 2, false}, // D8 CLD
+    {"CMP", absoluteY, readAccess, 4, false}, // D9 CMP_ABSY
+    {"NOP", implied, noAccess, 2, true}, // DA NOP_0B2C
+    {"DCP", absoluteY, rmwAccess, 7, true}, // DB DCP_ABSY
+    {"NOP", absoluteX, readAccess, 4, true}, // DC NOP_2B45C
+    {"CMP", absoluteX, readAccess, 4, false}, // DD CMP_ABSX
+    {"DEC", absoluteX, rmwAccess, 7, false}, // DE DEC_ABSX
+    {"DCP", absoluteX, rmwAccess, 7, true}, // DF DCP_ABSX
+    {"CPX", immediate, noAccess, 2, false}, // E0 CPX_IM
+    {"SBC", indirectX, readAccess, 6, false}, // E1 SBC_INDX
+    {"NOP", immediate, noAccess, 2, true}, // E2 NOP_1B2C
+    {"ISC", indirectX, rmwAccess, 8, true}, // E3 ISC_INDX
+    {"CPX", zeroPage, readAccess, 3, false}, // E4 CPX_ZP
+    {"SBC", zeroPage, readAccess, 3, false}, // E5 SBC_ZP
+    {"INC", zeroPage, rmwAccess, 5, false}, // E6 INC_ZP
+    {"ISC", zeroPage, rmwAccess, 5, true}, // E7 ISC_ZP
+    {"INX", implied, noAccess, 2, false}, // E8 INX
+    {"SBC", immediate, noAccess, 2, false}, // E9 SBC_IM
+    {"NOP", implied, noAccess, 2, false}, // EA NOP_IMP
+    {"USBC", immediate, noAccess, 2, true}, // EB USBC_IM
+    {"CPX", absolute, readAccess, 4, false}, // EC CPX_ABS
+    {"SBC", absolute, readAccess, 4, false}, // ED SBC_ABS
+    {"INC", absolute, rmwAccess, 6, false}, // EE INC_ABS
+    {"ISC", absolute, rmwAccess, 6, true}, // EF ISC_ABS
+    {"BEQ", relative, noAccess, 2, false}, // F0 BEQ
+    {"SBC", indirectY, readAccess, 5, false}, // F1 SBC_INDY
+    {"JAM", implied, noAccess, 0, true}, // F2 JAM
+    {"ISC", indirectY, rmwAccess, 8, true}, // F3 ISC_INDY
+    {"NOP", zeroPageX, readAccess, 4, true}, // F4 NOP_1B4C
+    {"SBC", zeroPageX, readAccess, 4, false}, // F5 SBC_ZPX
+    {"INC", zeroPageX, rmwAccess, 6, false}, // F6 INC_ZPX
+    {"ISC", zeroPageX, rmwAccess, 6, true}, // F7 ISC_ZPX
+    {"SED", implied, noAccess, 2, false}, // F8 SED
+    {"SBC", absoluteY, readAccess, 4, false}, // F9 SBC_ABSY
+    {"NOP", implied, noAccess, 2, true}, // FA NOP_0B2C
+    {"ISC", absoluteY, rmwAccess, 7, true}, // FB ISC_ABSY
+    {"NOP", absoluteX, readAccess, 4, true}, // FC NOP_2B45C
+    {"SBC", absoluteX, readAccess, 4, false}, // FD SBC_ABSX
+    {"INC", absoluteX, rmwAccess, 7, false}, // FE INC_ABSX
+    {"ISC", absoluteX, rmwAccess, 7, true}, // FF ISC_ABSX
+};
+
+int instructionLength(AddrMode mode) {
+    switch (mode) {
+        case implied:
+        case accumulator:
+            return 1;
+        case absolute:
+        case absoluteX:
+        case absoluteY:
+        case indirect:
+            return 3;
+        default:
+            return 2;
+    }
+}
+
+const char *addrModeName(AddrMode mode) {
+    static const char *names[] = {
+        "implied", "accumulator", "immediate", "zeroPage", "zeroPageX", "zeroPageY", "absolute",
+        "absoluteX", "absoluteY", "indirect", "indirectX", "indirectY", "relative"
+    };
+    return names[mode];
+}
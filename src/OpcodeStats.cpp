@@ -0,0 +1,176 @@
+#include <OpcodeStats.h>
+#include <OpcodeInfo.h>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <cstring>
+
+OpcodeStats::OpcodeStats() {
+    clear();
+}
+
+void OpcodeStats::clear() {
+    memset(counts, 0, sizeof(counts));
+    pairs.assign(0x10000, 0);
+    triples.assign(TRIPLESLOTS, Triple{EMPTY, 0});
+    triplesUsed = 0;
+    triplesDropped = 0;
+    started = false;
+    interrupted = false;
+    previous = 0;
+    executed = 0;
+}
+
+// Branches: one extra cycle when taken, two when the target is on another
+// page. Indexed reads: one extra on a page cross. Anything else came from
+// outside the instruction, an OAM DMA triggered by a write
+void OpcodeStats::penalty(uint8_t opcode, int extra) {
+    const OpcodeInfo &info = opcodeInfo[opcode];
+    Counter &counter = counts[opcode];
+    if (info.mode == relative) {
+        counter.branchesTaken++;
+        if (extra > 1)
+            counter.pageCrosses++;
+        extra -= extra > 1 ? 2 : 1;
+    }
+    else if (info.access == readAccess && (info.mode == absoluteX || info.mode == absoluteY || info.mode == indirectY)) {
+        counter.pageCrosses++;
+        extra--;
+    }
+    counter.extraCycles += extra;
+}
+
+void OpcodeStats::countTriple(uint32_t key, uint64_t count) {
+    size_t slot = (key * 2654435761u) >> 16 & (TRIPLESLOTS - 1);
+    while (triples[slot].key != key) {
+        if (triples[slot].key == EMPTY) {
+            // Keep the table sparse enough for short probes
+            if (triplesUsed >= TRIPLESLOTS * 3 / 4) {
+                triplesDropped += count;
+                return;
+            }
+            triples[slot].key = key;
+            triplesUsed++;
+            break;
+        }
+        slot = (slot + 1) & (TRIPLESLOTS - 1);
+    }
+    triples[slot].count += count;
+}
+
+void OpcodeStats::merge(const OpcodeStats &other) {
+    for (int opcode = 0; opcode < 256; opcode++) {
+        counts[opcode].executions += other.counts[opcode].executions;
+        counts[opcode].cycles += other.counts[opcode].cycles;
+        counts[opcode].pageCrosses += other.counts[opcode].pageCrosses;
+        counts[opcode].branchesTaken += other.counts[opcode].branchesTaken;
+        counts[opcode].extraCycles += other.counts[opcode].extraCycles;
+    }
+    for (size_t i = 0; i < pairs.size(); i++)
+        pairs[i] += other.pairs[i];
+    for (const Triple &triple : other.triples) {
+        if (triple.key != EMPTY)
+            countTriple(triple.key, triple.count);
+    }
+    triplesDropped += other.triplesDropped;
+}
+
+uint64_t OpcodeStats::instructions() const {
+    uint64_t total = 0;
+    for (const Counter &counter : counts)
+        total += counter.executions;
+    return total;
+}
+
+std::vector<std::pair<uint16_t, uint64_t>> OpcodeStats::topPairs(size_t count) const {
+    std::vector<std::pair<uint64_t, uint32_t>> sorted;
+    for (uint32_t pair = 0; pair < pairs.size(); pair++) {
+        if (pairs[pair])
+            sorted.push_back({pairs[pair], pair});
+    }
+    size_t shown = std::min(count, sorted.size());
+    std::partial_sort(sorted.begin(), sorted.begin() + shown, sorted.end(), std::greater<std::pair<uint64_t, uint32_t>>());
+    std::vector<std::pair<uint16_t, uint64_t>> result;
+    for (size_t i = 0; i < shown; i++)
+        result.push_back({(uint16_t)sorted[i].second, sorted[i].first});
+    return result;
+}
+
+static void writeOpcode(std::ostream &out, uint8_t opcode) {
+    out << "\"" << std::setw(2) << std::setfill('0') << std::hex << std::uppercase << (int)opcode << std::dec << "\"";
+}
+
+void OpcodeStats::writeJSON(std::ostream &out, size_t top) {
+    out << "{\n  \"instructions\": " << instructions() << ",\n  \"opcodes\": [";
+    bool first = true;
+    for (int opcode = 0; opcode < 256; opcode++) {
+        const Counter &counter = counts[opcode];
+        if (!counter.executions)
+            continue;
+        const OpcodeInfo &info = opcodeInfo[opcode];
+        out << (first ? "\n" : ",\n") << "    {\"opcode\": ";
+        writeOpcode(out, opcode);
+        out << ", \"mnemonic\": \"" << info.mnemonic << "\", \"mode\": \"" << addrModeName(info.mode) << "\""
+            << ", \"count\": " << counter.executions << ", \"cycles\": " << counter.cycles
+            << ", \"page_crosses\": " << counter.pageCrosses;
+        if (info.mode == relative)
+            out << ", \"taken\": " << counter.branchesTaken << ", \"not_taken\": " << counter.executions - counter.branchesTaken;
+        if (counter.extraCycles)
+            out << ", \"extra_cycles\": " << counter.extraCycles;
+        out << "}";
+        first = false;
+    }
+
+    // Per addressing mode, summed from the opcodes
+    Counter modes[relative + 1] = {};
+    for (int opcode = 0; opcode < 256; opcode++) {
+        Counter &mode = modes[opcodeInfo[opcode].mode];
+        mode.executions += counts[opcode].executions;
+        mode.cycles += counts[opcode].cycles;
+        mode.pageCrosses += counts[opcode].pageCrosses;
+        mode.branchesTaken += counts[opcode].branchesTaken;
+    }
+    out << "\n  ],\n  \"modes\": [";
+    first = true;
+    for (int mode = 0; mode <= relative; mode++) {
+        if (!modes[mode].executions)
+            continue;
+        out << (first ? "\n" : ",\n") << "    {\"mode\": \"" << addrModeName((AddrMode)mode) << "\""
+            << ", \"count\": " << modes[mode].executions << ", \"cycles\": " << modes[mode].cycles
+            << ", \"page_crosses\": " << modes[mode].pageCrosses;
+        if (mode == relative)
+            out << ", \"taken\": " << modes[mode].branchesTaken;
+        out << "}";
+        first = false;
+    }
+
+    std::vector<std::pair<uint16_t, uint64_t>> frequent = topPairs(top);
+    out << "\n  ],\n  \"pairs\": [";
+    for (size_t i = 0; i < frequent.size(); i++) {
+        out << (i ? ",\n" : "\n") << "    {\"ops\": [";
+        writeOpcode(out, frequent[i].first >> 8);
+        out << ", ";
+        writeOpcode(out, frequent[i].first & 0xFF);
+        out << "], \"count\": " << frequent[i].second << "}";
+    }
+
+    std::vector<std::pair<uint64_t, uint32_t>> sorted;
+    sorted.clear();
+    for (const Triple &triple : triples) {
+        if (triple.key != EMPTY)
+            sorted.push_back({triple.count, triple.key});
+    }
+    size_t shown = std::min(top, sorted.size());
+    std::partial_sort(sorted.begin(), sorted.begin() + shown, sorted.end(), std::greater<std::pair<uint64_t, uint32_t>>());
+    out << "\n  ],\n  \"triples\": [";
+    for (size_t i = 0; i < shown; i++) {
+        out << (i ? ",\n" : "\n") << "    {\"ops\": [";
+        writeOpcode(out, sorted[i].second >> 16);
+        out << ", ";
+        writeOpcode(out, (sorted[i].second >> 8) & 0xFF);
+        out << ", ";
+        writeOpcode(out, sorted[i].second & 0xFF);
+        out << "], \"count\": " << sorted[i].first << "}";
+    }
+    out << "\n  ],\n  \"triples_dropped\": " << triplesDropped << "\n}\n";
+}
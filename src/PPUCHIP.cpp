@@ -1,3 +1,447 @@
 #include<PPUCHIP.h>
+#include<Instrument.h>
+#include<Coverage.h>
+#include<StateHash.h>
+#include<Hash.h>
+#include<cstring>
 
-PPUCHIP::PPUCHIP() {}
\ No newline at end of file
+PPUCHIP::PPUCHIP() {
+    NMI_occurred = false;
+}
+
+void PPUCHIP::loadCHR(std::ifstream &ROM, int size, bool verticalMirroring) {
+    this->verticalMirroring = verticalMirroring;
+    CHRRAM = size == 0;
+    if (!CHRRAM) {
+        ROM.read((char*)CHR, size < 0x2000 ? size : 0x2000);
+    }
+}
+
+void PPUCHIP::reset() {
+    ctrl = 0;
+    mask = 0;
+    w = false;
+    logWrite(PPUWrite::writeCtrl, 0, 0);
+    logWrite(PPUWrite::writeMask, 0, 0);
+    readBuffer = 0;
+    predictionStale = true;
+    updateNMI();
+}
+
+uint64_t PPUCHIP::registerHash(uint64_t hash) const {
+    hash = hashValue(hash, ctrl | mask << 8 | (uint64_t)oamAddr << 16 | (uint64_t)fineX << 24 | (uint64_t)w << 32
+                               | (uint64_t)readBuffer << 40);
+    return hashValue(hash, v | (uint64_t)t << 16);
+}
+
+uint64_t PPUCHIP::hash(uint64_t hash) const {
+    hash = hashValue(hash, ctrl | mask << 8 | status << 16 | (uint64_t)oamAddr << 24 | (uint64_t)fineX << 32
+                               | (uint64_t)w << 40 | (uint64_t)readBuffer << 48 | (uint64_t)oddFrame << 56);
+    hash = hashValue(hash, v | (uint64_t)t << 16 | (uint64_t)scanline << 32 | (uint64_t)dot << 48);
+    hash = hashValue(hash, frame | (uint64_t)frameT << 48);
+    hash = hashValue(hash, frameFineX);
+    hash = hashBytes(hash, nametables, sizeof(nametables));
+    hash = hashBytes(hash, palette, sizeof(palette));
+    hash = hashBytes(hash, OAM, sizeof(OAM));
+    if (CHRRAM)
+        hash = hashBytes(hash, CHR, sizeof(CHR));
+    return hash;
+}
+
+uint8_t PPUCHIP::readRegister(uint16_t addr) {
+    uint8_t value = 0;
+    switch (addr & 0x7) {
+        case PPUSTATUS:
+            value = status & 0xE0;
+            status &= ~0x80;
+            w = false;
+            updateNMI();
+            break;
+        case OAMDATA:
+            value = OAM[oamAddr];
+            break;
+        case PPUDATA:
+            // Reads below the palettes come from a one byte buffer
+            if ((v & 0x3FFF) < 0x3F00) {
+                value = readBuffer;
+                readBuffer = ppuRead(v);
+                if (coverage && (v & 0x3FFF) < 0x2000)
+                    coverage->markCHR(v & 0x1FFF, Coverage::chrRead);
+            }
+            else {
+                value = ppuRead(v);
+                readBuffer = ppuRead(v - 0x1000);
+            }
+            v += (ctrl & 0x04) ? 32 : 1;
+            break;
+    }
+    return value;
+}
+
+void PPUCHIP::writeRegister(uint16_t addr, uint8_t value) {
+    predictionStale = true;
+    switch (addr & 0x7) {
+        case PPUCTRL:
+            if ((ctrl ^ value) & 0x20)
+                oamDirty = true;
+            ctrl = value;
+            t = (t & 0xF3FF) | ((value & 0x03) << 10);
+            logWrite(PPUWrite::writeCtrl, 0, value);
+            logWrite(PPUWrite::writeScroll, t, fineX);
+            updateNMI();
+            break;
+        case PPUMASK:
+            mask = value;
+            logWrite(PPUWrite::writeMask, 0, value);
+            break;
+        case OAMADDR:
+            oamAddr = value;
+            break;
+        case OAMDATA:
+            writeOAM(value);
+            break;
+        case PPUSCROLL:
+            if (!w) {
+                t = (t & 0xFFE0) | (value >> 3);
+                fineX = value & 0x07;
+            }
+            else {
+                t = (t & 0x8C1F) | ((value & 0x07) << 12) | ((value & 0xF8) << 2);
+            }
+            w = !w;
+            logWrite(PPUWrite::writeScroll, t, fineX);
+            break;
+        case PPUADDR:
+            if (!w) {
+                t = (t & 0x00FF) | ((value & 0x3F) << 8);
+            }
+            else {
+                t = (t & 0xFF00) | value;
+                v = t;
+            }
+            w = !w;
+            logWrite(PPUWrite::writeScroll, t, fineX);
+            if (!w)
+                logWrite(PPUWrite::writeAddr, v, 0);
+            break;
+        case PPUDATA:
+            logWrite(PPUWrite::writeVRAM, v & 0x3FFF, value);
+            ppuWrite(v, value);
+            v += (ctrl & 0x04) ? 32 : 1;
+            break;
+    }
+}
+
+void PPUCHIP::writeOAM(uint8_t value) {
+    predictionStale = true;
+    oamDirty = true;
+    logWrite(PPUWrite::writeOAM, oamAddr, value);
+    if (stateHash)
+        stateHash->write(StateHash::OAM + oamAddr, OAM[oamAddr], value);
+    OAM[oamAddr++] = value;
+}
+
+void PPUCHIP::tick(int dots) {
+    INSTRUMENT_ZONE(zonePPU);
+    while (dots > 0) {
+        int pos = scanline * DOTS + dot;
+        // The pre-render line is one dot shorter on odd frames while rendering
+        int frameLength = SCANLINES * DOTS - ((oddFrame && (mask & 0x18)) ? 1 : 0);
+        int step = dots < frameLength - pos ? dots : frameLength - pos;
+        int end = pos + step;
+        int hit = sprite0HitDot();
+        int overflow = spriteOverflowDot();
+
+        if (pos <= hit && end > hit)
+            status |= 0x40;
+        if (pos <= overflow && end > overflow)
+            status |= 0x20;
+        if (pos <= VBLANKSET && end > VBLANKSET) {
+            status |= 0x80;
+            if (coverage)
+                coverFrame();
+        }
+        if (pos <= VBLANKCLEAR && end > VBLANKCLEAR)
+            status &= ~0xE0;
+
+        dots -= step;
+        if (end == frameLength) {
+            end = 0;
+            oddFrame = !oddFrame;
+            // The pre-render line copied t into v, as the renderer does, so
+            // a renderer restarted from inputs() begins the frame with it
+            if (mask & 0x18)
+                v = t;
+            frameT = t;
+            frameFineX = fineX;
+            predictionStale = true;
+            frame++;
+        }
+        scanline = end / DOTS;
+        dot = end % DOTS;
+    }
+    updateNMI();
+}
+
+uint64_t PPUCHIP::getFrame() const {
+    return frame;
+}
+
+int PPUCHIP::dotsUntilEvent() {
+    int pos = scanline * DOTS + dot;
+    int frameLength = SCANLINES * DOTS - ((oddFrame && (mask & 0x18)) ? 1 : 0);
+    int next = frameLength;
+    int events[] = {sprite0HitDot(), spriteOverflowDot(), VBLANKSET, VBLANKCLEAR};
+    for (int event : events) {
+        if (event >= pos && event < next)
+            next = event;
+    }
+    return next - pos;
+}
+
+void PPUCHIP::setRenderLog(std::vector<PPUWrite> *log) {
+    renderLog = log;
+}
+
+void PPUCHIP::inputs(PPUInputs &inputs) const {
+    inputs.ctrl = ctrl;
+    inputs.mask = mask;
+    inputs.t = t;
+    inputs.v = v;
+    inputs.fineX = fineX;
+    inputs.verticalMirroring = verticalMirroring;
+    inputs.CHRRAM = CHRRAM;
+    memcpy(inputs.CHR, CHR, sizeof(CHR));
+    memcpy(inputs.nametables, nametables, sizeof(nametables));
+    memcpy(inputs.palette, palette, sizeof(palette));
+    memcpy(inputs.OAM, OAM, sizeof(OAM));
+}
+
+void PPUCHIP::saveState(State &state) const {
+    state.NMI_occurred = NMI_occurred;
+    state.ctrl = ctrl;
+    state.mask = mask;
+    state.status = status;
+    state.oamAddr = oamAddr;
+    state.v = v;
+    state.t = t;
+    state.fineX = fineX;
+    state.w = w;
+    state.readBuffer = readBuffer;
+    state.oddFrame = oddFrame;
+    state.scanline = scanline;
+    state.dot = dot;
+    state.frame = frame;
+    state.frameT = frameT;
+    state.frameFineX = frameFineX;
+    memcpy(state.CHR, CHR, sizeof(CHR));
+    memcpy(state.nametables, nametables, sizeof(nametables));
+    memcpy(state.palette, palette, sizeof(palette));
+    memcpy(state.OAM, OAM, sizeof(OAM));
+}
+
+void PPUCHIP::loadState(const State &state) {
+    NMI_occurred = state.NMI_occurred;
+    ctrl = state.ctrl;
+    mask = state.mask;
+    status = state.status;
+    oamAddr = state.oamAddr;
+    v = state.v;
+    t = state.t;
+    fineX = state.fineX;
+    w = state.w;
+    readBuffer = state.readBuffer;
+    oddFrame = state.oddFrame;
+    scanline = state.scanline;
+    dot = state.dot;
+    frame = state.frame;
+    frameT = state.frameT;
+    frameFineX = state.frameFineX;
+    memcpy(CHR, state.CHR, sizeof(CHR));
+    memcpy(nametables, state.nametables, sizeof(nametables));
+    memcpy(palette, state.palette, sizeof(palette));
+    memcpy(OAM, state.OAM, sizeof(OAM));
+    predictionStale = true;
+    oamDirty = true;
+}
+
+void PPUCHIP::setStateHash(StateHash *hash) {
+    stateHash = hash;
+}
+
+void PPUCHIP::rehash(StateHash &hash) const {
+    hash.add(StateHash::NAMETABLES, nametables, sizeof(nametables));
+    hash.add(StateHash::PALETTE, palette, sizeof(palette));
+    hash.add(StateHash::OAM, OAM, sizeof(OAM));
+    if (CHRRAM)
+        hash.add(StateHash::CHR, CHR, sizeof(CHR));
+}
+
+void PPUCHIP::setCoverage(Coverage *coverage) {
+    this->coverage = coverage;
+}
+
+// Rendering is optional and may run on another thread, so the frame's
+// tiles are approximated by what the nametables and OAM reference once
+// it's done: every background tile of both nametables, visible or not,
+// and every sprite above the bottom line. A superset of the fetched tiles
+// unless PPUCTRL or the nametables changed mid-frame
+void PPUCHIP::coverFrame() {
+    if (CHRRAM)
+        return;
+    auto tile = [&](uint16_t addr) {
+        for (int i = 0; i < 16; i++)
+            coverage->markCHR(addr + i, Coverage::chrDrawn);
+    };
+    if (mask & 0x08) {
+        uint16_t table = (ctrl & 0x10) ? 0x1000 : 0;
+        for (int i = 0; i < 0x800; i++) {
+            // The last 64 bytes of each nametable are attributes
+            if ((i & 0x3FF) < 0x3C0)
+                tile(table + nametables[i] * 16);
+        }
+    }
+    if (mask & 0x10) {
+        for (int sprite = 0; sprite < 64; sprite++) {
+            uint8_t y = OAM[sprite * 4];
+            uint8_t index = OAM[sprite * 4 + 1];
+            if (y >= 0xEF)
+                continue;
+            if (ctrl & 0x20) {
+                // 8x16: bit 0 picks the pattern table
+                uint16_t table = (index & 1) ? 0x1000 : 0;
+                tile(table + (index & 0xFE) * 16);
+                tile(table + (index | 1) * 16);
+            }
+            else {
+                tile(((ctrl & 0x08) ? 0x1000 : 0) + index * 16);
+            }
+        }
+    }
+}
+
+void PPUCHIP::updateNMI() {
+    NMI_occurred = (status & 0x80) && (ctrl & 0x80);
+}
+
+// Overflow for a line is found while the line before evaluates sprites,
+// taken to be done by dot 256. The sprite lists only follow OAM and the
+// sprite size, scroll and VRAM writes just move sprite 0 hit
+void PPUCHIP::predict() {
+    hitDot = predictSprite0Hit();
+    overflowDot = -1;
+    if (mask & 0x18) {
+        if (oamDirty)
+            spriteLists.build(OAM, ctrl & 0x20);
+        oamDirty = false;
+        if (spriteLists.firstOverflow() > 0)
+            overflowDot = (spriteLists.firstOverflow() - 1) * DOTS + 256;
+    }
+    predictionStale = false;
+}
+
+int PPUCHIP::sprite0HitDot() {
+    if (predictionStale)
+        predict();
+    return hitDot;
+}
+
+int PPUCHIP::spriteOverflowDot() {
+    if (predictionStale)
+        predict();
+    return overflowDot;
+}
+
+// The first opaque sprite 0 pixel over an opaque background pixel, outside
+// the clipped left column and never at x 255, assuming the scroll doesn't
+// change before it. Pixel x comes out at dot x + 1
+int PPUCHIP::predictSprite0Hit() const {
+    if ((mask & 0x18) != 0x18 || OAM[0] >= 239)
+        return -1;
+    int height = (ctrl & 0x20) ? 16 : 8;
+    uint8_t index = OAM[1];
+    uint8_t attributes = OAM[2];
+    for (int row = 0; row < height; row++) {
+        int line = OAM[0] + 1 + row;
+        if (line >= 240)
+            break;
+        int patternRow = (attributes & 0x80) ? height - 1 - row : row;
+        uint16_t addr;
+        if (height == 16)
+            addr = ((index & 1) ? 0x1000 : 0) + (index & 0xFE) * 16 + (patternRow & 8) * 2 + (patternRow & 7);
+        else
+            addr = ((ctrl & 0x08) ? 0x1000 : 0) + index * 16 + patternRow;
+        uint8_t bits = CHR[addr] | CHR[addr + 8];
+        for (int col = 0; col < 8; col++) {
+            int x = OAM[3] + col;
+            if (x >= 255)
+                break;
+            if (x < 8 && (mask & 0x06) != 0x06)
+                continue;
+            int shift = (attributes & 0x40) ? col : 7 - col;
+            if (((bits >> shift) & 1) && backgroundOpaque(x, line))
+                return line * DOTS + x + 1;
+        }
+    }
+    return -1;
+}
+
+// Screen position to nametable pixel with the frame's starting scroll,
+// 512x480 across the four nametables
+bool PPUCHIP::backgroundOpaque(int x, int line) const {
+    int scrollX = ((frameT & 0x1F) << 3 | frameFineX) + ((frameT & 0x0400) ? 256 : 0) + x;
+    int scrollY = (((frameT >> 5) & 0x1F) << 3 | (frameT >> 12 & 7)) + ((frameT & 0x0800) ? 240 : 0) + line;
+    scrollX %= 512;
+    scrollY %= 480;
+    int table = (scrollX >= 256 ? 1 : 0) | (scrollY >= 240 ? 2 : 0);
+    int tileX = (scrollX & 0xFF) >> 3;
+    int tileY = (scrollY % 240) >> 3;
+    uint8_t tile = nametables[nametableAddr(0x2000 | table << 10 | tileY << 5 | tileX)];
+    uint16_t addr = ((ctrl & 0x10) ? 0x1000 : 0) + tile * 16 + (scrollY % 240 & 7);
+    return ((CHR[addr] | CHR[addr + 8]) >> (7 - (scrollX & 7))) & 1;
+}
+
+// 2KB of nametable RAM, mirrored by the cartridge wiring
+uint16_t PPUCHIP::nametableAddr(uint16_t addr) const {
+    if (verticalMirroring)
+        return addr & 0x07FF;
+    return ((addr >> 1) & 0x0400) | (addr & 0x03FF);
+}
+
+uint8_t PPUCHIP::ppuRead(uint16_t addr) {
+    addr &= 0x3FFF;
+    if (addr < 0x2000)
+        return CHR[addr];
+    if (addr < 0x3F00)
+        return nametables[nametableAddr(addr)];
+    // $3F10/$3F14/$3F18/$3F1C mirror the background entries
+    addr &= 0x1F;
+    if ((addr & 0x13) == 0x10)
+        addr &= 0x0F;
+    return palette[addr];
+}
+
+void PPUCHIP::ppuWrite(uint16_t addr, uint8_t value) {
+    addr &= 0x3FFF;
+    if (addr < 0x2000) {
+        if (CHRRAM) {
+            if (stateHash)
+                stateHash->write(StateHash::CHR + addr, CHR[addr], value);
+            CHR[addr] = value;
+        }
+    }
+    else if (addr < 0x3F00) {
+        addr = nametableAddr(addr);
+        if (stateHash)
+            stateHash->write(StateHash::NAMETABLES + addr, nametables[addr], value);
+        nametables[addr] = value;
+    }
+    else {
+        addr &= 0x1F;
+        if ((addr & 0x13) == 0x10)
+            addr &= 0x0F;
+        if (stateHash)
+            stateHash->write(StateHash::PALETTE + addr, palette[addr], value);
+        palette[addr] = value;
+    }
+}
@@ -0,0 +1,278 @@
+#include <PPURenderer.h>
+#include <Instrument.h>
+#include <cstring>
+#include <algorithm>
+
+void PPURenderer::load(const PPUInputs &inputs) {
+    state = inputs;
+    spritesStale = true;
+    std::fill(keyValid, keyValid + HEIGHT, false);
+}
+
+bool PPURenderer::rendering() const {
+    return state.mask & 0x18;
+}
+
+void PPURenderer::applyUntil(uint32_t dot) {
+    while (next != last && next->dot < dot)
+        apply(*next++);
+}
+
+void PPURenderer::apply(const PPUWrite &write) {
+    switch (write.kind) {
+        case PPUWrite::writeCtrl:
+            if ((state.ctrl ^ write.value) & 0x20)
+                spritesStale = true;
+            state.ctrl = write.value;
+            break;
+        case PPUWrite::writeMask:
+            state.mask = write.value;
+            break;
+        case PPUWrite::writeScroll:
+            state.t = write.addr;
+            state.fineX = write.value;
+            break;
+        case PPUWrite::writeAddr:
+            state.v = write.addr;
+            break;
+        case PPUWrite::writeVRAM: {
+            uint16_t addr = write.addr & 0x3FFF;
+            if (addr < 0x2000) {
+                if (state.CHRRAM) {
+                    state.CHR[addr] = write.value;
+                    CHRVersion++;
+                }
+            }
+            else if (addr < 0x3F00) {
+                uint16_t physical = nametableAddr(addr);
+                state.nametables[physical] = write.value;
+                int table = physical >> 10;
+                int offset = physical & 0x3FF;
+                if (offset < 0x3C0) {
+                    rowVersions[table][offset >> 5]++;
+                }
+                else {
+                    // Coarse Y 30 and 31 read the attributes as tiles
+                    int row = ((offset - 0x3C0) >> 3) * 4;
+                    for (int i = row; i < row + 4 && i < 32; i++)
+                        rowVersions[table][i]++;
+                    rowVersions[table][offset >> 5]++;
+                }
+            }
+            else {
+                addr &= 0x1F;
+                if ((addr & 0x13) == 0x10)
+                    addr &= 0x0F;
+                state.palette[addr] = write.value;
+                paletteVersion++;
+            }
+            break;
+        }
+        case PPUWrite::writeOAM:
+            state.OAM[write.addr & 0xFF] = write.value;
+            spritesStale = true;
+            break;
+    }
+}
+
+uint16_t PPURenderer::nametableAddr(uint16_t addr) const {
+    if (state.verticalMirroring)
+        return addr & 0x07FF;
+    return ((addr >> 1) & 0x0400) | (addr & 0x03FF);
+}
+
+void PPURenderer::incrementY() {
+    uint16_t &v = state.v;
+    if ((v & 0x7000) != 0x7000) {
+        v += 0x1000;
+        return;
+    }
+    v &= ~0x7000;
+    int y = (v >> 5) & 0x1F;
+    if (y == 29) {
+        y = 0;
+        v ^= 0x0800;
+    }
+    else if (y == 31) {
+        y = 0;
+    }
+    else {
+        y++;
+    }
+    v = (v & ~0x03E0) | (y << 5);
+}
+
+void PPURenderer::setLineReuse(bool enabled, bool verify) {
+    reuse = enabled;
+    this->verify = verify;
+    std::fill(keyValid, keyValid + HEIGHT, false);
+}
+
+const PPURenderer::Stats &PPURenderer::stats() const {
+    return counters;
+}
+
+void PPURenderer::renderFrame(const PPUWrite *log, size_t count, uint8_t *pixels) {
+    INSTRUMENT_ZONE(zoneRender);
+    if (pixels && pixels != lastPixels) {
+        std::fill(keyValid, keyValid + HEIGHT, false);
+        lastPixels = pixels;
+    }
+    next = log;
+    last = log + count;
+    for (int line = 0; line <= PRERENDER; line++) {
+        uint32_t start = line * DOTS;
+        applyUntil(start);
+        if (line < HEIGHT && pixels)
+            renderLine(line, pixels + line * WIDTH);
+        if (line >= HEIGHT && line != PRERENDER)
+            continue;
+        applyUntil(start + 256);
+        if (rendering())
+            incrementY();
+        applyUntil(start + 257);
+        if (rendering())
+            state.v = (state.v & ~0x041F) | (state.t & 0x041F);
+        if (line == PRERENDER) {
+            applyUntil(start + 280);
+            if (rendering())
+                state.v = (state.v & ~0x7BE0) | (state.t & 0x7BE0);
+        }
+    }
+    applyUntil(UINT32_MAX);
+}
+
+// The first eight sprites in OAM order that cover the line
+int PPURenderer::evaluateSprites(int line, int (&found)[8]) {
+    if (!(state.mask & 0x10))
+        return 0;
+    if (spritesStale) {
+        spriteLists.build(state.OAM, state.ctrl & 0x20);
+        spritesStale = false;
+    }
+    int count = spriteLists.count(line);
+    const uint8_t *sprites = spriteLists.sprites(line);
+    for (int i = 0; i < count; i++)
+        found[i] = sprites[i];
+    return count;
+}
+
+// The background reads one coarse Y row, from the nametable v points at
+// and, past a horizontal wrap, its neighbour: both rows' versions count
+void PPURenderer::lineKey(int line, const int (&found)[8], int count, LineKey &key) const {
+    memset(&key, 0, sizeof(key));
+    key.v = state.v;
+    key.fineX = state.fineX;
+    key.ctrl = state.ctrl;
+    key.mask = state.mask;
+    key.spriteCount = count;
+    for (int i = 0; i < count; i++)
+        memcpy(key.sprites + i * 4, state.OAM + found[i] * 4, 4);
+    int row = (state.v >> 5) & 0x1F;
+    uint16_t table = nametableAddr(0x2000 | (state.v & 0x0C00)) >> 10;
+    uint16_t neighbour = nametableAddr(0x2000 | ((state.v ^ 0x0400) & 0x0C00)) >> 10;
+    key.rowVersions[0] = rowVersions[table][row];
+    key.rowVersions[1] = rowVersions[neighbour][row];
+    key.paletteVersion = paletteVersion;
+    key.CHRVersion = CHRVersion;
+}
+
+void PPURenderer::renderLine(int line, uint8_t *pixels) {
+    int found[8];
+    int count = evaluateSprites(line, found);
+    if (!reuse) {
+        drawLine(line, found, count, pixels);
+        counters.linesDrawn++;
+        return;
+    }
+
+    LineKey key;
+    lineKey(line, found, count, key);
+    if (keyValid[line] && memcmp(&key, &keys[line], sizeof(key)) == 0) {
+        counters.linesReused++;
+        if (verify) {
+            uint8_t scratch[WIDTH];
+            drawLine(line, found, count, scratch);
+            if (memcmp(scratch, pixels, WIDTH) != 0)
+                counters.reuseMismatches++;
+        }
+        return;
+    }
+    drawLine(line, found, count, pixels);
+    counters.linesDrawn++;
+    keys[line] = key;
+    keyValid[line] = true;
+}
+
+// Background into a line buffer at fine X, sprites into another with
+// their priority, then both through the palette
+void PPURenderer::drawLine(int line, const int (&found)[8], int count, uint8_t *pixels) const {
+    uint8_t background[WIDTH + 16] = {};
+    uint8_t sprites[WIDTH] = {};
+    bool behind[WIDTH] = {};
+
+    if (state.mask & 0x08) {
+        uint16_t v = state.v;
+        uint16_t table = (state.ctrl & 0x10) ? 0x1000 : 0;
+        int fineY = (v >> 12) & 7;
+        for (int tile = 0; tile < 33; tile++) {
+            uint8_t index = state.nametables[nametableAddr(0x2000 | (v & 0x0FFF))];
+            uint8_t attribute = state.nametables[nametableAddr(0x23C0 | (v & 0x0C00) | ((v >> 4) & 0x38) | ((v >> 2) & 0x07))];
+            int palette = (attribute >> (((v >> 4) & 4) | (v & 2))) & 3;
+            uint8_t low = state.CHR[table + index * 16 + fineY];
+            uint8_t high = state.CHR[table + index * 16 + fineY + 8];
+            uint8_t *out = background + tile * 8;
+            for (int bit = 0; bit < 8; bit++) {
+                int pixel = ((low >> (7 - bit)) & 1) | (((high >> (7 - bit)) & 1) << 1);
+                out[bit] = pixel ? (palette << 2 | pixel) : 0;
+            }
+            // Coarse X, wrapping into the horizontally adjacent nametable
+            if ((v & 0x1F) == 31)
+                v = (v & ~0x1F) ^ 0x0400;
+            else
+                v++;
+        }
+        if (!(state.mask & 0x02))
+            memset(background + state.fineX, 0, 8);
+    }
+
+    // Sprites drawn in reverse so the lowest index wins
+    if (state.mask & 0x10) {
+        int height = (state.ctrl & 0x20) ? 16 : 8;
+        for (int i = count - 1; i >= 0; i--) {
+            const uint8_t *entry = state.OAM + found[i] * 4;
+            uint8_t index = entry[1];
+            uint8_t attributes = entry[2];
+            int row = line - 1 - entry[0];
+            if (attributes & 0x80)
+                row = height - 1 - row;
+            uint16_t addr;
+            if (height == 16)
+                addr = ((index & 1) ? 0x1000 : 0) + (index & 0xFE) * 16 + (row & 8) * 2 + (row & 7);
+            else
+                addr = ((state.ctrl & 0x08) ? 0x1000 : 0) + index * 16 + row;
+            uint8_t low = state.CHR[addr];
+            uint8_t high = state.CHR[addr + 8];
+            for (int bit = 0; bit < 8; bit++) {
+                int x = entry[3] + bit;
+                if (x >= WIDTH)
+                    break;
+                int shift = (attributes & 0x40) ? bit : 7 - bit;
+                int pixel = ((low >> shift) & 1) | (((high >> shift) & 1) << 1);
+                if (!pixel || (x < 8 && !(state.mask & 0x04)))
+                    continue;
+                sprites[x] = 0x10 | (attributes & 3) << 2 | pixel;
+                behind[x] = attributes & 0x20;
+            }
+        }
+    }
+
+    uint8_t grey = (state.mask & 0x01) ? 0x30 : 0x3F;
+    const uint8_t *shifted = background + state.fineX;
+    for (int x = 0; x < WIDTH; x++) {
+        uint8_t colour = shifted[x];
+        if (sprites[x] && (!colour || !behind[x]))
+            colour = sprites[x];
+        pixels[x] = state.palette[colour] & grey;
+    }
+}
@@ -0,0 +1,178 @@
+#include <Profiler.h>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+
+static const uint8_t OPBRK = 0x00;
+static const uint8_t OPJSR = 0x20;
+static const uint8_t OPRTI = 0x40;
+static const uint8_t OPRTS = 0x60;
+
+Profiler::Profiler() {
+    clear();
+}
+
+void Profiler::clear() {
+    counters.assign(0x10000, Counter{0, 0});
+    nodes.clear();
+    children.clear();
+    stack.clear();
+    nodes.push_back({-1, 0, frameRoot, 1, 0, 0});
+    stack.push_back({0, 0xFF});
+    top = &nodes[0];
+    started = false;
+    interrupted = false;
+}
+
+void Profiler::followCall(uint16_t PC, uint8_t SP) {
+    switch (lastOpcode) {
+        case OPJSR:
+            call(PC, SP + 2, frameJSR);
+            break;
+        case OPBRK:
+            call(PC, SP + 3, frameBRK);
+            break;
+        case OPRTS:
+        case OPRTI:
+            ret(SP);
+            break;
+    }
+}
+
+// The interrupt sequence itself is counted against the handler's first instruction
+void Profiler::interrupt(uint16_t PC, uint8_t SP, FrameKind kind) {
+    if (kind == frameReset) {
+        stack.resize(1);
+        top = &nodes[0];
+        call(PC, SP, frameReset);
+    }
+    else {
+        call(PC, SP + 3, kind);
+    }
+    interrupted = true;
+    lastPC = PC;
+}
+
+void Profiler::call(uint16_t entry, uint8_t returnSP, FrameKind kind) {
+    if (stack.size() >= MAXDEPTH)
+        return;
+    int node = child(stack.back().node, entry, kind);
+    nodes[node].calls++;
+    stack.push_back({node, returnSP});
+    top = &nodes[node];
+}
+
+// Pops every frame the stack pointer has moved past, so code that discards
+// return addresses (jump tables built on PLA/PLA/JMP) doesn't leave stale frames
+void Profiler::ret(uint8_t SP) {
+    while (stack.size() > 1 && nodes[stack.back().node].kind != frameReset && stack.back().returnSP <= SP) {
+        stack.pop_back();
+    }
+    top = &nodes[stack.back().node];
+}
+
+int Profiler::child(int parent, uint16_t entry, FrameKind kind) {
+    uint64_t key = ((uint64_t)parent << 24) | ((uint64_t)kind << 16) | entry;
+    auto found = children.find(key);
+    if (found != children.end())
+        return found->second;
+    nodes.push_back({parent, entry, kind, 0, 0, 0});
+    children[key] = nodes.size() - 1;
+    return nodes.size() - 1;
+}
+
+std::string Profiler::frameName(const Node &node) {
+    static const char *kinds[] = {"root", "", "BRK@", "IRQ@", "NMI@", "RESET@"};
+    if (node.kind == frameRoot)
+        return kinds[frameRoot];
+    std::stringstream name;
+    name << kinds[node.kind] << "$" << std::setw(4) << std::setfill('0') << std::hex << std::uppercase << node.entry;
+    return name.str();
+}
+
+void Profiler::report(std::ostream &out, size_t top) {
+    uint64_t total = 0;
+    std::vector<int> hot;
+    for (int pc = 0; pc < 0x10000; pc++) {
+        if (counters[pc].instructions) {
+            hot.push_back(pc);
+            total += counters[pc].cycles;
+        }
+    }
+    if (total == 0) {
+        out << "No instructions profiled\n";
+        return;
+    }
+
+    size_t shown = std::min(top, hot.size());
+    std::partial_sort(hot.begin(), hot.begin() + shown, hot.end(),
+                      [&](int a, int b) { return counters[a].cycles > counters[b].cycles; });
+    out << "Hot instructions\n"
+        << "  PC     instructions        cycles       %\n";
+    for (size_t i = 0; i < shown; i++) {
+        int pc = hot[i];
+        out << "  $" << std::setw(4) << std::setfill('0') << std::hex << std::uppercase << pc << std::dec << std::setfill(' ')
+            << std::setw(15) << counters[pc].instructions << std::setw(14) << counters[pc].cycles
+            << std::setw(8) << std::fixed << std::setprecision(2) << 100.0 * counters[pc].cycles / total << "\n";
+    }
+
+    // Inclusive cycles per call tree node, children always come after their parent
+    std::vector<uint64_t> inclusive(nodes.size());
+    for (size_t n = 0; n < nodes.size(); n++)
+        inclusive[n] = nodes[n].cycles;
+    for (size_t n = nodes.size() - 1; n > 0; n--)
+        inclusive[nodes[n].parent] += inclusive[n];
+
+    // Merge the tree by subroutine, recursive frames only count once
+    struct Subroutine
+    {
+        std::string name;
+        uint64_t calls = 0;
+        uint64_t self = 0;
+        uint64_t inclusive = 0;
+    };
+    std::unordered_map<std::string, Subroutine> subroutines;
+    for (size_t n = 1; n < nodes.size(); n++) {
+        std::string name = frameName(nodes[n]);
+        Subroutine &sub = subroutines[name];
+        sub.name = name;
+        sub.calls += nodes[n].calls;
+        sub.self += nodes[n].cycles;
+        bool nested = false;
+        for (int p = nodes[n].parent; p > 0 && !nested; p = nodes[p].parent)
+            nested = nodes[p].entry == nodes[n].entry && nodes[p].kind == nodes[n].kind;
+        if (!nested)
+            sub.inclusive += inclusive[n];
+    }
+    std::vector<Subroutine> sorted;
+    for (auto &entry : subroutines)
+        sorted.push_back(entry.second);
+    shown = std::min(top, sorted.size());
+    std::partial_sort(sorted.begin(), sorted.begin() + shown, sorted.end(),
+                      [](const Subroutine &a, const Subroutine &b) { return a.inclusive > b.inclusive; });
+    out << "Subroutines\n"
+        << "  entry              calls   self cycles   incl cycles  self %  incl %\n";
+    for (size_t i = 0; i < shown; i++) {
+        const Subroutine &sub = sorted[i];
+        out << "  " << std::left << std::setw(12) << sub.name << std::right
+            << std::setw(12) << sub.calls << std::setw(14) << sub.self << std::setw(14) << sub.inclusive
+            << std::setw(8) << 100.0 * sub.self / total << std::setw(8) << 100.0 * sub.inclusive / total << "\n";
+    }
+    out << total << " cycles profiled\n" << std::defaultfloat;
+}
+
+void Profiler::writeCollapsed(std::ostream &out) {
+    for (size_t n = 0; n < nodes.size(); n++) {
+        if (nodes[n].cycles == 0)
+            continue;
+        std::vector<std::string> path;
+        for (int p = n; p > 0; p = nodes[p].parent)
+            path.push_back(frameName(nodes[p]));
+        if (path.empty())
+            path.push_back(frameName(nodes[0]));
+        for (size_t i = path.size(); i > 0; i--)
+            out << path[i - 1] << (i > 1 ? ";" : " ");
+        out << nodes[n].cycles << "\n";
+    }
+}
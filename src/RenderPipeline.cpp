@@ -0,0 +1,134 @@
+#include <RenderPipeline.h>
+#include <Hash.h>
+#include <algorithm>
+
+RenderPipeline::RenderPipeline(const PPUInputs &start, bool threaded) : threaded(threaded), hash(HASHSEED) {
+    renderer.load(start);
+    for (auto &log : logs)
+        log.reserve(LOGRESERVE);
+    std::fill(frame, frame + sizeof(frame), 0);
+    if (threaded)
+        worker = std::thread(&RenderPipeline::renderLoop, this);
+}
+
+RenderPipeline::~RenderPipeline() {
+    if (threaded) {
+        stopping = true;
+        notify();
+        worker.join();
+    }
+}
+
+std::vector<PPUWrite> *RenderPipeline::log() {
+    return &logs[submitted % LOGS];
+}
+
+void RenderPipeline::submit() {
+    uint64_t n = submitted;
+    draw[n % LOGS] = requested || (every > 0 && n % every == 0);
+    requested = false;
+    if (!threaded) {
+        render(n);
+        submitted = n + 1;
+        rendered = n + 1;
+        return;
+    }
+    // The next log is still in the ring until the frame LOGS before is done
+    waitFor([&] { return n + 1 - rendered < LOGS; });
+    submitted = n + 1;
+    notify();
+}
+
+void RenderPipeline::setSkip(int every) {
+    this->every = every < 0 ? 0 : every;
+}
+
+void RenderPipeline::request() {
+    requested = true;
+}
+
+void RenderPipeline::setLineReuse(bool enabled, bool verify) {
+    flush();
+    renderer.setLineReuse(enabled, verify);
+}
+
+PPURenderer::Stats RenderPipeline::stats() {
+    flush();
+    return renderer.stats();
+}
+
+void RenderPipeline::flush() {
+    waitFor([&] { return rendered == submitted; });
+}
+
+void RenderPipeline::restart(const PPUInputs &start) {
+    flush();
+    log()->clear();
+    renderer.load(start);
+}
+
+const uint8_t *RenderPipeline::pixels() const {
+    return frame;
+}
+
+uint64_t RenderPipeline::framesRendered() const {
+    return rendered;
+}
+
+uint64_t RenderPipeline::framesDrawn() const {
+    return drawn;
+}
+
+uint64_t RenderPipeline::checksum() const {
+    return hash;
+}
+
+void RenderPipeline::render(uint64_t n) {
+    std::vector<PPUWrite> &log = logs[n % LOGS];
+    if (draw[n % LOGS]) {
+        renderer.renderFrame(log.data(), log.size(), frame);
+        hash = hashBytes(hash, frame, sizeof(frame));
+        drawn++;
+    }
+    else {
+        renderer.renderFrame(log.data(), log.size(), nullptr);
+    }
+    log.clear();
+}
+
+void RenderPipeline::renderLoop() {
+    while (true) {
+        waitFor([&] { return stopping || rendered < submitted; });
+        if (rendered == submitted)
+            return;
+        uint64_t n = rendered;
+        render(n);
+        rendered = n + 1;
+        notify();
+    }
+}
+
+// Spin briefly, a frame is usually close, then sleep. Both counters are
+// sequentially consistent, so either the waker sees the sleeper or the
+// sleeper's check under the lock sees the new count
+template<typename Ready>
+void RenderPipeline::waitFor(Ready ready) {
+    for (int i = 0; i < SPINS; i++) {
+        if (ready())
+            return;
+        std::this_thread::yield();
+    }
+    sleepers++;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        wake.wait(lock, ready);
+    }
+    sleepers--;
+}
+
+void RenderPipeline::notify() {
+    if (sleepers > 0) {
+        std::lock_guard<std::mutex> lock(mutex);
+        wake.notify_all();
+    }
+}
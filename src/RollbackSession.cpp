@@ -0,0 +1,235 @@
+#include <RollbackSession.h>
+#include <chrono>
+#include <cstring>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Packet: magic, first frame and count of the sender's inputs, the
+// inputs, the frames of ours it knows, then the newest frame it has a
+// final checksum for, plus one (0 for none), and that checksum
+static const size_t HEADERSIZE = 2 + 4 + 1;
+static const size_t TRAILERSIZE = 4 + 4 + 8;
+
+static void put(std::vector<uint8_t> &bytes, uint64_t value, int size) {
+    for (int i = 0; i < size; i++)
+        bytes.push_back(value >> (8 * i));
+}
+
+static uint64_t get(const uint8_t *bytes, int size) {
+    uint64_t value = 0;
+    for (int i = 0; i < size; i++)
+        value |= (uint64_t)bytes[i] << (8 * i);
+    return value;
+}
+
+RollbackSession::RollbackSession(Controller &console, int player, int maxRollback)
+    : console(console), player(player & 1),
+      maxRollback(maxRollback < 0 ? 0 : (maxRollback > MAXROLLBACK ? MAXROLLBACK : maxRollback)),
+      states(this->maxRollback + 2) {
+    console.setRenderSkip(0);
+    console.setRendering(Controller::renderSerial);
+}
+
+RollbackSession::~RollbackSession() {
+    if (socket >= 0)
+        close(socket);
+}
+
+bool RollbackSession::open(int localPort, int remotePort, const char *remoteHost) {
+    socket = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (socket < 0)
+        return false;
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(localPort);
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    remote.sin_family = AF_INET;
+    remote.sin_port = htons(remotePort);
+    if (bind(socket, (sockaddr *)&address, sizeof(address)) < 0 || inet_pton(AF_INET, remoteHost, &remote.sin_addr) != 1) {
+        close(socket);
+        socket = -1;
+        return false;
+    }
+    return true;
+}
+
+void RollbackSession::setConditions(const Conditions &conditions) {
+    this->conditions = conditions;
+    rng.seed(conditions.seed);
+}
+
+bool RollbackSession::advance(uint8_t buttons) {
+    auto start = std::chrono::steady_clock::now();
+    polls++;
+    receive();
+    rollback();
+    if (current + 1 > remoteKnown + maxRollback) {
+        counters.stalls++;
+        send();
+        return false;
+    }
+    localInputs[current % WINDOW] = buttons;
+    console.saveState(states[current % states.size()]);
+    runFrame(current, true);
+    current++;
+    checkHash();
+    send();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (seconds > counters.slowestAdvance)
+        counters.slowestAdvance = seconds;
+    return true;
+}
+
+void RollbackSession::poll() {
+    polls++;
+    receive();
+    rollback();
+    checkHash();
+    send();
+}
+
+uint64_t RollbackSession::frame() const {
+    return current;
+}
+
+uint64_t RollbackSession::confirmedFrame() const {
+    return remoteKnown < current ? remoteKnown : current;
+}
+
+int64_t RollbackSession::checkedFrame() const {
+    return checked;
+}
+
+bool RollbackSession::desynced() const {
+    return desync;
+}
+
+uint64_t RollbackSession::desyncFrame() const {
+    return desyncAt;
+}
+
+const RollbackSession::Stats &RollbackSession::stats() const {
+    return counters;
+}
+
+// The peer's last known input, held
+uint8_t RollbackSession::predicted() const {
+    return remoteKnown ? remoteInputs[(remoteKnown - 1) % WINDOW] : 0;
+}
+
+void RollbackSession::runFrame(uint64_t frame, bool draw) {
+    uint8_t remoteButtons = frame < remoteKnown ? remoteInputs[frame % WINDOW] : predicted();
+    used[frame % WINDOW] = remoteButtons;
+    console.setButtons(player, localInputs[frame % WINDOW]);
+    console.setButtons(player ^ 1, remoteButtons);
+    if (draw)
+        console.requestFrame();
+    console.runFrame();
+    hashes[frame % WINDOW] = console.checksum();
+}
+
+void RollbackSession::receive() {
+    uint8_t buffer[HEADERSIZE + MAXINPUTS + TRAILERSIZE];
+    while (true) {
+        ssize_t size = recv(socket, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (size < 0)
+            return;
+        if (size < (ssize_t)(HEADERSIZE + TRAILERSIZE) || get(buffer, 2) != MAGIC)
+            continue;
+        uint64_t first = get(buffer + 2, 4);
+        int count = buffer[6];
+        if (count > MAXINPUTS || size != (ssize_t)(HEADERSIZE + count + TRAILERSIZE))
+            continue;
+        counters.received++;
+        const uint8_t *trailer = buffer + HEADERSIZE + count;
+        // Only inputs that continue the known ones, older packets may
+        // arrive late
+        for (uint64_t frame = first; frame < first + count; frame++) {
+            if (frame != remoteKnown || frame >= current + WINDOW / 2)
+                continue;
+            uint8_t input = buffer[HEADERSIZE + (frame - first)];
+            remoteInputs[frame % WINDOW] = input;
+            if (frame < current && used[frame % WINDOW] != input && frame < firstWrong)
+                firstWrong = frame;
+            remoteKnown++;
+        }
+        uint64_t ack = get(trailer, 4);
+        if (ack > peerAck)
+            peerAck = ack;
+        uint64_t hashFrame = get(trailer + 4, 4);
+        if (hashFrame && (remoteHashFrame == NONE || hashFrame - 1 > remoteHashFrame)) {
+            remoteHashFrame = hashFrame - 1;
+            remoteHash = get(trailer + 8, 8);
+        }
+    }
+}
+
+// Back to the state before the first mispredicted frame, then every frame
+// since again with the inputs known now
+void RollbackSession::rollback() {
+    if (firstWrong == NONE)
+        return;
+    uint64_t from = firstWrong;
+    firstWrong = NONE;
+    console.loadState(states[from % states.size()]);
+    for (uint64_t frame = from; frame < current; frame++) {
+        if (frame != from)
+            console.saveState(states[frame % states.size()]);
+        runFrame(frame, false);
+    }
+    int depth = current - from;
+    counters.rollbacks++;
+    counters.resimulated += depth;
+    if (depth > counters.deepest)
+        counters.deepest = depth;
+}
+
+// The peer's checksum can be compared once the frame is final here too,
+// and while its hash is still in the window
+void RollbackSession::checkHash() {
+    if (remoteHashFrame == NONE || (int64_t)remoteHashFrame <= checked || remoteHashFrame >= confirmedFrame()
+        || current - remoteHashFrame > WINDOW)
+        return;
+    if (hashes[remoteHashFrame % WINDOW] != remoteHash && !desync) {
+        desync = true;
+        desyncAt = remoteHashFrame;
+    }
+    checked = remoteHashFrame;
+}
+
+// Every input the peer hasn't acknowledged goes out again, in as many
+// packets as it takes: the peer only takes the one it's missing next
+void RollbackSession::send() {
+    uint64_t first = peerAck < current ? peerAck : current;
+    uint64_t confirmed = confirmedFrame();
+    do {
+        int count = current - first > MAXINPUTS ? MAXINPUTS : current - first;
+        Packet packet;
+        packet.release = polls + conditions.delay;
+        put(packet.bytes, MAGIC, 2);
+        put(packet.bytes, first, 4);
+        put(packet.bytes, count, 1);
+        for (int i = 0; i < count; i++)
+            packet.bytes.push_back(localInputs[(first + i) % WINDOW]);
+        put(packet.bytes, remoteKnown, 4);
+        put(packet.bytes, confirmed, 4);
+        put(packet.bytes, confirmed ? hashes[(confirmed - 1) % WINDOW] : 0, 8);
+        first += count;
+
+        counters.sent++;
+        if (conditions.loss > 0 && std::uniform_real_distribution<double>(0, 1)(rng) < conditions.loss)
+            counters.dropped++;
+        else
+            outgoing.push_back(std::move(packet));
+    } while (first < current);
+    flush();
+}
+
+void RollbackSession::flush() {
+    while (!outgoing.empty() && outgoing.front().release <= polls) {
+        const std::vector<uint8_t> &bytes = outgoing.front().bytes;
+        sendto(socket, bytes.data(), bytes.size(), 0, (const sockaddr *)&remote, sizeof(remote));
+        outgoing.pop_front();
+    }
+}
@@ -0,0 +1,85 @@
+#include <RunAhead.h>
+
+RunAhead::RunAhead(Controller &console, int frames, Controller *second)
+    : console(console), second(frames > 0 ? second : nullptr), frames(frames), state(new Controller::SaveState()) {
+    console.setRenderSkip(0);
+    console.setRendering(this->second ? Controller::renderOff : Controller::renderSerial);
+    if (this->second) {
+        this->second->setRenderSkip(0);
+        this->second->setRendering(Controller::renderSerial);
+        worker = std::thread(&RunAhead::workerLoop, this);
+    }
+}
+
+RunAhead::~RunAhead() {
+    if (!second)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    worker.join();
+}
+
+void RunAhead::setButtons(int port, uint8_t buttons) {
+    console.setButtons(port, buttons);
+}
+
+void RunAhead::runFrame() {
+    if (frames == 0)
+        console.requestFrame();
+    console.runFrame();
+    if (frames == 0)
+        return;
+    if (!second) {
+        console.saveState(*state);
+        runAhead(console);
+        console.loadState(*state);
+        return;
+    }
+    // The worker is done with the last state once it's idle
+    waitIdle();
+    console.saveState(*state);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending = true;
+    }
+    wake.notify_all();
+}
+
+const uint8_t *RunAhead::framePixels() {
+    if (!second)
+        return console.framePixels();
+    waitIdle();
+    return second->framePixels();
+}
+
+void RunAhead::runAhead(Controller &from) {
+    for (int i = 0; i < frames; i++) {
+        if (i == frames - 1)
+            from.requestFrame();
+        from.runFrame();
+    }
+}
+
+void RunAhead::waitIdle() {
+    std::unique_lock<std::mutex> lock(mutex);
+    wake.wait(lock, [&] { return !pending; });
+}
+
+// The saved state carries the joypads, buttons included
+void RunAhead::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [&] { return stopping || pending; });
+        if (stopping)
+            return;
+        lock.unlock();
+        second->loadState(*state);
+        runAhead(*second);
+        lock.lock();
+        pending = false;
+        wake.notify_all();
+    }
+}
@@ -0,0 +1,111 @@
+#include <SharedExport.h>
+#include <Controller.h>
+#include <Hash.h>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+SharedExport::~SharedExport() {
+    if (!shared)
+        return;
+    close();
+    munmap(shared, sizeof(SharedFrames));
+    shm_unlink(name.c_str());
+}
+
+bool SharedExport::open(const std::string &name, bool hashed) {
+    int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+    if (fd < 0)
+        return false;
+    if (ftruncate(fd, sizeof(SharedFrames)) != 0) {
+        ::close(fd);
+        return false;
+    }
+    void *mapping = mmap(nullptr, sizeof(SharedFrames), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+        return false;
+    this->name = name;
+    this->hashed = hashed;
+    shared = (SharedFrames *)mapping;
+    // Readers check the magic last, once the rest is valid
+    shared->magic = 0;
+    shared->version = SharedFrames::VERSION;
+    shared->width = PPURenderer::WIDTH;
+    shared->height = PPURenderer::HEIGHT;
+    shared->writer = getpid();
+    shared->latest = 0;
+    shared->published = 0;
+    shared->closed = 0;
+    for (SharedFrames::Slot &slot : shared->slots)
+        slot.sequence = 0;
+    std::atomic_thread_fence(std::memory_order_release);
+    shared->magic = SharedFrames::MAGIC;
+    return true;
+}
+
+void SharedExport::publish(Controller &controller) {
+    SharedFrames::Slot &slot = shared->slots[next];
+    uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    const uint8_t *pixels = controller.framePixels();
+    slot.frame = controller.frame();
+    slot.hasFrame = pixels != nullptr;
+    memcpy(slot.ram, controller.ram(), sizeof(slot.ram));
+    if (pixels)
+        memcpy(slot.pixels, pixels, sizeof(slot.pixels));
+    slot.hash = hashed ? SharedReader::hash(slot) : 0;
+
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+    shared->latest.store(next, std::memory_order_release);
+    shared->published.fetch_add(1, std::memory_order_release);
+    next = (next + 1) % SharedFrames::SLOTS;
+}
+
+void SharedExport::close() {
+    shared->closed.store(1, std::memory_order_release);
+}
+
+SharedReader::~SharedReader() {
+    if (shared)
+        munmap((void *)shared, sizeof(SharedFrames));
+}
+
+bool SharedReader::open(const std::string &name) {
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+        return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(SharedFrames)) {
+        ::close(fd);
+        return false;
+    }
+    void *mapping = mmap(nullptr, sizeof(SharedFrames), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+        return false;
+    const SharedFrames *frames = (const SharedFrames *)mapping;
+    if (frames->magic != SharedFrames::MAGIC || frames->version != SharedFrames::VERSION) {
+        munmap(mapping, sizeof(SharedFrames));
+        return false;
+    }
+    shared = frames;
+    return true;
+}
+
+uint32_t SharedReader::published() const {
+    return shared->published.load(std::memory_order_acquire);
+}
+
+bool SharedReader::closed() const {
+    return shared->closed.load(std::memory_order_acquire);
+}
+
+uint64_t SharedReader::hash(const SharedFrames::Slot &slot) {
+    uint64_t hash = hashBytes(HASHSEED, slot.ram, sizeof(slot.ram));
+    return hashBytes(hash, slot.pixels, sizeof(slot.pixels));
+}
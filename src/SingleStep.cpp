@@ -0,0 +1,369 @@
+#include <SingleStep.h>
+#include <MOS6502.h>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <cstring>
+
+SingleStep::SingleStep(MOS6502 &CPU) : CPU(CPU) {
+    CPU.setLogging(false);
+    memset(memory, 0, sizeof(memory));
+}
+
+void SingleStep::setCheckBus(bool enabled) {
+    checkBus = enabled;
+    CPU.setBusAccurate(enabled);
+}
+
+static std::string hexValue(int value, int width) {
+    std::stringstream stream;
+    stream << std::setw(width) << std::setfill('0') << std::hex << std::uppercase << value;
+    return stream.str();
+}
+
+// Returns an empty string on success, otherwise what differed
+std::string SingleStep::runCase(const testCase &test) {
+    const testState &in = test.initial;
+    const testState &out = test.final;
+
+    for (const MOS6502::memWrite &b : in.ram) {
+        memory[b.addr] = b.value;
+    }
+    CPU.setState({in.PC, in.SP, in.AC, in.X, in.Y, in.SR, 0});
+    writes.clear();
+    bus.clear();
+    CPU.setWriteLog(&writes);
+    if (checkBus)
+        CPU.setBusLog(&bus);
+    CPU.executeOP(memory);
+    CPU.setWriteLog(nullptr);
+    CPU.setBusLog(nullptr);
+    MOS6502::CPUState state = CPU.getState();
+
+    std::stringstream stream;
+    if (state.PC != out.PC)
+        stream << "PC " << hexValue(state.PC, 4) << "!=" << hexValue(out.PC, 4) << " ";
+    if (state.SP != out.SP)
+        stream << "SP " << hexValue(state.SP, 2) << "!=" << hexValue(out.SP, 2) << " ";
+    if (state.AC != out.AC)
+        stream << "A " << hexValue(state.AC, 2) << "!=" << hexValue(out.AC, 2) << " ";
+    if (state.X != out.X)
+        stream << "X " << hexValue(state.X, 2) << "!=" << hexValue(out.X, 2) << " ";
+    if (state.Y != out.Y)
+        stream << "Y " << hexValue(state.Y, 2) << "!=" << hexValue(out.Y, 2) << " ";
+    if (state.SR != out.SR)
+        stream << "SR " << hexValue(state.SR, 2) << "!=" << hexValue(out.SR, 2) << " ";
+    if (state.totalClk != (int)test.cycles.size())
+        stream << "cycles " << std::dec << state.totalClk << "!=" << test.cycles.size() << " ";
+    for (const MOS6502::memWrite &b : out.ram) {
+        if (memory[b.addr] != b.value) {
+            stream << "$" << hexValue(b.addr, 4) << " " << hexValue(memory[b.addr], 2) << "!=" << hexValue(b.value, 2) << " ";
+        }
+    }
+    if (checkBus) {
+        for (size_t i = 0; i < bus.size() && i < test.cycles.size(); i++) {
+            const MOS6502::busCycle &got = bus[i];
+            const MOS6502::busCycle &want = test.cycles[i];
+            if (got.addr != want.addr || got.value != want.value || got.write != want.write) {
+                stream << "cycle " << std::dec << i + 1 << " " << (got.write ? "W" : "R") << hexValue(got.addr, 4) << "=" << hexValue(got.value, 2)
+                << "!=" << (want.write ? "W" : "R") << hexValue(want.addr, 4) << "=" << hexValue(want.value, 2) << " ";
+                break;
+            }
+        }
+        if (bus.size() != test.cycles.size())
+            stream << "bus cycles " << std::dec << bus.size() << "!=" << test.cycles.size() << " ";
+    }
+
+    // Leave memory zeroed for the next case
+    for (const MOS6502::memWrite &b : in.ram) {
+        memory[b.addr] = 0;
+    }
+    for (const MOS6502::memWrite &b : out.ram) {
+        memory[b.addr] = 0;
+    }
+    for (const MOS6502::memWrite &b : writes) {
+        memory[b.addr] = 0;
+    }
+    return stream.str();
+}
+
+bool SingleStep::runFile(const std::string &path, int opcode) {
+    FILE *file = fopen(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+
+    opcodeResult &result = results[opcode];
+    result.present = true;
+
+    JsonReader reader(file);
+    testCase test;
+    while (reader.nextCase(test)) {
+        std::string failure = runCase(test);
+        if (failure.empty()) {
+            result.passed++;
+        }
+        else {
+            if (result.failed == 0) {
+                result.firstFailure = test.name + ": " + failure;
+            }
+            result.failed++;
+        }
+    }
+    if (reader.failed() && result.firstFailure.empty()) {
+        result.failed++;
+        result.firstFailure = "malformed JSON in " + path;
+    }
+    fclose(file);
+    return result.failed == 0;
+}
+
+bool SingleStep::runDirectory(const std::string &dir) {
+    bool passed = true;
+    for (int opcode = 0; opcode < 256; opcode++) {
+        std::string name = hexValue(opcode, 2);
+        for (char &c : name) {
+            c = tolower(c);
+        }
+        if (!runFile(dir + "/" + name + ".json", opcode) && results[opcode].present) {
+            passed = false;
+        }
+    }
+    return passed;
+}
+
+// Pass/fail matrix, rows are the high nibble of the opcode:
+// '.' all cases passed, 'X' failures, '-' no vector file
+void SingleStep::report(std::ostream &out) {
+    long passed = 0;
+    long failed = 0;
+    out << "    0 1 2 3 4 5 6 7 8 9 A B C D E F\n";
+    for (int row = 0; row < 16; row++) {
+        out << std::hex << std::uppercase << row << "_  ";
+        for (int col = 0; col < 16; col++) {
+            opcodeResult &result = results[row * 16 + col];
+            passed += result.passed;
+            failed += result.failed;
+            out << (!result.present ? '-' : result.failed ? 'X' : '.') << " ";
+        }
+        out << "\n";
+    }
+    out << std::dec << passed << " passed, " << failed << " failed\n";
+    for (int opcode = 0; opcode < 256; opcode++) {
+        opcodeResult &result = results[opcode];
+        if (result.failed) {
+            out << "  " << hexValue(opcode, 2) << ": " << std::dec << result.failed << " failed, first "
+            << result.firstFailure << "\n";
+        }
+    }
+}
+
+SingleStep::JsonReader::JsonReader(FILE *file) : file(file) {}
+
+int SingleStep::JsonReader::peek() {
+    if (pos == len) {
+        len = fread(buffer, 1, sizeof(buffer), file);
+        pos = 0;
+        if (len == 0)
+            return EOF;
+    }
+    return (unsigned char)buffer[pos];
+}
+
+int SingleStep::JsonReader::get() {
+    int c = peek();
+    if (c != EOF)
+        pos++;
+    return c;
+}
+
+void SingleStep::JsonReader::skipSpace() {
+    while (true) {
+        int c = peek();
+        if (c != ' ' && c != '\n' && c != '\r' && c != '\t')
+            return;
+        pos++;
+    }
+}
+
+bool SingleStep::JsonReader::expect(char c) {
+    skipSpace();
+    if (get() != c) {
+        error = true;
+        return false;
+    }
+    return true;
+}
+
+std::string SingleStep::JsonReader::parseString() {
+    std::string value;
+    if (!expect('"'))
+        return value;
+    int c;
+    while ((c = get()) != '"') {
+        if (c == EOF) {
+            error = true;
+            break;
+        }
+        if (c == '\\')
+            c = get();
+        value += (char)c;
+    }
+    return value;
+}
+
+long SingleStep::JsonReader::parseNumber() {
+    skipSpace();
+    long value = 0;
+    bool negative = false;
+    if (peek() == '-') {
+        negative = true;
+        pos++;
+    }
+    if (peek() < '0' || peek() > '9') {
+        error = true;
+        return 0;
+    }
+    while (peek() >= '0' && peek() <= '9') {
+        value = value * 10 + (get() - '0');
+    }
+    return negative ? -value : value;
+}
+
+void SingleStep::JsonReader::skipValue() {
+    skipSpace();
+    int c = peek();
+    if (c == '"') {
+        parseString();
+    }
+    else if (c == '{' || c == '[') {
+        char close = c == '{' ? '}' : ']';
+        pos++;
+        skipSpace();
+        if (peek() == close) {
+            pos++;
+            return;
+        }
+        do {
+            if (close == '}') {
+                parseString();
+                expect(':');
+            }
+            skipValue();
+            skipSpace();
+        } while (!error && peek() == ',' && get());
+        expect(close);
+    }
+    else {
+        // Numbers, true, false, null
+        while (c != EOF && c != ',' && c != '}' && c != ']' && c != ' ' && c != '\n') {
+            pos++;
+            c = peek();
+        }
+    }
+}
+
+void SingleStep::JsonReader::parseState(testState &state) {
+    state.ram.clear();
+    expect('{');
+    do {
+        std::string key = parseString();
+        expect(':');
+        if (key == "pc")
+            state.PC = parseNumber();
+        else if (key == "s")
+            state.SP = parseNumber();
+        else if (key == "a")
+            state.AC = parseNumber();
+        else if (key == "x")
+            state.X = parseNumber();
+        else if (key == "y")
+            state.Y = parseNumber();
+        else if (key == "p")
+            state.SR = parseNumber();
+        else if (key == "ram") {
+            expect('[');
+            skipSpace();
+            while (!error && peek() == '[') {
+                pos++;
+                uint16_t addr = parseNumber();
+                expect(',');
+                uint8_t value = parseNumber();
+                expect(']');
+                state.ram.push_back({addr, value});
+                skipSpace();
+                if (peek() == ',') {
+                    pos++;
+                    skipSpace();
+                }
+            }
+            expect(']');
+        }
+        else
+            skipValue();
+        skipSpace();
+    } while (!error && peek() == ',' && get());
+    expect('}');
+}
+
+void SingleStep::JsonReader::parseCycles(std::vector<MOS6502::busCycle> &cycles) {
+    cycles.clear();
+    expect('[');
+    skipSpace();
+    while (!error && peek() == '[') {
+        pos++;
+        MOS6502::busCycle cycle;
+        cycle.addr = parseNumber();
+        expect(',');
+        cycle.value = parseNumber();
+        expect(',');
+        cycle.write = parseString() == "write";
+        expect(']');
+        cycles.push_back(cycle);
+        skipSpace();
+        if (peek() == ',') {
+            pos++;
+            skipSpace();
+        }
+    }
+    expect(']');
+}
+
+// Reads the next element of the top level array, false at its end or on error
+bool SingleStep::JsonReader::nextCase(testCase &test) {
+    skipSpace();
+    if (!started) {
+        started = true;
+        if (!expect('['))
+            return false;
+        skipSpace();
+        if (peek() == ']')
+            return false;
+    }
+    else {
+        int c = get();
+        if (c != ',') {
+            error = c != ']';
+            return false;
+        }
+    }
+
+    expect('{');
+    do {
+        std::string key = parseString();
+        expect(':');
+        if (key == "name")
+            test.name = parseString();
+        else if (key == "initial")
+            parseState(test.initial);
+        else if (key == "final")
+            parseState(test.final);
+        else if (key == "cycles")
+            parseCycles(test.cycles);
+        else
+            skipValue();
+        skipSpace();
+    } while (!error && peek() == ',' && get());
+    expect('}');
+    return !error;
+}
@@ -0,0 +1,33 @@
+#include <SpriteLists.h>
+#include <cstring>
+
+// Sprites show from the line after their Y, evaluated on the line before
+void SpriteLists::build(const uint8_t (&OAM)[256], bool tall) {
+    int height = tall ? 16 : 8;
+    memset(counts, 0, sizeof(counts));
+    memset(overflows, 0, sizeof(overflows));
+    for (int sprite = 0; sprite < 64; sprite++) {
+        int top = OAM[sprite * 4] + 1;
+        for (int line = top; line < top + height && line < LINES; line++) {
+            if (counts[line] < MAXSPRITES)
+                indices[line][counts[line]++] = sprite;
+        }
+    }
+
+    overflowLine = -1;
+    for (int line = 0; line < LINES; line++) {
+        if (counts[line] < MAXSPRITES)
+            continue;
+        int m = 0;
+        for (int n = indices[line][MAXSPRITES - 1] + 1; n < 64; n++) {
+            int row = line - 1 - OAM[n * 4 + m];
+            if (row >= 0 && row < height) {
+                overflows[line] = true;
+                break;
+            }
+            m = (m + 1) & 3;
+        }
+        if (overflows[line] && overflowLine < 0)
+            overflowLine = line;
+    }
+}
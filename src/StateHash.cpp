@@ -0,0 +1,46 @@
+#include <StateHash.h>
+#include <Hash.h>
+
+StateHash::StateHash() {
+    hashMask();
+}
+
+void StateHash::mask(uint16_t first, uint16_t last, bool masked) {
+    for (uint32_t addr = first; addr <= last && addr < SIZE; addr++)
+        excluded[addr] = masked;
+    hashMask();
+}
+
+uint64_t StateHash::maskID() const {
+    return maskHash;
+}
+
+void StateHash::hashMask() {
+    uint64_t id = HASHSEED;
+    for (uint32_t addr = 0; addr < SIZE; addr += 64) {
+        uint64_t word = 0;
+        for (int bit = 0; bit < 64; bit++)
+            word |= (uint64_t)excluded[addr + bit] << bit;
+        id = hashValue(id, word);
+    }
+    maskHash = id;
+}
+
+void StateHash::clear() {
+    hash = 0;
+}
+
+void StateHash::add(uint16_t addr, const uint8_t *data, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        if (!excluded[addr + i])
+            hash ^= key(addr + i, data[i]);
+    }
+}
+
+uint64_t StateHash::value() const {
+    return hash;
+}
+
+void StateHash::set(uint64_t value) {
+    hash = value;
+}
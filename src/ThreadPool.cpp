@@ -0,0 +1,63 @@
+#include <ThreadPool.h>
+
+ThreadPool::ThreadPool(int workers) {
+    for (int i = 0; i < workers; i++)
+        this->workers.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread &worker : workers)
+        worker.join();
+}
+
+int ThreadPool::threads() const {
+    return workers.size() + 1;
+}
+
+void ThreadPool::run(int count, const std::function<void(int)> &job) {
+    if (workers.empty() || count <= 1) {
+        for (int i = 0; i < count; i++)
+            job(i);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->job = &job;
+        this->count = count;
+        next = 0;
+        active = workers.size();
+        batch++;
+    }
+    wake.notify_all();
+    runJobs();
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&] { return active == 0; });
+    this->job = nullptr;
+}
+
+void ThreadPool::runJobs() {
+    for (int i = next++; i < count; i = next++)
+        (*job)(i);
+}
+
+// A batch only ends once every worker has left it, so none can miss one
+void ThreadPool::workerLoop() {
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [&] { return stopping || batch != seen; });
+        if (stopping)
+            return;
+        seen = batch;
+        lock.unlock();
+        runJobs();
+        lock.lock();
+        if (--active == 0)
+            done.notify_one();
+    }
+}
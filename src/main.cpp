@@ -1,13 +1,46 @@
 #include <Controller.h>
+#include <Lockstep.h>
+#include <SingleStep.h>
+#include <ALUCheck.h>
+#include <Benchmark.h>
+#include <Instrument.h>
+#include <DebugConsole.h>
+#include <Disassembler.h>
+#include <Movie.h>
+#include <SharedExport.h>
+#include <RollbackSession.h>
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <string>
+#include <cstdlib>
+#include <chrono>
+#include <iomanip>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <random>
 
 using namespace std;
 
-int main()
+static bool busAccurate = false;
+static bool idleSkip = false;
+static const char *fusionStats = NULL;
+static Controller::RenderMode rendering = Controller::renderOff;
+static int renderEvery = 1;
+static bool lineReuse = false;
+static bool reuseCheck = false;
+static const size_t FUSEDPAIRS = 64;
+// Seconds a reader waits for the export, milliseconds the export stays after
+static const int EXPORTWAIT = 5;
+static const int EXPORTLINGER = 100;
+// UDP ports of the two netplay consoles, seconds they wait for each other
+static const int NETPLAYPORT = 6510;
+static const int NETPLAYWAIT = 5;
+
+static void openROM(ifstream &romFile, const char *path)
 {
-    ifstream romFile;
-	romFile.open("ROMS/snake.bin", ios::binary);
+	romFile.open(path, ios::binary);
 	if (!romFile) {
 		cout << "File not opened!";
 		exit(1);
@@ -15,6 +48,735 @@ int main()
 	else {
 		cout << "File opened successfully!" << "\n";
 	}
-    Controller controller = Controller(romFile);
-    controller.run();
-}
\ No newline at end of file
+}
+
+static void printRenderStats(Controller &controller)
+{
+	PPURenderer::Stats stats = controller.renderStats();
+	cout << "Render checksum " << hex << controller.renderChecksum() << dec << ", " << stats.linesDrawn
+		 << " lines drawn, " << stats.linesReused << " reused";
+	if (reuseCheck)
+		cout << ", " << stats.reuseMismatches << " reused lines differ";
+	cout << "\n";
+}
+
+// The engines differ in how they reach memory: the reference takes the
+// direct path, the candidate the bus-accurate one with its dummy cycles.
+// Two identically configured cores could never disagree. False, with a
+// message, for --bus-accurate, which would have nothing left to switch
+static bool differentialPair(MOS6502 &reference, MOS6502 &candidate)
+{
+	if (busAccurate) {
+		cout << "--bus-accurate doesn't apply here: the candidate is always bus-accurate, the reference never\n";
+		return false;
+	}
+	reference.setBusAccurate(false);
+	candidate.setBusAccurate(true);
+	return true;
+}
+
+// NES --fuzz [iterations] [seed]
+static int fuzz(int argc, char *argv[])
+{
+	int iterations = argc > 2 ? atoi(argv[2]) : 1000;
+	uint32_t seed = argc > 3 ? strtoul(argv[3], NULL, 0) : 1;
+
+	MOS6502 reference;
+	MOS6502 candidate;
+	if (!differentialPair(reference, candidate))
+		return 1;
+	Lockstep lockstep(reference, candidate);
+	bool passed = lockstep.fuzz(iterations, seed);
+	lockstep.report(cout);
+	return passed ? 0 : 1;
+}
+
+// NES --lockstep <rom> [instructions]
+static int lockstep(int argc, char *argv[])
+{
+	if (argc < 3) {
+		cout << "usage: NES --lockstep <rom> [instructions]\n";
+		return 1;
+	}
+	long instructions = argc > 3 ? atol(argv[3]) : 1000000;
+
+	ifstream romFile;
+	openROM(romFile, argv[2]);
+	static uint8_t image[0x10000];
+	Controller::loadROM(romFile, image);
+
+	MOS6502 reference;
+	MOS6502 candidate;
+	if (!differentialPair(reference, candidate))
+		return 1;
+	Lockstep lockstep(reference, candidate);
+	bool passed = lockstep.run(image, reference.getState(), instructions);
+	lockstep.report(cout);
+	return passed ? 0 : 1;
+}
+
+// NES --singlestep <vector dir> [opcode]
+static int singleStep(int argc, char *argv[])
+{
+	if (argc < 3) {
+		cout << "usage: NES --singlestep <vector dir> [opcode]\n";
+		return 1;
+	}
+	MOS6502 CPU;
+	SingleStep runner(CPU);
+	runner.setCheckBus(busAccurate);
+	bool passed;
+	if (argc > 3) {
+		string name = argv[3];
+		passed = runner.runFile(string(argv[2]) + "/" + name + ".json", strtol(name.c_str(), NULL, 16));
+	}
+	else {
+		passed = runner.runDirectory(argv[2]);
+	}
+	runner.report(cout);
+	return passed ? 0 : 1;
+}
+
+// NES --alu-check
+static int aluCheck()
+{
+	ALUCheck check;
+	bool passed = check.run();
+	check.report(cout);
+	return passed ? 0 : 1;
+}
+
+// NES --headless <rom> [frames] [chrome trace file]
+// Prints a summary line every SUMMARYFRAMES frames, with the host time per
+// zone in instrumented builds
+static const long SUMMARYFRAMES = 60;
+
+static int headless(int argc, char *argv[])
+{
+	if (argc < 3) {
+		cout << "usage: NES --headless <rom> [frames] [chrome trace file]\n";
+		return 1;
+	}
+	long frames = argc > 3 ? atol(argv[3]) : 600;
+
+	ifstream romFile;
+	openROM(romFile, argv[2]);
+	static Controller controller(romFile);
+	static FusionTable fusion;
+	controller.setLogging(false);
+	controller.setBusAccurate(busAccurate);
+	controller.setIdleSkip(idleSkip);
+	controller.setRenderSkip(renderEvery);
+	controller.setLineReuse(lineReuse, reuseCheck);
+	controller.setRendering(rendering);
+	if (fusionStats) {
+		ifstream statsFile(fusionStats);
+		if (!fusion.load(statsFile, FUSEDPAIRS)) {
+			cout << "No opcode pairs in " << fusionStats << "\n";
+			return 1;
+		}
+		controller.setFusion(&fusion);
+	}
+	if (argc > 4)
+		Instrument::startTrace();
+	Instrument::reset();
+
+	auto last = chrono::steady_clock::now();
+	long lastFrame = 0;
+	for (long frame = 1; frame <= frames; frame++) {
+		if (frame == frames)
+			controller.requestFrame();
+		controller.runFrame();
+		if (frame % SUMMARYFRAMES == 0 || frame == frames) {
+			auto now = chrono::steady_clock::now();
+			double seconds = chrono::duration<double>(now - last).count();
+			cout << "frame " << frame << "  " << fixed << setprecision(1)
+				 << (frame - lastFrame) / seconds << " fps  " << defaultfloat;
+			if (fusionStats)
+				cout << controller.fusedInstructions() << " fused  ";
+			if (idleSkip)
+				cout << controller.idleCyclesSkipped() << " idle cycles  ";
+			Instrument::summary(cout);
+			cout << "\n";
+			Instrument::reset();
+			last = now;
+			lastFrame = frame;
+		}
+	}
+	if (rendering != Controller::renderOff)
+		printRenderStats(controller);
+	if (argc > 4) {
+		ofstream trace(argv[4]);
+		Instrument::writeTrace(trace);
+	}
+	return 0;
+}
+
+// NES --profile <rom> [frames] [collapsed stacks file]
+static int profile(int argc, char *argv[])
+{
+	if (argc < 3) {
+		cout << "usage: NES --profile <rom> [frames] [collapsed stacks file]\n";
+		return 1;
+	}
+	long frames = argc > 3 ? atol(argv[3]) : 600;
+
+	ifstream romFile;
+	openROM(romFile, argv[2]);
+	static Controller controller(romFile);
+	static Profiler profiler;
+	controller.setLogging(false);
+	controller.setProfiler(&profiler);
+	for (long i = 0; i < frames; i++)
+		controller.runFrame();
+	profiler.report(cout);
+	if (argc > 4) {
+		ofstream collapsed(argv[4]);
+		profiler.writeCollapsed(collapsed);
+	}
+	return 0;
+}
+
+// NES --stats <rom> [frames] [output.json]
+static int stats(int argc, char *argv[])
+{
+	if (argc < 3) {
+		cout << "usage: NES --stats <rom> [frames] [output.json]\n";
+		return 1;
+	}
+	long frames = argc > 3 ? atol(argv[3]) : 600;
+
+	ifstream romFile;
+	openROM(romFile, argv[2]);
+	static Controller controller(romFile);
+	static OpcodeStats stats;
+	controller.setLogging(false);
+	controller.setStats(&stats);
+	for (long i = 0; i < frames; i++)
+		controller.runFrame();
+	if (argc > 4) {
+		ofstream json(argv[4]);
+		stats.writeJSON(json);
+	}
+	else {
+		stats.writeJSON(cout);
+	}
+	return 0;
+}
+
+// Reads a code/data log sized for the ROM, false when it's missing or
+// doesn't match
+static bool loadCoverage(Coverage &coverage, const char *path)
+{
+	ifstream in(path, ios::binary);
+	return in && coverage.load(in);
+}
+
+// NES --cdl <rom> [frames] [coverage.cdl], merging into an existing log
+static int cdl(int argc, char *argv[])
+{
+	if (argc < 3) {
+		cout << "usage: NES --cdl <rom> [frames] [coverage.cdl]\n";
+		return 1;
+	}
+	long frames = argc > 3 ? atol(argv[3]) : 600;
+
+	ifstream romFile;
+	openROM(romFile, argv[2]);
+	static Controller controller(romFile);
+	const Controller::ROMInfo &info = controller.romInfo();
+	Coverage coverage(info.PRGSize, info.CHRSize);
+	if (argc > 4 && loadCoverage(coverage, argv[4]))
+		cout << "Merging into " << argv[4] << "\n";
+	controller.setLogging(false);
+	controller.setBusAccurate(busAccurate);
+	controller.setCoverage(&coverage);
+	for (long i = 0; i < frames; i++)
+		controller.runFrame();
+	coverage.report(cout);
+	if (argc > 4) {
+		ofstream out(argv[4], ios::binary);
+		coverage.save(out);
+	}
+	return 0;
+}
+
+// NES --cdl-merge <rom> <out.cdl> <in.cdl>...
+static int cdlMerge(int argc, char *argv[])
+{
+	if (argc < 5) {
+		cout << "usage: NES --cdl-merge <rom> <out.cdl> <in.cdl>...\n";
+		return 1;
+	}
+	ifstream romFile;
+	openROM(romFile, argv[2]);
+	static uint8_t image[0x10000];
+	Controller::ROMInfo info = Controller::loadROM(romFile, image);
+	Coverage merged(info.PRGSize, info.CHRSize);
+	for (int i = 4; i < argc; i++) {
+		Coverage coverage(info.PRGSize, info.CHRSize);
+		if (!loadCoverage(coverage, argv[i])) {
+			cout << argv[i] << " doesn't match the ROM\n";
+			return 1;
+		}
+		merged.merge(coverage);
+	}
+	merged.report(cout);
+	ofstream out(argv[3], ios::binary);
+	merged.save(out);
+	return 0;
+}
+
+// The ROM's PRG traced into disassembler, guided by the coverage log at cdl
+// when set. executed gets the PRG bytes the log saw executed
+static bool analyseROM(Disassembler &disassembler, uint8_t (&image)[0x10000], const char *path, const char *cdl,
+		size_t &code, size_t &executed)
+{
+	ifstream romFile;
+	openROM(romFile, path);
+	Controller::ROMInfo info = Controller::loadROM(romFile, image);
+	// Only the first 32KB are mapped, a 16KB PRG at both halves
+	size_t mapped = info.PRGSize < 0x8000 ? info.PRGSize : 0x8000;
+	executed = 0;
+	if (cdl) {
+		Coverage coverage(info.PRGSize, info.CHRSize);
+		if (!loadCoverage(coverage, cdl)) {
+			cout << cdl << " doesn't match the ROM\n";
+			return false;
+		}
+		for (size_t base = 0; mapped && base < 0x8000; base += mapped)
+			disassembler.setCoverage(coverage.PRG(), 0x8000 + base, mapped);
+		for (size_t i = 0; i < coverage.PRGSize(); i++)
+			executed += coverage.PRG()[i] & Coverage::prgCode ? 1 : 0;
+	}
+	// Raw binaries are 16KB at $0000 and start at $0000
+	if (info.iNES) {
+		disassembler.analyse(image);
+		code = disassembler.codeBytes() / (0x8000 / (mapped ? mapped : 0x8000));
+	}
+	else {
+		disassembler.analyse(image, 0x0000, 0x3FFF, {0x0000});
+		code = disassembler.codeBytes();
+	}
+	return true;
+}
+
+// NES --disasm <rom> [listing.s] [coverage.cdl]
+static int disasm(int argc, char *argv[])
+{
+	if (argc < 3) {
+		cout << "usage: NES --disasm <rom> [listing.s] [coverage.cdl]\n";
+		return 1;
+	}
+	static uint8_t image[0x10000];
+	static Disassembler disassembler;
+	size_t code, executed;
+	if (!analyseROM(disassembler, image, argv[2], argc > 4 ? argv[4] : nullptr, code, executed))
+		return 1;
+	if (argc > 3) {
+		ofstream listing(argv[3]);
+		disassembler.writeListing(listing);
+	}
+	else {
+		disassembler.writeListing(cout);
+	}
+	return 0;
+}
+
+// NES --disasm-verify <rom> [coverage.cdl]: the listing has to assemble
+// back to the ROM, and with a log only executed bytes may be code
+static int disasmVerify(int argc, char *argv[])
+{
+	if (argc < 3) {
+		cout << "usage: NES --disasm-verify <rom> [coverage.cdl]\n";
+		return 1;
+	}
+	static uint8_t image[0x10000];
+	static Disassembler disassembler;
+	size_t code, executed;
+	bool guided = argc > 3;
+	if (!analyseROM(disassembler, image, argv[2], guided ? argv[3] : nullptr, code, executed))
+		return 1;
+	ostringstream listing;
+	disassembler.writeListing(listing);
+	bool reassembles = Disassembler::verifyListing(listing.str(), image);
+	cout << code << " bytes traced as code";
+	if (guided)
+		cout << ", " << executed << " executed";
+	cout << "\n" << (reassembles ? "listing assembles back to the ROM\n" : "listing doesn't assemble back to the ROM\n");
+	if (guided && code > executed)
+		cout << "more code than the log saw executed\n";
+	return reassembles && (!guided || code <= executed) ? 0 : 1;
+}
+
+// Binary movies by their magic, anything else is read as FM2
+static unique_ptr<MovieSource> openMovie(ifstream &file, const char *path)
+{
+	file.open(path, ios::binary);
+	char magic[4] = {};
+	file.read(magic, sizeof(magic));
+	file.clear();
+	file.seekg(0);
+	if (string(magic, sizeof(magic)) == string("NMV\x1A", 4))
+		return unique_ptr<MovieSource>(new MovieReader(file));
+	return unique_ptr<MovieSource>(new FM2Reader(file));
+}
+
+// NES --play <rom> <movie> [frames], uncapped, checking the movie's checksums
+// NES --record <rom> <movie> <out.nmv>, the movie's input with checksums,
+// which also imports FM2
+static int movie(int argc, char *argv[])
+{
+	bool record = string(argv[1]) == "--record";
+	if (argc < 4 || (record && argc < 5)) {
+		cout << "usage: NES --play <rom> <movie> [frames] | --record <rom> <movie> <out.nmv>\n";
+		return 1;
+	}
+	long frames = !record && argc > 4 ? atol(argv[4]) : -1;
+
+	ifstream romFile;
+	openROM(romFile, argv[2]);
+	static Controller controller(romFile);
+	controller.setLogging(false);
+	controller.setBusAccurate(busAccurate);
+	controller.setIdleSkip(idleSkip);
+	controller.setRenderSkip(renderEvery);
+	controller.setLineReuse(lineReuse, reuseCheck);
+	controller.setRendering(rendering);
+	ifstream movieFile;
+	unique_ptr<MovieSource> source = openMovie(movieFile, argv[3]);
+	if (!movieFile || !source->valid()) {
+		cout << argv[3] << " is not a supported movie\n";
+		return 1;
+	}
+	MovieReader *binary = dynamic_cast<MovieReader *>(source.get());
+	if (binary && binary->romChecksum() != controller.romChecksum())
+		cout << "Movie was recorded on a different ROM\n";
+
+	ofstream out;
+	unique_ptr<MovieWriter> recorder;
+	if (record) {
+		out.open(argv[4], ios::binary);
+		recorder.reset(new MovieWriter(out, 2, true, controller.romChecksum()));
+	}
+	MoviePlayer player(controller, *source, recorder.get());
+	auto start = chrono::steady_clock::now();
+	while ((frames < 0 || (long)player.frames() < frames) && player.step())
+		;
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	cout << player.frames() << " frames in " << fixed << setprecision(3) << seconds << " s, " << setprecision(1)
+		 << player.frames() / seconds << " fps" << defaultfloat << "\n";
+	if (player.desynced()) {
+		cout << "Desync at frame " << player.frames() << ": expected " << hex << player.expected() << ", got "
+			 << player.actual() << dec << "\n";
+		return 1;
+	}
+	cout << "Checksum " << hex << controller.checksum() << dec << "\n";
+	if (rendering != Controller::renderOff)
+		printRenderStats(controller);
+	return 0;
+}
+
+// NES --export <rom> <name> [frames], uncapped, RAM and frames published
+// to the shared memory segment <name> (e.g. /nes0) after every frame
+static int exportFrames(int argc, char *argv[])
+{
+	if (argc < 4) {
+		cout << "usage: NES --export <rom> <name> [frames]\n";
+		return 1;
+	}
+	long frames = argc > 4 ? atol(argv[4]) : 600;
+
+	ifstream romFile;
+	openROM(romFile, argv[2]);
+	static Controller controller(romFile);
+	controller.setLogging(false);
+	controller.setBusAccurate(busAccurate);
+	controller.setIdleSkip(idleSkip);
+	controller.setRenderSkip(renderEvery);
+	controller.setLineReuse(lineReuse, reuseCheck);
+	controller.setRendering(rendering == Controller::renderOff ? Controller::renderSerial : rendering);
+	SharedExport exporter;
+	if (!exporter.open(argv[3], true)) {
+		cout << "Can't create shared memory segment " << argv[3] << "\n";
+		return 1;
+	}
+	auto start = chrono::steady_clock::now();
+	for (long frame = 0; frame < frames; frame++) {
+		controller.runFrame();
+		exporter.publish(controller);
+	}
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	cout << frames << " frames exported in " << fixed << setprecision(3) << seconds << " s, " << setprecision(1)
+		 << frames / seconds << " fps" << defaultfloat << "\n";
+	exporter.close();
+	// Readers map the segment while it exists, give a slow one time to finish
+	this_thread::sleep_for(chrono::milliseconds(EXPORTLINGER));
+	return 0;
+}
+
+// NES --export-read <name>, until the writer closes: every snapshot is
+// read in place and its hash checked, torn reads are retried
+static int exportRead(int argc, char *argv[])
+{
+	if (argc < 3) {
+		cout << "usage: NES --export-read <name>\n";
+		return 1;
+	}
+	SharedReader reader;
+	auto start = chrono::steady_clock::now();
+	while (!reader.open(argv[2])) {
+		if (chrono::steady_clock::now() - start > chrono::seconds(EXPORTWAIT)) {
+			cout << "No export " << argv[2] << "\n";
+			return 1;
+		}
+		this_thread::sleep_for(chrono::milliseconds(1));
+	}
+
+	uint64_t lastFrame = 0;
+	long snapshots = 0, torn = 0, corrupt = 0;
+	while (true) {
+		bool closed = reader.closed();
+		uint64_t frame = 0;
+		bool intact = false;
+		if (reader.read([&](const SharedFrames::Slot &slot) {
+			frame = slot.frame;
+			intact = SharedReader::hash(slot) == slot.hash;
+		})) {
+			if (frame != lastFrame) {
+				snapshots++;
+				corrupt += !intact;
+				lastFrame = frame;
+			}
+		}
+		else if (reader.published() > 0) {
+			torn++;
+		}
+		if (closed)
+			break;
+		this_thread::yield();
+	}
+	cout << snapshots << " of " << reader.published() << " snapshots read up to frame " << lastFrame << ", " << torn
+		 << " torn reads retried, " << corrupt << " inconsistent\n";
+	return corrupt ? 1 : 0;
+}
+
+// Scripted play for a netplay console: Start once, then random runs,
+// jumps and turns held for up to a quarter second
+static uint8_t netplayInput(mt19937 &rng, long frame, uint8_t &held, long &until)
+{
+	static const uint8_t MOVES[] = {0, Joypad::buttonRight, Joypad::buttonRight | Joypad::buttonB,
+									Joypad::buttonRight | Joypad::buttonA, Joypad::buttonLeft, Joypad::buttonA};
+	if (frame >= 40 && frame < 45)
+		return Joypad::buttonStart;
+	if (frame >= until) {
+		held = MOVES[rng() % sizeof(MOVES)];
+		until = frame + 1 + rng() % 15;
+	}
+	return held;
+}
+
+// NES --netplay <rom> [frames] [delay] [loss %] [max rollback]
+// Two consoles in this process, each on its own thread with a rollback
+// session, playing over UDP loopback with scripted inputs and simulated
+// packet delay (in frames) and loss. Both end on the same frame with the
+// same inputs, so their checksums have to match as well
+static int netplay(int argc, char *argv[])
+{
+	if (argc < 3) {
+		cout << "usage: NES --netplay <rom> [frames] [delay] [loss %] [max rollback]\n";
+		return 1;
+	}
+	long frames = argc > 3 ? atol(argv[3]) : 1200;
+	RollbackSession::Conditions conditions;
+	conditions.delay = argc > 4 ? atoi(argv[4]) : 3;
+	conditions.loss = argc > 5 ? atof(argv[5]) / 100 : 0.05;
+	int maxRollback = argc > 6 ? atoi(argv[6]) : 8;
+	if (maxRollback > RollbackSession::MAXROLLBACK) {
+		maxRollback = RollbackSession::MAXROLLBACK;
+		cout << "Max rollback capped to " << maxRollback << "\n";
+	}
+
+	ifstream romFile;
+	openROM(romFile, argv[2]);
+	unique_ptr<Controller> consoles[2];
+	unique_ptr<RollbackSession> sessions[2];
+	for (int player = 0; player < 2; player++) {
+		romFile.clear();
+		consoles[player].reset(new Controller(romFile));
+		consoles[player]->setLogging(false);
+		consoles[player]->setIdleSkip(idleSkip);
+		sessions[player].reset(new RollbackSession(*consoles[player], player, maxRollback));
+		conditions.seed = player + 1;
+		sessions[player]->setConditions(conditions);
+		if (!sessions[player]->open(NETPLAYPORT + player, NETPLAYPORT + 1 - player)) {
+			cout << "Can't bind UDP port " << NETPLAYPORT + player << "\n";
+			return 1;
+		}
+	}
+
+	atomic<int> finished(0);
+	auto play = [&](int player) {
+		RollbackSession &session = *sessions[player];
+		mt19937 rng(player + 1);
+		uint8_t held = 0;
+		long until = 0;
+		uint8_t buttons = netplayInput(rng, 0, held, until);
+		while ((long)session.frame() < frames) {
+			if (session.advance(buttons))
+				buttons = netplayInput(rng, session.frame(), held, until);
+			else
+				this_thread::yield();
+		}
+		// Until both have every input and the last checksum compared
+		auto deadline = chrono::steady_clock::now() + chrono::seconds(NETPLAYWAIT);
+		bool done = false;
+		while (finished < 2 && chrono::steady_clock::now() < deadline) {
+			session.poll();
+			if (!done && (long)session.confirmedFrame() == frames && session.checkedFrame() == frames - 1) {
+				done = true;
+				finished++;
+			}
+			this_thread::yield();
+		}
+	};
+	auto start = chrono::steady_clock::now();
+	thread other(play, 1);
+	play(0);
+	other.join();
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	cout << frames << " frames in " << fixed << setprecision(3) << seconds << " s, delay " << conditions.delay
+		 << " frames, loss " << setprecision(1) << conditions.loss * 100 << "%, max rollback " << maxRollback
+		 << defaultfloat << "\n";
+	bool failed = finished < 2;
+	for (int player = 0; player < 2; player++) {
+		const RollbackSession::Stats &stats = sessions[player]->stats();
+		cout << "Player " << player + 1 << ": " << stats.rollbacks << " rollbacks, " << stats.resimulated
+			 << " frames resimulated, deepest " << stats.deepest << ", " << stats.stalls << " stalls, "
+			 << stats.dropped << " of " << stats.sent << " packets dropped, slowest frame " << fixed
+			 << setprecision(2) << stats.slowestAdvance * 1000 << " ms" << defaultfloat << ", checked to frame "
+			 << sessions[player]->checkedFrame() << "\n";
+		if (sessions[player]->desynced()) {
+			cout << "Player " << player + 1 << " desynced at frame " << sessions[player]->desyncFrame() << "\n";
+			failed = true;
+		}
+	}
+	uint64_t checksums[2] = {consoles[0]->checksum(), consoles[1]->checksum()};
+	cout << "Checksums " << hex << checksums[0] << " " << checksums[1] << dec << "\n";
+	if (finished < 2)
+		cout << "Sessions didn't finish\n";
+	return failed || checksums[0] != checksums[1] ? 1 : 0;
+}
+
+// NES --bench [results.json] [filter]
+static int bench(int argc, char *argv[])
+{
+	Benchmark benchmark("ROMS");
+	benchmark.run(argc > 3 ? argv[3] : "");
+	benchmark.report(cout);
+	if (argc > 2) {
+		ofstream json(argv[2]);
+		benchmark.writeJSON(json);
+	}
+	return 0;
+}
+
+// NES --debug <rom>, or NES --gdb <rom> [port] for a remote client
+static const int GDBPORT = 6502;
+
+static int debug(int argc, char *argv[])
+{
+	bool remote = string(argv[1]) == "--gdb";
+	if (argc < 3) {
+		cout << "usage: NES --debug <rom> | --gdb <rom> [port]\n";
+		return 1;
+	}
+	ifstream romFile;
+	openROM(romFile, argv[2]);
+	static Controller controller(romFile);
+	static Debugger debugger;
+	controller.setLogging(false);
+	controller.setBusAccurate(busAccurate);
+	controller.attachDebugger(debugger);
+	DebugConsole console(controller, debugger);
+	if (remote)
+		return console.serve(argc > 3 ? atoi(argv[3]) : GDBPORT, cout) ? 0 : 1;
+	console.repl(cin, cout);
+	return 0;
+}
+
+// --bus-accurate, --idle-skip, --fuse <stats.json>, --render
+// <serial|threaded>, --render-every <frames> (0: only the last),
+// --line-reuse and --line-reuse-check may appear anywhere on the command line
+static int stripOptions(int argc, char *argv[])
+{
+	int kept = 1;
+	for (int i = 1; i < argc; i++) {
+		if (string(argv[i]) == "--bus-accurate")
+			busAccurate = true;
+		else if (string(argv[i]) == "--idle-skip")
+			idleSkip = true;
+		else if (string(argv[i]) == "--fuse" && i + 1 < argc)
+			fusionStats = argv[++i];
+		else if (string(argv[i]) == "--render" && i + 1 < argc)
+			rendering = string(argv[++i]) == "threaded" ? Controller::renderThreaded : Controller::renderSerial;
+		else if (string(argv[i]) == "--render-every" && i + 1 < argc)
+			renderEvery = atoi(argv[++i]);
+		else if (string(argv[i]) == "--line-reuse")
+			lineReuse = true;
+		else if (string(argv[i]) == "--line-reuse-check")
+			lineReuse = reuseCheck = true;
+		else
+			argv[kept++] = argv[i];
+	}
+	argv[kept] = NULL;
+	return kept;
+}
+
+int main(int argc, char *argv[])
+{
+	argc = stripOptions(argc, argv);
+	string mode = argc > 1 ? argv[1] : "";
+	if (mode == "--fuzz")
+		return fuzz(argc, argv);
+	if (mode == "--lockstep")
+		return lockstep(argc, argv);
+	if (mode == "--singlestep")
+		return singleStep(argc, argv);
+	if (mode == "--alu-check")
+		return aluCheck();
+	if (mode == "--headless")
+		return headless(argc, argv);
+	if (mode == "--profile")
+		return profile(argc, argv);
+	if (mode == "--stats")
+		return stats(argc, argv);
+	if (mode == "--bench")
+		return bench(argc, argv);
+	if (mode == "--cdl")
+		return cdl(argc, argv);
+	if (mode == "--cdl-merge")
+		return cdlMerge(argc, argv);
+	if (mode == "--play" || mode == "--record")
+		return movie(argc, argv);
+	if (mode == "--netplay")
+		return netplay(argc, argv);
+	if (mode == "--export")
+		return exportFrames(argc, argv);
+	if (mode == "--export-read")
+		return exportRead(argc, argv);
+	if (mode == "--disasm")
+		return disasm(argc, argv);
+	if (mode == "--disasm-verify")
+		return disasmVerify(argc, argv);
+	if (mode == "--debug" || mode == "--gdb")
+		return debug(argc, argv);
+
+	ifstream romFile;
+	openROM(romFile, argc > 1 ? argv[1] : "ROMS/snake.bin");
+	static Controller controller(romFile);
+	controller.setBusAccurate(busAccurate);
+	controller.setIdleSkip(idleSkip);
+	controller.run();
+}